@@ -1,25 +1,55 @@
 #include "gabac/binary_arithmetic_decoder.h"
 
 #include <cassert>
+#include <stdexcept>
 
 #include "gabac/bit_input_stream.h"
 #include "gabac/cabac_tables.h"
 #include "gabac/context_model.h"
 
 
+//
+// All member functions are defined inline, as this file is #include'd by
+// reader.cpp (and the unit tests) instead of being compiled separately.
+//
+
+
 namespace gabac {
 
 
-BinaryArithmeticDecoder::BinaryArithmeticDecoder(
+// Position of the least significant value bit inside the 64-bit window
+static const unsigned int VALUE_SHIFT = 40;
+
+// Refill the window as soon as fewer bits than this are left to read ahead;
+// no single renormalization step consumes more bits
+static const int MIN_LOOKAHEAD_BITS = 8;
+
+
+static inline uint64_t loadBigEndian64(
+        const unsigned char *const bytes
+){
+    return (static_cast<uint64_t>(bytes[0]) << 56u)
+           | (static_cast<uint64_t>(bytes[1]) << 48u)
+           | (static_cast<uint64_t>(bytes[2]) << 40u)
+           | (static_cast<uint64_t>(bytes[3]) << 32u)
+           | (static_cast<uint64_t>(bytes[4]) << 24u)
+           | (static_cast<uint64_t>(bytes[5]) << 16u)
+           | (static_cast<uint64_t>(bytes[6]) << 8u)
+           | (static_cast<uint64_t>(bytes[7]));
+}
+
+
+inline BinaryArithmeticDecoder::BinaryArithmeticDecoder(
         const BitInputStream& bitInputStream
 )
-        : m_bitInputStream(bitInputStream)
+        : m_bitstreamCursor(bitInputStream.getReadPointer()),
+        m_bitstreamEnd(bitInputStream.getReadPointer() + bitInputStream.getNumBytesLeft())
 {
     start();
 }
 
 
-BinaryArithmeticDecoder::~BinaryArithmeticDecoder() = default;
+inline BinaryArithmeticDecoder::~BinaryArithmeticDecoder() = default;
 
 
 inline unsigned int BinaryArithmeticDecoder::decodeBin(
@@ -30,23 +60,18 @@ inline unsigned int BinaryArithmeticDecoder::decodeBin(
     unsigned int decodedByte;
     unsigned int lps = cabactables::lpsTable[contextModel->getState()][(m_range >> 6u) - 4];
     m_range -= lps;
-    unsigned int scaledRange = m_range << 7u;
+    uint64_t scaledRange = static_cast<uint64_t>(m_range) << (VALUE_SHIFT + 7u);
     if (m_value < scaledRange)
     {
         decodedByte = contextModel->getMps();
         contextModel->updateMps();
-        if (scaledRange >= (256u << 7u))
+        if (m_range >= 256u)
         {
             return decodedByte;
         }
-        m_range = scaledRange >> 6u;
-        m_value <<= 1;
-
-        if (++m_numBitsNeeded == 0)
-        {
-            m_numBitsNeeded = -8;
-            m_value += m_bitInputStream.readByte();
-        }
+        m_range <<= 1u;
+        m_value <<= 1u;
+        m_numLookaheadBits -= 1;
     }
     else
     {
@@ -55,66 +80,54 @@ inline unsigned int BinaryArithmeticDecoder::decodeBin(
         m_range = (lps << numBits);
         decodedByte = 1 - static_cast<unsigned>(contextModel->getMps());
         contextModel->updateLps();
-        m_numBitsNeeded += numBits;
-        if (m_numBitsNeeded >= 0)
-        {
-            m_value += m_bitInputStream.readByte() << static_cast<unsigned int>(m_numBitsNeeded);
-            m_numBitsNeeded -= 8;
-        }
+        m_numLookaheadBits -= numBits;
+    }
+    if (m_numLookaheadBits < MIN_LOOKAHEAD_BITS)
+    {
+        refill();
     }
 
     return decodedByte;
 }
 
 
-unsigned int BinaryArithmeticDecoder::decodeBinsEP(
+inline unsigned int BinaryArithmeticDecoder::decodeBinsEP(
         unsigned int numBins
 ){
     unsigned int bins = 0;
-    unsigned int scaledRange;
-    while (numBins > 8)
+    while (numBins > 0)
     {
-        m_value = (m_value << 8u) + (m_bitInputStream.readByte() << (8u + m_numBitsNeeded));
-        scaledRange = m_range << 15u;
-        for (int i = 0; i < 8; i++)
+        // At least MIN_LOOKAHEAD_BITS bits are available here, so up to 8
+        // bins can be decoded directly from the lookahead bits
+        unsigned int numChunkBins = (numBins > 8) ? 8 : numBins;
+        uint64_t scaledRange = static_cast<uint64_t>(m_range) << (VALUE_SHIFT + 7u);
+        for (unsigned int i = 0; i < numChunkBins; i++)
         {
-            bins <<= 1;
-            scaledRange >>= 1;
+            bins <<= 1u;
+            scaledRange >>= 1u;
             if (m_value >= scaledRange)
             {
                 bins++;
                 m_value -= scaledRange;
             }
         }
-        numBins -= 8;
-    }
-    m_numBitsNeeded += numBins;
-    m_value <<= numBins;
-    if (m_numBitsNeeded >= 0)
-    {
-        m_value += m_bitInputStream.readByte() << static_cast<unsigned int>(m_numBitsNeeded);
-        m_numBitsNeeded -= 8;
-    }
-    scaledRange = m_range << (numBins + 7);
-    for (unsigned int i = 0; i < numBins; i++)
-    {
-        bins <<= 1;
-        scaledRange >>= 1;
-        if (m_value >= scaledRange)
+        m_value <<= numChunkBins;
+        m_numLookaheadBits -= numChunkBins;
+        if (m_numLookaheadBits < MIN_LOOKAHEAD_BITS)
         {
-            bins++;
-            m_value -= scaledRange;
+            refill();
         }
+        numBins -= numChunkBins;
     }
 
     return bins;
 }
 
 
-void BinaryArithmeticDecoder::decodeBinTrm()
+inline void BinaryArithmeticDecoder::decodeBinTrm()
 {
     m_range -= 2;
-    unsigned int scaledRange = m_range << 7u;
+    uint64_t scaledRange = static_cast<uint64_t>(m_range) << (VALUE_SHIFT + 7u);
     if (m_value >= scaledRange)
     {
         // bin = 1;
@@ -122,34 +135,75 @@ void BinaryArithmeticDecoder::decodeBinTrm()
     else
     {
         // bin = 0;
-        if (scaledRange < (256u << 7u))  // spec: ivlCurrRange < 256
+        if (m_range < 256u)  // spec: ivlCurrRange < 256
         {
-            m_range = scaledRange >> 6u;  // spec: ivlCurrRange << 1
-            m_value <<= 1;  // spec: ivlOffset = ivlOffset << 1
-            if (++m_numBitsNeeded == 0)
+            m_range <<= 1u;  // spec: ivlCurrRange << 1
+            m_value <<= 1u;  // spec: ivlOffset = ivlOffset << 1
+            m_numLookaheadBits -= 1;
+            if (m_numLookaheadBits < MIN_LOOKAHEAD_BITS)
             {
-                m_numBitsNeeded = -8;
-                m_value += m_bitInputStream.readByte();
+                refill();
             }
         }
     }
 }
 
 
-void BinaryArithmeticDecoder::reset()
+inline void BinaryArithmeticDecoder::reset()
 {
     decodeBinTrm();
 }
 
 
-void BinaryArithmeticDecoder::start()
+inline void BinaryArithmeticDecoder::start()
 {
-    assert(m_bitInputStream.getNumBitsUntilByteAligned() == 0);
-
-    m_numBitsNeeded = -8;
     m_range = 510;
-    m_value = (m_bitInputStream.readByte() << 8u);
-    m_value |= m_bitInputStream.readByte();
+    m_value = 0;
+
+    // None of the 16 value bits has been read yet. Streams shorter than two
+    // bytes (e.g. in raw mode) only fail once bits are actually consumed.
+    m_numLookaheadBits = -16;
+    fillWindow();
+}
+
+
+inline void BinaryArithmeticDecoder::refill()
+{
+    fillWindow();
+
+    // At the end of the bitstream the value bits run empty; reading a whole
+    // byte beyond the end is an error
+    if (m_numLookaheadBits <= -8)
+    {
+        throw std::out_of_range("BinaryArithmeticDecoder: read past the end of the bitstream");
+    }
+}
+
+
+inline void BinaryArithmeticDecoder::fillWindow()
+{
+    assert((m_numLookaheadBits >= -16) || (m_bitstreamCursor == m_bitstreamEnd));
+
+    if (m_bitstreamEnd - m_bitstreamCursor >= 8)
+    {
+        // Fast path: the next 8 bytes are in bounds. Any trailing bits of a
+        // partially consumed byte are identical when that byte is inserted
+        // again by the next refill.
+        auto shift = static_cast<unsigned int>(64 - static_cast<int>(VALUE_SHIFT) + m_numLookaheadBits);
+        m_value |= loadBigEndian64(m_bitstreamCursor) >> shift;
+        auto numBytes = static_cast<unsigned int>(static_cast<int>(VALUE_SHIFT) - m_numLookaheadBits) >> 3u;
+        m_bitstreamCursor += numBytes;
+        m_numLookaheadBits += 8 * numBytes;
+        return;
+    }
+
+    while ((m_numLookaheadBits <= static_cast<int>(VALUE_SHIFT) - 8) && (m_bitstreamCursor != m_bitstreamEnd))
+    {
+        auto shift = static_cast<unsigned int>(static_cast<int>(VALUE_SHIFT) - 8 - m_numLookaheadBits);
+        m_value |= static_cast<uint64_t>(*m_bitstreamCursor) << shift;
+        m_bitstreamCursor++;
+        m_numLookaheadBits += 8;
+    }
 }
 
 
@@ -2,6 +2,9 @@
 #define GABAC_BINARY_ARITHMETIC_DECODER_H_
 
 
+#include <cstddef>
+#include <cstdint>
+
 #include "gabac/bit_input_stream.h"
 #include "gabac/context_model.h"
 
@@ -33,13 +36,23 @@ class BinaryArithmeticDecoder
  private:
     void start();
 
-    BitInputStream m_bitInputStream;
+    void refill();
+
+    void fillWindow();
 
-    int m_numBitsNeeded = 0;
+    // Unread part of the borrowed bitstream
+    const unsigned char *m_bitstreamCursor = nullptr;
+
+    const unsigned char *m_bitstreamEnd = nullptr;
 
     unsigned int m_range = 0;
 
-    unsigned int m_value = 0;
+    // 64-bit window: the 16 value bits of the arithmetic decoder sit at bit
+    // positions 55..40, followed by m_numLookaheadBits bits read ahead from
+    // the bitstream
+    uint64_t m_value = 0;
+
+    int m_numLookaheadBits = 0;
 };
 
 
@@ -9,9 +9,11 @@ namespace gabac {
 
 
 BinaryArithmeticEncoder::BinaryArithmeticEncoder(
-        const BitOutputStream& bitOutputStream
+        BitOutputStream *const bitOutputStream
 )
-        : m_bitOutputStream(bitOutputStream){
+        : m_bitOutputStream(bitOutputStream),
+        m_isEstimating(false),
+        m_fracBits(0){
     start();
 }
 
@@ -26,6 +28,21 @@ inline void BinaryArithmeticEncoder::encodeBin(
     assert((bin == 0) || (bin == 1));
     assert(contextModel != nullptr);
 
+    if (m_isEstimating)
+    {
+        if (bin != contextModel->getMps())
+        {
+            m_fracBits += cabactables::fracBitsLps[contextModel->getState()];
+            contextModel->updateLps();
+        }
+        else
+        {
+            m_fracBits += cabactables::fracBitsMps[contextModel->getState()];
+            contextModel->updateMps();
+        }
+        return;
+    }
+
     unsigned int lps = cabactables::lpsTable[contextModel->getState()][(m_range >> 6u) & 3u];
     m_range -= lps;
     if (bin != contextModel->getMps())
@@ -59,6 +76,12 @@ void BinaryArithmeticEncoder::encodeBinEP(
 ){
     assert((bin == 0) || (bin == 1));
 
+    if (m_isEstimating)
+    {
+        m_fracBits += 1u << cabactables::FRAC_BITS_PRECISION;
+        return;
+    }
+
     m_low <<= 1;
     if (bin > 0)
     {
@@ -76,6 +99,12 @@ void BinaryArithmeticEncoder::encodeBinsEP(
         unsigned int bins,
         unsigned int numBins
 ){
+    if (m_isEstimating)
+    {
+        m_fracBits += uint64_t(numBins) << cabactables::FRAC_BITS_PRECISION;
+        return;
+    }
+
     while (numBins > 8)
     {
         numBins -= 8;
@@ -103,6 +132,14 @@ void BinaryArithmeticEncoder::encodeBinTrm(
         unsigned int bin
 ){
     // Encode the least-significant bit of bin as a terminating bin
+    if (m_isEstimating)
+    {
+        // A terminating 1 renormalizes the range by 7 bits, a 0 costs about
+        // nothing
+        m_fracBits += uint64_t(bin != 0 ? 7 : 0) << cabactables::FRAC_BITS_PRECISION;
+        return;
+    }
+
     m_range -= 2;
     if (bin != 0)
     {
@@ -129,82 +166,128 @@ void BinaryArithmeticEncoder::encodeBinTrm(
 
 
 void BinaryArithmeticEncoder::flush(){
+    if (m_isEstimating)
+    {
+        // The terminating bin and the stop bit, up to the next byte
+        // boundary
+        const uint64_t FINISH_BITS = 7 + 1;
+        const uint64_t BYTE = 8ull << cabactables::FRAC_BITS_PRECISION;
+        m_fracBits += FINISH_BITS << cabactables::FRAC_BITS_PRECISION;
+        m_fracBits = ((m_fracBits + BYTE - 1) / BYTE) * BYTE;
+        return;
+    }
+
     encodeBinTrm(1);
     finish();
-    m_bitOutputStream.write(1, 1);
-    m_bitOutputStream.writeAlignZero();
-    m_bitOutputStream.flush();
+    m_bitOutputStream->write(1, 1);
+    m_bitOutputStream->writeAlignZero();
+    m_bitOutputStream->flush();
     start();
 }
 
 
+void BinaryArithmeticEncoder::rewind(){
+    m_bitOutputStream->rewind();
+    m_fracBits = 0;
+    start();
+}
+
+
+void BinaryArithmeticEncoder::startEstimation(){
+    m_isEstimating = true;
+    m_fracBits = 0;
+}
+
+
+uint64_t BinaryArithmeticEncoder::getFracBits() const
+{
+    return m_fracBits;
+}
+
+
+size_t BinaryArithmeticEncoder::getNumBytesWritten() const
+{
+    if (m_isEstimating)
+    {
+        return static_cast<size_t>(m_fracBits >> (cabactables::FRAC_BITS_PRECISION + 3));
+    }
+    return m_bitOutputStream->getNumBytesWritten();
+}
+
+
 void BinaryArithmeticEncoder::start(){
     m_bufferedByte = 0xff;
     m_low = 0;
-    m_numBitsLeft = 23;
+    m_numBitsLeft = 55;
     m_numBufferedBytes = 0;
     m_range = 510;
 }
 
 
 void BinaryArithmeticEncoder::finish(){
-    if ((m_low >> (32u - m_numBitsLeft)) > 0)
+    // Emit all bytes but the last (at most 20) bits of m_low
+    writeOut();
+
+    if ((m_low >> (64u - m_numBitsLeft)) > 0)
     {
-        m_bitOutputStream.write((m_bufferedByte + 1), 8);
+        m_bitOutputStream->writeByte(static_cast<unsigned char>(m_bufferedByte + 1));
         while (m_numBufferedBytes > 1)
         {
-            m_bitOutputStream.write(0x00, 8);
+            m_bitOutputStream->writeByte(0x00);
             m_numBufferedBytes -= 1;
         }
-        m_low -= (1u << (32u - m_numBitsLeft));
+        m_low -= (1ull << (64u - m_numBitsLeft));
     }
     else
     {
         if (m_numBufferedBytes > 0)
         {
-            m_bitOutputStream.write(m_bufferedByte, 8);
+            m_bitOutputStream->writeByte(m_bufferedByte);
         }
         while (m_numBufferedBytes > 1)
         {
-            m_bitOutputStream.write(0xff, 8);
+            m_bitOutputStream->writeByte(0xff);
             m_numBufferedBytes -= 1;
         }
     }
-    m_bitOutputStream.write(m_low >> 8u, (24u - m_numBitsLeft));
+    m_bitOutputStream->write(static_cast<unsigned int>(m_low >> 8u), (56u - m_numBitsLeft));
 }
 
 
 void BinaryArithmeticEncoder::writeOut()
 {
-    unsigned int leadByte = m_low >> (24u - m_numBitsLeft);
-    m_numBitsLeft += 8;
-    m_low &= 0xffffffffu >> m_numBitsLeft;
-    if (leadByte == 0xff)
-    {
-        m_numBufferedBytes += 1;
-    }
-    else
+    while (m_numBitsLeft < 44)
     {
-        if (m_numBufferedBytes > 0)
+        auto leadByte = static_cast<unsigned int>(m_low >> (56u - m_numBitsLeft));
+        m_numBitsLeft += 8;
+        m_low &= 0xffffffffffffffffull >> m_numBitsLeft;
+        if (leadByte == 0xff)
         {
-            auto carry = static_cast<unsigned char>(leadByte >> 8u);
-            unsigned char byte = m_bufferedByte + carry;
+            m_numBufferedBytes += 1;
+        }
+        else
+        {
+            if (m_numBufferedBytes > 0)
+            {
+                auto carry = static_cast<unsigned char>(leadByte >> 8u);
+                unsigned char byte = m_bufferedByte + carry;
 
-            m_bufferedByte = static_cast<unsigned char>(leadByte & 0xffu);
-            m_bitOutputStream.write(byte, 8);
+                m_bufferedByte = static_cast<unsigned char>(leadByte & 0xffu);
+                m_bitOutputStream->writeByte(byte);
 
-            byte = static_cast<unsigned char>(0xff) + carry;
-            while (m_numBufferedBytes > 1)
+                byte = static_cast<unsigned char>(0xff) + carry;
+                while (m_numBufferedBytes > 1)
+                {
+                    m_bitOutputStream->writeByte(byte);
+                    m_numBufferedBytes -= 1;
+                }
+            }
+            else
             {
-                m_bitOutputStream.write(byte, 8);
-                m_numBufferedBytes -= 1;
+                m_numBufferedBytes = 1;
+                m_bufferedByte = static_cast<unsigned char>(leadByte & 0xffu);
             }
         }
-        else
-        {
-            m_numBufferedBytes = 1;
-            m_bufferedByte = static_cast<unsigned char>(leadByte & 0xffu);
-        }
     }
 }
 
@@ -2,6 +2,9 @@
 #define GABAC_BINARY_ARITHMETIC_ENCODER_H_
 
 
+#include <cstddef>
+#include <cstdint>
+
 #include "gabac/bit_output_stream.h"
 #include "gabac/context_model.h"
 
@@ -12,8 +15,10 @@ namespace gabac {
 class BinaryArithmeticEncoder
 {
  public:
+    // The bit output stream is owned by the caller and must outlive the
+    // encoder
     explicit BinaryArithmeticEncoder(
-            const BitOutputStream& bitOutputStream
+            BitOutputStream *bitOutputStream
     );
 
     ~BinaryArithmeticEncoder();
@@ -38,6 +43,19 @@ class BinaryArithmeticEncoder
 
     void flush();
 
+    // Discards the output and starts over with a fresh coder state
+    void rewind();
+
+    // Estimation mode: no output is written, instead the costs of the bins
+    // are summed up in units of 2^-cabactables::FRAC_BITS_PRECISION bits
+    void startEstimation();
+
+    uint64_t getFracBits() const;
+
+    // Bytes written (or estimated) so far; a few bytes are still held back
+    // in the coder state
+    size_t getNumBytesWritten() const;
+
  private:
     void finish();
 
@@ -45,17 +63,23 @@ class BinaryArithmeticEncoder
 
     void writeOut();
 
-    BitOutputStream m_bitOutputStream;
+    BitOutputStream *m_bitOutputStream;
 
     unsigned char m_bufferedByte;
 
-    unsigned int m_low;
+    // 64 bits wide, so that several output bytes are batched between two
+    // calls to writeOut()
+    uint64_t m_low;
 
     unsigned int m_numBitsLeft;
 
     int m_numBufferedBytes;
 
     unsigned int m_range;
+
+    bool m_isEstimating;
+
+    uint64_t m_fracBits;
 };
 
 
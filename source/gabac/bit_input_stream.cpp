@@ -2,6 +2,7 @@
 
 #include <cassert>
 #include <limits>
+#include <stdexcept>
 #include <vector>
 
 
@@ -9,23 +10,37 @@ namespace gabac {
 
 
 static unsigned char readIn(
-        const std::vector<unsigned char>& bitstream,
+        const unsigned char *const bitstream,
+        size_t bitstreamSize,
         size_t *const bitstreamIndex
 ){
-    unsigned char byte = bitstream.at(*bitstreamIndex);
+    if (*bitstreamIndex >= bitstreamSize)
+    {
+        throw std::out_of_range("BitInputStream: read past the end of the bitstream");
+    }
+    unsigned char byte = bitstream[*bitstreamIndex];
     (*bitstreamIndex)++;
     return byte;
 }
 
 
 BitInputStream::BitInputStream(
-        const std::vector<unsigned char>& bitstream
+        const unsigned char *const bitstream,
+        size_t bitstreamSize
 )
-        : m_bitstream(bitstream), m_heldBits(0), m_numHeldBits(0){
+        : m_bitstream(bitstream), m_bitstreamSize(bitstreamSize), m_heldBits(0), m_numHeldBits(0){
+    assert(bitstream != nullptr || bitstreamSize == 0);
     reset();
 }
 
 
+BitInputStream::BitInputStream(
+        const std::vector<unsigned char>& bitstream
+)
+        : BitInputStream(bitstream.data(), bitstream.size()){
+}
+
+
 BitInputStream::~BitInputStream() = default;
 
 
@@ -48,6 +63,18 @@ void BitInputStream::reset(){
 }
 
 
+const unsigned char *BitInputStream::getReadPointer() const{
+    assert(m_numHeldBits == 0);
+    return m_bitstream + m_bitstreamIndex;
+}
+
+
+size_t BitInputStream::getNumBytesLeft() const{
+    assert(m_numHeldBits == 0);
+    return m_bitstreamSize - m_bitstreamIndex;
+}
+
+
 unsigned int BitInputStream::read(
         unsigned int numBits
 ){
@@ -75,19 +102,19 @@ unsigned int BitInputStream::read(
     {
         case 4:
         {
-            alignedWord |= (readIn(m_bitstream, &m_bitstreamIndex) << 24u);
+            alignedWord |= (readIn(m_bitstream, m_bitstreamSize, &m_bitstreamIndex) << 24u);
         }  // fall-through
         case 3:
         {
-            alignedWord |= (readIn(m_bitstream, &m_bitstreamIndex) << 16u);
+            alignedWord |= (readIn(m_bitstream, m_bitstreamSize, &m_bitstreamIndex) << 16u);
         }  // fall-through
         case 2:
         {
-            alignedWord |= (readIn(m_bitstream, &m_bitstreamIndex) << 8u);
+            alignedWord |= (readIn(m_bitstream, m_bitstreamSize, &m_bitstreamIndex) << 8u);
         }  // fall-through
         case 1:
         {
-            alignedWord |= (readIn(m_bitstream, &m_bitstreamIndex));
+            alignedWord |= (readIn(m_bitstream, m_bitstreamSize, &m_bitstreamIndex));
         }  // fall-through
         default:
         {
@@ -13,6 +13,12 @@ namespace gabac {
 class BitInputStream
 {
  public:
+    // The stream only borrows the buffer, which must outlive it
+    BitInputStream(
+            const unsigned char *bitstream,
+            size_t bitstreamSize
+    );
+
     explicit BitInputStream(
             const std::vector<unsigned char>& bitstream
     );
@@ -25,12 +31,20 @@ class BitInputStream
 
     void reset();
 
+    // Unread, byte-aligned part of the bitstream, for readers which do
+    // their own buffering
+    const unsigned char *getReadPointer() const;
+
+    size_t getNumBytesLeft() const;
+
  private:
     unsigned int read(
             unsigned int numBits
     );
 
-    std::vector<unsigned char> m_bitstream;
+    const unsigned char *m_bitstream;
+
+    size_t m_bitstreamSize;
 
     size_t m_bitstreamIndex;
 
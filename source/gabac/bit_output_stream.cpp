@@ -1,5 +1,6 @@
 #include "gabac/bit_output_stream.h"
 
+#include <algorithm>
 #include <cassert>
 #include <vector>
 
@@ -7,19 +8,17 @@
 namespace gabac {
 
 
-static void writeOut(
-        unsigned char byte,
-        std::vector<unsigned char> *const bitstream
-){
-    bitstream->push_back(byte);
-}
+// Minimum number of bytes by which the bitstream is grown at once
+static const size_t MIN_GROW_SIZE = 4096;
 
 
 BitOutputStream::BitOutputStream(
         std::vector<unsigned char> *const bitstream
 )
         : m_bitstream(bitstream), m_heldBits(0), m_numHeldBits(0){
-    // Nothing to do here
+    assert(bitstream != nullptr);
+    m_writePointer = m_bitstream->data() + m_bitstream->size();
+    m_bufferEnd = m_writePointer;
 }
 
 
@@ -28,6 +27,26 @@ BitOutputStream::~BitOutputStream() = default;
 
 void BitOutputStream::flush(){
     writeAlignZero();
+    m_bitstream->resize(static_cast<size_t>(m_writePointer - m_bitstream->data()));
+    m_writePointer = m_bitstream->data() + m_bitstream->size();
+    m_bufferEnd = m_writePointer;
+}
+
+
+void BitOutputStream::rewind(){
+    m_bitstream->clear();
+    m_writePointer = m_bitstream->data();
+    m_bufferEnd = m_writePointer;
+    m_heldBits = 0;
+    m_numHeldBits = 0;
+}
+
+
+void BitOutputStream::growBuffer(){
+    auto numBytesWritten = static_cast<size_t>(m_writePointer - m_bitstream->data());
+    m_bitstream->resize(std::max(2 * m_bitstream->size(), numBytesWritten + MIN_GROW_SIZE));
+    m_writePointer = m_bitstream->data() + numBytesWritten;
+    m_bufferEnd = m_bitstream->data() + m_bitstream->size();
 }
 
 
@@ -69,19 +88,19 @@ void BitOutputStream::write(
     {
         case 4:
         {
-            writeOut(static_cast<unsigned char> ((writeBits >> 24u) & 0xffu), m_bitstream);
+            putByte(static_cast<unsigned char> ((writeBits >> 24u) & 0xffu));
         }  // fall-through
         case 3:
         {
-            writeOut(static_cast<unsigned char> ((writeBits >> 16u) & 0xffu), m_bitstream);
+            putByte(static_cast<unsigned char> ((writeBits >> 16u) & 0xffu));
         }  // fall-through
         case 2:
         {
-            writeOut(static_cast<unsigned char> ((writeBits >> 8u) & 0xffu), m_bitstream);
+            putByte(static_cast<unsigned char> ((writeBits >> 8u) & 0xffu));
         }  // fall-through
         case 1:
         {
-            writeOut(static_cast<unsigned char> (writeBits & 0xffu), m_bitstream);
+            putByte(static_cast<unsigned char> (writeBits & 0xffu));
         }  // fall-through
         default:
         {
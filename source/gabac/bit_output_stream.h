@@ -2,6 +2,8 @@
 #define GABAC_BIT_OUTPUT_STREAM_H_
 
 
+#include <cassert>
+#include <cstddef>
 #include <vector>
 
 
@@ -19,6 +21,10 @@ class BitOutputStream
 
     void flush();
 
+    // Discards everything written so far; the capacity of the bitstream is
+    // kept for reuse
+    void rewind();
+
     void write(
             unsigned int bits,
             unsigned int numBits
@@ -26,9 +32,42 @@ class BitOutputStream
 
     void writeAlignZero();
 
+    // Number of whole bytes written so far
+    size_t getNumBytesWritten() const
+    {
+        return static_cast<size_t>(m_writePointer - m_bitstream->data());
+    }
+
+    // Fast path for byte-aligned output (the arithmetic coder only ever
+    // writes whole bytes until the final flush)
+    void writeByte(
+            unsigned char byte
+    ){
+        assert(m_numHeldBits == 0);
+        putByte(byte);
+    }
+
  private:
+    void putByte(
+            unsigned char byte
+    ){
+        if (m_writePointer == m_bufferEnd)
+        {
+            growBuffer();
+        }
+        *(m_writePointer++) = byte;
+    }
+
+    void growBuffer();
+
+    // The bitstream is resized ahead of the written data and trimmed to the
+    // written size by flush()
     std::vector<unsigned char> *m_bitstream;
 
+    unsigned char *m_writePointer;
+
+    unsigned char *m_bufferEnd;
+
     unsigned char m_heldBits;
 
     unsigned int m_numHeldBits;
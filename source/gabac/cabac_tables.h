@@ -111,6 +111,33 @@ const std::vector<unsigned char> nextStateMps = {
 };
 
 
+// Cost of coding a bin in a context of the given state as its MPS resp. its
+// LPS, in units of 2^-FRAC_BITS_PRECISION bits: -log2(p) of the probability
+// the state stands for
+const unsigned int FRAC_BITS_PRECISION = 15;
+
+
+const std::vector<unsigned int> fracBitsMps = {
+        32768, 30426, 28306, 26377, 24617, 23005, 21523, 20159, 18899, 17734,
+        16653, 15650, 14717, 13849, 13038, 12282, 11575, 10914, 10294, 9714,
+        9169, 8658, 8178, 7727, 7303, 6903, 6527, 6173, 5840, 5525, 5228, 4948,
+        4684, 4435, 4199, 3977, 3767, 3568, 3380, 3202, 3034, 2876, 2725, 2583,
+        2448, 2321, 2200, 2086, 1978, 1875, 1778, 1686, 1599, 1517, 1439, 1364,
+        1294, 1228, 1164, 1105, 1048, 994, 943, 895
+};
+
+
+const std::vector<unsigned int> fracBitsLps = {
+        32768, 35232, 37696, 40159, 42623, 45087, 47551, 50015, 52479, 54942,
+        57406, 59870, 62334, 64798, 67262, 69725, 72189, 74653, 77117, 79581,
+        82044, 84508, 86972, 89436, 91900, 94364, 96827, 99291, 101755, 104219,
+        106683, 109147, 111610, 114074, 116538, 119002, 121466, 123929, 126393,
+        128857, 131321, 133785, 136249, 138712, 141176, 143640, 146104, 148568,
+        151032, 153495, 155959, 158423, 160887, 163351, 165814, 168278, 170742,
+        173206, 175670, 178134, 180597, 183061, 185525, 187989
+};
+
+
 }  // namespace cabactables
 }  // namespace gabac
 
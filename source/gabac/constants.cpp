@@ -101,141 +101,268 @@ const std::vector<BinarizationProperties> binarizationInformation = {
 
 //------------------------------------------------------------------------------
 
+// Each coding implements transform() and inverseTransform() for the symbol
+// types of all word sizes; the transformed sequences are set up with the
+// word sizes from transformationInformation before transform() is called
+
+struct NoTransform
+{
+    template<typename T>
+    static void transform(
+            const std::vector<T>& sequence,
+            uint64_t,
+            std::vector<SymbolStream> *const transformedSequences
+    ){
+        (*transformedSequences)[0].get<T>() = sequence;
+    }
+
+    template<typename T>
+    static void inverseTransform(
+            const std::vector<SymbolStream>& transformedSequences,
+            uint64_t,
+            std::vector<T> *const sequence
+    ){
+        *sequence = transformedSequences[0].get<T>();
+    }
+};
+
+struct EqualityCoding
+{
+    template<typename T>
+    static void transform(
+            const std::vector<T>& sequence,
+            uint64_t,
+            std::vector<SymbolStream> *const transformedSequences
+    ){
+        gabac::transformEqualityCoding(
+                sequence,
+                &(*transformedSequences)[0].get<uint8_t>(),
+                &(*transformedSequences)[1].get<T>()
+        );
+    }
+
+    template<typename T>
+    static void inverseTransform(
+            const std::vector<SymbolStream>& transformedSequences,
+            uint64_t,
+            std::vector<T> *const sequence
+    ){
+        gabac::inverseTransformEqualityCoding(
+                transformedSequences[0].get<uint8_t>(),
+                transformedSequences[1].get<T>(),
+                sequence
+        );
+    }
+};
+
+struct MatchCoding
+{
+    template<typename T>
+    static void transform(
+            const std::vector<T>& sequence,
+            uint64_t param,
+            std::vector<SymbolStream> *const transformedSequences
+    ){
+        assert(param <= std::numeric_limits<uint32_t>::max());
+        gabac::transformMatchCoding(
+                sequence,
+                static_cast<uint32_t>(param),
+                &(*transformedSequences)[0].get<uint32_t>(),
+                &(*transformedSequences)[1].get<uint32_t>(),
+                &(*transformedSequences)[2].get<T>()
+        );
+    }
+
+    template<typename T>
+    static void inverseTransform(
+            const std::vector<SymbolStream>& transformedSequences,
+            uint64_t,
+            std::vector<T> *const sequence
+    ){
+        gabac::inverseTransformMatchCoding(
+                transformedSequences[0].get<uint32_t>(),
+                transformedSequences[1].get<uint32_t>(),
+                transformedSequences[2].get<T>(),
+                sequence
+        );
+    }
+};
+
+struct RleCoding
+{
+    template<typename T>
+    static void transform(
+            const std::vector<T>& sequence,
+            uint64_t param,
+            std::vector<SymbolStream> *const transformedSequences
+    ){
+        gabac::transformRleCoding(
+                sequence,
+                param,
+                &(*transformedSequences)[0].get<T>(),
+                &(*transformedSequences)[1].get<uint32_t>()
+        );
+    }
+
+    template<typename T>
+    static void inverseTransform(
+            const std::vector<SymbolStream>& transformedSequences,
+            uint64_t param,
+            std::vector<T> *const sequence
+    ){
+        gabac::inverseTransformRleCoding(
+                transformedSequences[0].get<T>(),
+                transformedSequences[1].get<uint32_t>(),
+                param,
+                sequence
+        );
+    }
+};
+
+struct LutCoding
+{
+    template<typename T>
+    static void transform(
+            const std::vector<T>& sequence,
+            uint64_t param,
+            std::vector<SymbolStream> *const transformedSequences
+    ){
+        gabac::transformLutTransform(
+                static_cast<unsigned int>(param),
+                sequence,
+                0,
+                &(*transformedSequences)[0].get<T>(),
+                &(*transformedSequences)[1].get<T>(),
+                &(*transformedSequences)[2].get<uint32_t>(),
+                &(*transformedSequences)[3].get<T>()
+        );
+    }
+
+    template<typename T>
+    static void inverseTransform(
+            const std::vector<SymbolStream>& transformedSequences,
+            uint64_t param,
+            std::vector<T> *const sequence
+    ){
+        gabac::inverseTransformLutTransform(
+                static_cast<unsigned int>(param),
+                transformedSequences[0].get<T>(),
+                transformedSequences[1].get<T>(),
+                transformedSequences[2].get<uint32_t>(),
+                transformedSequences[3].get<T>(),
+                sequence
+        );
+    }
+};
+
+//------------------------------------------------------------------------------
+
+template<typename Coding, unsigned int transformationIndex>
+static void forwardTransform(
+        const SymbolStream& sequence,
+        uint64_t param,
+        std::vector<SymbolStream> *const transformedSequences
+){
+    transformedSequences->clear();
+    for (const auto& wordSize : fixWordSizes(
+            transformationInformation[transformationIndex].wordsizes,
+            sequence.getWordSize()
+    ))
+    {
+        transformedSequences->emplace_back(wordSize);
+    }
+
+    switch (sequence.getWordSize())
+    {
+        case 1:
+            Coding::transform(sequence.get<uint8_t>(), param, transformedSequences);
+            break;
+        case 2:
+            Coding::transform(sequence.get<uint16_t>(), param, transformedSequences);
+            break;
+        case 4:
+            Coding::transform(sequence.get<uint32_t>(), param, transformedSequences);
+            break;
+        default:
+            Coding::transform(sequence.get<uint64_t>(), param, transformedSequences);
+            break;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template<typename Coding>
+static void inverseTransform(
+        const std::vector<SymbolStream>& transformedSequences,
+        uint64_t param,
+        SymbolStream *const sequence
+){
+    switch (sequence->getWordSize())
+    {
+        case 1:
+            Coding::inverseTransform(transformedSequences, param, &sequence->get<uint8_t>());
+            break;
+        case 2:
+            Coding::inverseTransform(transformedSequences, param, &sequence->get<uint16_t>());
+            break;
+        case 4:
+            Coding::inverseTransform(transformedSequences, param, &sequence->get<uint32_t>());
+            break;
+        default:
+            Coding::inverseTransform(transformedSequences, param, &sequence->get<uint64_t>());
+            break;
+    }
+}
+
+//------------------------------------------------------------------------------
+
 const std::vector<TransformationProperties> transformationInformation = {
         {
                 "no_transform", // Name
                 {"out"}, // StreamNames
                 {0}, // WordSizes (0: non fixed current stream wordsize)
-                [](const std::vector<uint64_t>& sequence, uint64_t,
-                   std::vector<std::vector<uint64_t>> *const transformedSequences
-                )
-                {
-                    (*transformedSequences)[0] = sequence;
-                },
-                [](const std::vector<std::vector<uint64_t>>& transformedSequences, uint64_t,
-                   std::vector<uint64_t> *const sequence
-                )
-                {
-                    *sequence = transformedSequences[0];
-                }
+                forwardTransform<NoTransform, 0>,
+                inverseTransform<NoTransform>
         },
         {
                 "equality_coding", // Name
                 {"eq_flags",   "raw_symbols"}, // StreamNames
                 {1, 0}, // WordSizes (0: non fixed current stream wordsize)
-                [](const std::vector<uint64_t>& sequence, uint64_t,
-                   std::vector<std::vector<uint64_t>> *const transformedSequences
-                )
-                {
-                    gabac::transformEqualityCoding(
-                            sequence,
-                            &(*transformedSequences)[0],
-                            &(*transformedSequences)[1]
-                    );
-                },
-                [](const std::vector<std::vector<uint64_t>>& transformedSequences, uint64_t,
-                   std::vector<uint64_t> *const sequence
-                )
-                {
-                    gabac::inverseTransformEqualityCoding(
-                            transformedSequences[0],
-                            transformedSequences[1],
-                            sequence
-                    );
-                }
+                forwardTransform<EqualityCoding, 1>,
+                inverseTransform<EqualityCoding>
         },
         {
                 "match_coding", // Name
                 {"pointers",   "lengths", "raw_values"}, // StreamNames
                 {4, 4, 0}, // WordSizes (0: non fixed current stream wordsize)
-                [](const std::vector<uint64_t>& sequence, uint64_t param,
-                   std::vector<std::vector<uint64_t>> *const transformedSequences
-                )
-                {
-                    assert(param <= std::numeric_limits<uint32_t>::max());
-                    gabac::transformMatchCoding(
-                            sequence,
-                            static_cast<uint32_t>(param),
-                            &(*transformedSequences)[0],
-                            &(*transformedSequences)[1],
-                            &(*transformedSequences)[2]
-                    );
-                },
-                [](const std::vector<std::vector<uint64_t>>& transformedSequences, uint64_t,
-                   std::vector<uint64_t> *const sequence
-                )
-                {
-                    gabac::inverseTransformMatchCoding(
-                            transformedSequences[0],
-                            transformedSequences[1],
-                            transformedSequences[2],
-                            sequence
-                    );
-                }
+                forwardTransform<MatchCoding, 2>,
+                inverseTransform<MatchCoding>
         },
         {
                 "rle_coding", // Name
                 {"raw_values", "lengths"}, // StreamNames
                 {0, 4}, // WordSizes (0: non fixed current stream wordsize)
-                [](const std::vector<uint64_t>& sequence, uint64_t param,
-                   std::vector<std::vector<uint64_t>> *const transformedSequences
-                )
-                {
-                    gabac::transformRleCoding(
-                            sequence,
-                            param,
-                            &(*transformedSequences)[0],
-                            &(*transformedSequences)[1]
-                    );
-                },
-                [](const std::vector<std::vector<uint64_t>>& transformedSequences, uint64_t param,
-                   std::vector<uint64_t> *const sequence
-                )
-                {
-                    gabac::inverseTransformRleCoding(
-                            transformedSequences[0],
-                            transformedSequences[1],
-                            param,
-                            sequence
-                    );
-                }
+                forwardTransform<RleCoding, 3>,
+                inverseTransform<RleCoding>
         },
         {
                 "lut_coding", // Name
-                {"sequence",   "lut"}, // StreamNames
-                {0, 0}, // WordSizes (0: non fixed current stream wordsize)
-                [](const std::vector<uint64_t>& sequence, uint64_t,
-                   std::vector<std::vector<uint64_t>> *const transformedSequences
-                )
-                {
-                    gabac::transformLutTransform0(
-                            sequence,
-                            &(*transformedSequences)[0],
-                            &(*transformedSequences)[1]
-                    );
-                },
-                [](const std::vector<std::vector<uint64_t>>& transformedSequences, uint64_t,
-                   std::vector<uint64_t> *const sequence
-                )
-                {
-                    gabac::inverseTransformLutTransform0(
-                            transformedSequences[0],
-                            transformedSequences[1],
-                            sequence
-                    );
-                }
+                {"sequence",   "lut", "lut_higher_order", "lut_escapes"}, // StreamNames
+                {0, 0, 4, 0}, // WordSizes (0: non fixed current stream wordsize)
+                forwardTransform<LutCoding, 4>,
+                inverseTransform<LutCoding>
         },
         {
                 "diff_coding", // Name
                 {"sequence"}, // StreamNames
                 {0}, // WordSizes (0: non fixed current stream wordsize)
-                [](const std::vector<uint64_t>&, uint64_t,
-                   std::vector<std::vector<uint64_t>> *const
+                [](const SymbolStream&, uint64_t,
+                   std::vector<SymbolStream> *const
                 )
                 {
                 },
-                [](const std::vector<std::vector<uint64_t>>&, uint64_t,
-                   std::vector<uint64_t> *const
+                [](const std::vector<SymbolStream>&, uint64_t,
+                   SymbolStream *const
                 )
                 {
                 }
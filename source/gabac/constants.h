@@ -8,6 +8,8 @@
 #include <vector>
 #include <string>
 
+#include "gabac/symbol_stream.h"
+
 namespace gabac {
 
 
@@ -45,18 +47,22 @@ enum class ContextSelectionId
     bypass = 0,
     adaptive_coding_order_0 = 1,
     adaptive_coding_order_1 = 2,
-    adaptive_coding_order_2 = 3
+    adaptive_coding_order_2 = 3,
+    raw = 4  /** Bypass bins bit-packed without arithmetic coding */
 };
 
 #ifdef __cplusplus
 
 
-using SequenceTransform = std::function<void(const std::vector<uint64_t>& sequence, const uint64_t param,
-                                             std::vector<std::vector<uint64_t>> *const
+// The transformed sequences get the word sizes listed in the
+// TransformationProperties; the inverse transform produces a sequence of
+// the word size which the output stream was constructed with
+using SequenceTransform = std::function<void(const SymbolStream& sequence, const uint64_t param,
+                                             std::vector<SymbolStream> *const
 )>;
 
-using InverseSequenceTransform = std::function<void(const std::vector<std::vector<uint64_t>>&, const uint64_t,
-                                                    std::vector<uint64_t> *const
+using InverseSequenceTransform = std::function<void(const std::vector<SymbolStream>&, const uint64_t,
+                                                    SymbolStream *const
 )>;
 
 using SignedBinarizationCheck = std::function<bool(int64_t min, int64_t max, uint64_t parameter
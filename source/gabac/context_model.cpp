@@ -18,8 +18,5 @@ ContextModel::ContextModel(
 }
 
 
-ContextModel::~ContextModel() = default;
-
-
 
 }  // namespace gabac
@@ -13,7 +13,7 @@ class ContextModel
             unsigned char state
     );
 
-    ~ContextModel();
+    ~ContextModel() = default;
 
     unsigned char getState() const { return m_state >> 1; }
 
@@ -4,6 +4,7 @@
 #include "gabac/context_tables.h"
 
 #include <cassert>
+#include <cstdint>
 
 
 namespace gabac {
@@ -57,6 +58,15 @@ class ContextSelector
                 + binIdx
         );
     }
+
+    // Maps a coded symbol to the value which is used to select the context
+    // set for the following symbol(s) in the adaptive order-1/2 modes
+    static unsigned int getContextHistoryValue(
+            int64_t symbol
+    ) {
+        uint64_t magnitude = (symbol < 0) ? (0 - static_cast<uint64_t>(symbol)) : static_cast<uint64_t>(symbol);
+        return (magnitude > 3) ? 3u : static_cast<unsigned int>(magnitude);
+    }
 };
 
 
@@ -1,6 +1,8 @@
 #include "gabac/context_tables.h"
 
 #include <cassert>
+#include <cstring>
+#include <type_traits>
 #include <vector>
 
 
@@ -8,9 +10,10 @@ namespace gabac {
 namespace contexttables {
 
 
-std::vector<ContextModel> buildContextTable()
+static std::vector<ContextModel> buildInitialContextTable()
 {
     std::vector<ContextModel> contextModels;
+    contextModels.reserve(NUM_CONTEXTS);
 
     for (const auto& contextSet : INIT_TRUNCATED_UNARY_CTX)
     {
@@ -39,9 +42,35 @@ std::vector<ContextModel> buildContextTable()
         }
     }
 
+    assert(contextModels.size() == NUM_CONTEXTS);
     return contextModels;
 }
 
 
+// Built once, on first use
+static const std::vector<ContextModel>& getInitialContextTable()
+{
+    static const std::vector<ContextModel> initialContextModels = buildInitialContextTable();
+    return initialContextModels;
+}
+
+
+std::vector<ContextModel> buildContextTable()
+{
+    return getInitialContextTable();
+}
+
+
+void resetContextTable(
+        std::vector<ContextModel> *const contextModels
+){
+    static_assert(std::is_trivially_copyable<ContextModel>::value, "ContextModel must be copyable with memcpy");
+    assert(contextModels != nullptr);
+    assert(contextModels->size() == NUM_CONTEXTS);
+
+    std::memcpy(contextModels->data(), getInitialContextTable().data(), NUM_CONTEXTS * sizeof(ContextModel));
+}
+
+
 }  // namespace contexttables
 }  // namespace gabac
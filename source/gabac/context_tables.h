@@ -27,6 +27,8 @@ const int OFFSET_EXPONENTIAL_GOLOMB_0 = OFFSET_TRUNCATED_UNARY_0 + (64 * CONTEXT
 
 const int OFFSET_BINARY_0 = OFFSET_EXPONENTIAL_GOLOMB_0 + (16 * CONTEXT_SET_LENGTH);
 
+const int NUM_CONTEXTS = OFFSET_BINARY_0 + (16 * CONTEXT_SET_LENGTH);
+
 // 64 rows, 32 columns, filled with 64
 const std::vector<std::vector<unsigned char>> INIT_TRUNCATED_UNARY_CTX(64, std::vector<unsigned char>(32, 64));
 
@@ -39,6 +41,12 @@ const std::vector<std::vector<unsigned char>> INIT_BINARY_CTX(16, std::vector<un
 
 std::vector<ContextModel> buildContextTable();
 
+// Resets a table built by buildContextTable() to the initial states; this is
+// a plain copy from a static image of the initial table
+void resetContextTable(
+        std::vector<ContextModel> *contextModels
+);
+
 
 }  // namespace contexttables
 }  // namespace gabac
@@ -2,7 +2,10 @@
 
 #include <algorithm>
 #include <cassert>
+#include <exception>
 #include <limits>
+#include <system_error>
+#include <thread>
 
 #include "gabac/constants.h"
 #include "gabac/reader.h"
@@ -28,7 +31,7 @@ int gabac_decode(
     {
         return GABAC_FAILURE;
     }
-    if (binarizationParameters == nullptr)
+    if (binarizationParameters == nullptr && binarizationParametersSize > 0)
     {
         return GABAC_FAILURE;
     }
@@ -41,11 +44,8 @@ int gabac_decode(
         return GABAC_FAILURE;
     }
 
-    // C++-style vectors to receive input data / accumulate output data
-    std::vector<unsigned char> bitstreamVector(
-            bitstream,
-            (bitstream + bitstreamSize)
-    );
+    // C++-style vectors to receive input data / accumulate output data; the
+    // bitstream itself is read in place
     std::vector<unsigned int> binarizationParametersVector(
             binarizationParameters,
             (binarizationParameters + binarizationParametersSize)
@@ -53,11 +53,12 @@ int gabac_decode(
     std::vector<int64_t> symbolsVector;
 
     assert(binarizationId <= static_cast<int>(gabac::BinarizationId::STEG));
-    assert(contextSelectionId <= static_cast<int>(gabac::ContextSelectionId::adaptive_coding_order_2));
+    assert(contextSelectionId <= static_cast<int>(gabac::ContextSelectionId::raw));
 
     // Execute
     int rc = gabac::decode(
-            bitstreamVector,
+            bitstream,
+            bitstreamSize,
             static_cast<gabac::BinarizationId>(binarizationId),
             binarizationParametersVector,
             static_cast<gabac::ContextSelectionId>(contextSelectionId),
@@ -77,6 +78,214 @@ int gabac_decode(
 }
 
 
+int gabac_decode_size(
+        const unsigned char *const bitstream,
+        size_t bitstreamSize,
+        unsigned int contextSelectionId,
+        size_t *const symbolsSize
+){
+    if (symbolsSize == nullptr)
+    {
+        return GABAC_FAILURE;
+    }
+
+    try
+    {
+        return gabac::decodeNumSymbols(
+                bitstream,
+                bitstreamSize,
+                static_cast<gabac::ContextSelectionId>(contextSelectionId),
+                symbolsSize
+        );
+    }
+    catch (...)
+    {
+        return GABAC_FAILURE;
+    }
+}
+
+
+int gabac_decode_into(
+        const unsigned char *const bitstream,
+        size_t bitstreamSize,
+        unsigned int binarizationId,
+        unsigned int *const binarizationParameters,
+        size_t binarizationParametersSize,
+        unsigned int contextSelectionId,
+        int64_t *const symbols,
+        size_t symbolsCapacity,
+        size_t *const symbolsSize
+){
+    if (binarizationParameters == nullptr && binarizationParametersSize > 0)
+    {
+        return GABAC_FAILURE;
+    }
+    if (symbolsSize == nullptr)
+    {
+        return GABAC_FAILURE;
+    }
+
+    std::vector<unsigned int> binarizationParametersVector(
+            binarizationParameters,
+            (binarizationParameters + binarizationParametersSize)
+    );
+
+    try
+    {
+        return gabac::decode(
+                bitstream,
+                bitstreamSize,
+                static_cast<gabac::BinarizationId>(binarizationId),
+                binarizationParametersVector,
+                static_cast<gabac::ContextSelectionId>(contextSelectionId),
+                symbols,
+                symbolsCapacity,
+                symbolsSize
+        );
+    }
+    catch (...)
+    {
+        return GABAC_FAILURE;
+    }
+}
+
+
+int gabac_decode_blocks(
+        unsigned char *const bitstream,
+        size_t bitstreamSize,
+        unsigned int binarizationId,
+        unsigned int *const binarizationParameters,
+        size_t binarizationParametersSize,
+        unsigned int contextSelectionId,
+        unsigned int numThreads,
+        int64_t **const symbols,
+        size_t *const symbolsSize
+){
+    if (bitstream == nullptr)
+    {
+        return GABAC_FAILURE;
+    }
+    if (binarizationParameters == nullptr && binarizationParametersSize > 0)
+    {
+        return GABAC_FAILURE;
+    }
+    if (symbols == nullptr)
+    {
+        return GABAC_FAILURE;
+    }
+    if (symbolsSize == nullptr)
+    {
+        return GABAC_FAILURE;
+    }
+
+    try
+    {
+        // C++-style vectors to receive input data / accumulate output data; the
+        // bitstream itself is read in place
+        std::vector<unsigned int> binarizationParametersVector(
+                binarizationParameters,
+                (binarizationParameters + binarizationParametersSize)
+        );
+        std::vector<int64_t> symbolsVector;
+
+        // Execute
+        int rc = gabac::decodeBlocks(
+                bitstream,
+                bitstreamSize,
+                static_cast<gabac::BinarizationId>(binarizationId),
+                binarizationParametersVector,
+                static_cast<gabac::ContextSelectionId>(contextSelectionId),
+                numThreads,
+                &symbolsVector
+        );
+        if (rc != GABAC_SUCCESS)
+        {
+            return GABAC_FAILURE;
+        }
+
+        // Extract plain C array data from result vectors
+        *symbolsSize = symbolsVector.size();
+        *symbols = static_cast<int64_t*>(malloc(sizeof(int64_t) * (*symbolsSize)));
+        std::copy(symbolsVector.begin(), symbolsVector.end(), *symbols);
+
+        return GABAC_SUCCESS;
+    }
+    catch (...)
+    {
+        return GABAC_FAILURE;
+    }
+}
+
+
+int gabac_decode_range(
+        unsigned char *const bitstream,
+        size_t bitstreamSize,
+        size_t firstSymbol,
+        size_t numSymbols,
+        unsigned int binarizationId,
+        unsigned int *const binarizationParameters,
+        size_t binarizationParametersSize,
+        unsigned int contextSelectionId,
+        int64_t **const symbols,
+        size_t *const symbolsSize
+){
+    if (bitstream == nullptr)
+    {
+        return GABAC_FAILURE;
+    }
+    if (binarizationParameters == nullptr && binarizationParametersSize > 0)
+    {
+        return GABAC_FAILURE;
+    }
+    if (symbols == nullptr)
+    {
+        return GABAC_FAILURE;
+    }
+    if (symbolsSize == nullptr)
+    {
+        return GABAC_FAILURE;
+    }
+
+    try
+    {
+        // C++-style vectors to receive input data / accumulate output data; the
+        // bitstream itself is read in place
+        std::vector<unsigned int> binarizationParametersVector(
+                binarizationParameters,
+                (binarizationParameters + binarizationParametersSize)
+        );
+        std::vector<int64_t> symbolsVector;
+
+        // Execute
+        int rc = gabac::decodeRange(
+                bitstream,
+                bitstreamSize,
+                firstSymbol,
+                numSymbols,
+                static_cast<gabac::BinarizationId>(binarizationId),
+                binarizationParametersVector,
+                static_cast<gabac::ContextSelectionId>(contextSelectionId),
+                &symbolsVector
+        );
+        if (rc != GABAC_SUCCESS)
+        {
+            return GABAC_FAILURE;
+        }
+
+        // Extract plain C array data from result vectors
+        *symbolsSize = symbolsVector.size();
+        *symbols = static_cast<int64_t*>(malloc(sizeof(int64_t) * (*symbolsSize)));
+        std::copy(symbolsVector.begin(), symbolsVector.end(), *symbols);
+
+        return GABAC_SUCCESS;
+    }
+    catch (...)
+    {
+        return GABAC_FAILURE;
+    }
+}
+
+
 // ----------------------------------------------------------------------------
 // C wrapper END
 // ----------------------------------------------------------------------------
@@ -85,107 +294,808 @@ int gabac_decode(
 namespace gabac {
 
 
+static bool isValidConfiguration(
+        const BinarizationId& binarizationId,
+        const ContextSelectionId& contextSelectionId
+){
+    if (static_cast<unsigned int>(binarizationId) > static_cast<unsigned int>(BinarizationId::STEG))
+    {
+        return false;
+    }
+    return static_cast<unsigned int>(contextSelectionId) <= static_cast<unsigned int>(ContextSelectionId::raw);
+}
+
+
+static uint32_t readUint32(
+        const unsigned char *const bytes
+){
+    return static_cast<uint32_t>(bytes[0])
+           | (static_cast<uint32_t>(bytes[1]) << 8u)
+           | (static_cast<uint32_t>(bytes[2]) << 16u)
+           | (static_cast<uint32_t>(bytes[3]) << 24u);
+}
+
+
+template<typename T>
+static int decodeWithReader(
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        Reader *const reader,
+        std::vector<T> *const symbols
+){
+    bool raw = (contextSelectionId == ContextSelectionId::raw);
+    size_t symbolsSize = raw ? reader->startRaw() : reader->start();
+
+    symbols->resize(symbolsSize);
+    reader->readValues(
+            symbols->data(),
+            symbolsSize,
+            binarizationId,
+            binarizationParameters,
+            contextSelectionId
+    );
+
+    if (!raw)
+    {
+        reader->reset();
+    }
+
+    return GABAC_SUCCESS;
+}
+
+
+template<typename T>
 int decode(
-        const std::vector<unsigned char>& bitstream,
+        const unsigned char *const bitstream,
+        size_t bitstreamSize,
         const BinarizationId& binarizationId,
         const std::vector<unsigned int>& binarizationParameters,
         const ContextSelectionId& contextSelectionId,
-        std::vector<int64_t> *const symbols
+        std::vector<T> *const symbols
 ){
     if (symbols == nullptr)
     {
         return GABAC_FAILURE;
     }
 
-    Reader reader(bitstream);
-    size_t symbolsSize = reader.start();
-
-    // symbols->clear();
-    symbols->resize(symbolsSize);
-
-    int64_t symbol = 0;
-    unsigned int previousSymbol = 0;
-    unsigned int previousPreviousSymbol = 0;
+    if (!isValidConfiguration(binarizationId, contextSelectionId))
+    {
+        return GABAC_FAILURE;
+    }
 
-    for (size_t i = 0; i < symbolsSize; i++)
+    if (bitstream == nullptr && bitstreamSize > 0)
     {
-        if (contextSelectionId == ContextSelectionId::bypass)
-        {
-            symbol = reader.readBypassValue(
-                    binarizationId,
-                    binarizationParameters
-            );
-            (*symbols)[i] = symbol;
-        }
-        else if (contextSelectionId
-                 == ContextSelectionId::adaptive_coding_order_0)
-        {
-            symbol = reader.readAdaptiveCabacValue(
-                    binarizationId,
-                    binarizationParameters,
-                    0,
-                    0
-            );
-            (*symbols)[i] = symbol;
-        }
-        else if (contextSelectionId
-                 == ContextSelectionId::adaptive_coding_order_1)
-        {
-            symbol = reader.readAdaptiveCabacValue(
-                    binarizationId,
-                    binarizationParameters,
-                    previousSymbol,
-                    0
-            );
-            (*symbols)[i] = symbol;
-            if (symbol < 0)
-            {
-                symbol = -symbol;
-            }
-            if (symbol > 3)
-            {
-                previousSymbol = 3;
-            }
-            else
-            {
-                assert(symbol <= std::numeric_limits<unsigned int>::max());
-                previousSymbol = static_cast<unsigned int>(symbol);
-            }
-        }
-        else if (contextSelectionId
-                 == ContextSelectionId::adaptive_coding_order_2)
-        {
-            symbol = reader.readAdaptiveCabacValue(
-                    binarizationId,
-                    binarizationParameters,
-                    previousSymbol,
-                    previousPreviousSymbol
-            );
-            (*symbols)[i] = symbol;
-            previousPreviousSymbol = previousSymbol;
-            if (symbol < 0)
-            {
-                symbol = -symbol;
-            }
-            if (symbol > 3)
-            {
-                previousSymbol = 3;
-            }
-            else
-            {
-                assert(symbol <= std::numeric_limits<unsigned int>::max());
-                previousSymbol = static_cast<unsigned int>(symbol);
-            }
-        }
-        else
-        {
-            return GABAC_FAILURE;
-        }
+        return GABAC_FAILURE;
     }
 
-    reader.reset();
+    Reader reader(bitstream, bitstreamSize);
+    return decodeWithReader(
+            binarizationId,
+            binarizationParameters,
+            contextSelectionId,
+            &reader,
+            symbols
+    );
+}
+
 
-    return GABAC_SUCCESS;
+template<typename T>
+int decode(
+        const std::vector<unsigned char>& bitstream,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<T> *const symbols
+){
+    return decode(
+            bitstream.data(),
+            bitstream.size(),
+            binarizationId,
+            binarizationParameters,
+            contextSelectionId,
+            symbols
+    );
+}
+
+
+template int decode<int64_t>(
+        const unsigned char *bitstream,
+        size_t bitstreamSize,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<int64_t> *symbols
+);
+
+
+template int decode<int64_t>(
+        const std::vector<unsigned char>& bitstream,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<int64_t> *symbols
+);
+
+
+template int decode<uint8_t>(
+        const unsigned char *bitstream,
+        size_t bitstreamSize,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<uint8_t> *symbols
+);
+
+
+template int decode<uint8_t>(
+        const std::vector<unsigned char>& bitstream,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<uint8_t> *symbols
+);
+
+
+template int decode<uint16_t>(
+        const unsigned char *bitstream,
+        size_t bitstreamSize,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<uint16_t> *symbols
+);
+
+
+template int decode<uint16_t>(
+        const std::vector<unsigned char>& bitstream,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<uint16_t> *symbols
+);
+
+
+template int decode<uint32_t>(
+        const unsigned char *bitstream,
+        size_t bitstreamSize,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<uint32_t> *symbols
+);
+
+
+template int decode<uint32_t>(
+        const std::vector<unsigned char>& bitstream,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<uint32_t> *symbols
+);
+
+
+template int decode<uint64_t>(
+        const unsigned char *bitstream,
+        size_t bitstreamSize,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<uint64_t> *symbols
+);
+
+
+template int decode<uint64_t>(
+        const std::vector<unsigned char>& bitstream,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<uint64_t> *symbols
+);
+
+
+int decode(
+        const unsigned char *const bitstream,
+        size_t bitstreamSize,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        SymbolStream *const symbols
+){
+    if (symbols == nullptr)
+    {
+        return GABAC_FAILURE;
+    }
+
+    switch (symbols->getWordSize())
+    {
+        case 1:
+            return decode(bitstream, bitstreamSize, binarizationId, binarizationParameters, contextSelectionId,
+                          &symbols->get<uint8_t>());
+        case 2:
+            return decode(bitstream, bitstreamSize, binarizationId, binarizationParameters, contextSelectionId,
+                          &symbols->get<uint16_t>());
+        case 4:
+            return decode(bitstream, bitstreamSize, binarizationId, binarizationParameters, contextSelectionId,
+                          &symbols->get<uint32_t>());
+        default:
+            return decode(bitstream, bitstreamSize, binarizationId, binarizationParameters, contextSelectionId,
+                          &symbols->get<uint64_t>());
+    }
+}
+
+
+int decodeNumSymbols(
+        const unsigned char *const bitstream,
+        size_t bitstreamSize,
+        const ContextSelectionId& contextSelectionId,
+        size_t *const numSymbols
+){
+    if (numSymbols == nullptr)
+    {
+        return GABAC_FAILURE;
+    }
+    if (!isValidConfiguration(BinarizationId::BI, contextSelectionId))
+    {
+        return GABAC_FAILURE;
+    }
+    if (bitstream == nullptr && bitstreamSize > 0)
+    {
+        return GABAC_FAILURE;
+    }
+
+    Reader reader(bitstream, bitstreamSize);
+    *numSymbols = (contextSelectionId == ContextSelectionId::raw) ? reader.startRaw() : reader.start();
+
+    return GABAC_SUCCESS;
+}
+
+
+int decode(
+        const unsigned char *const bitstream,
+        size_t bitstreamSize,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        int64_t *const symbols,
+        size_t symbolsCapacity,
+        size_t *const symbolsSize
+){
+    if (symbolsSize == nullptr)
+    {
+        return GABAC_FAILURE;
+    }
+    if (!isValidConfiguration(binarizationId, contextSelectionId))
+    {
+        return GABAC_FAILURE;
+    }
+    if (bitstream == nullptr && bitstreamSize > 0)
+    {
+        return GABAC_FAILURE;
+    }
+
+    Reader reader(bitstream, bitstreamSize);
+    bool raw = (contextSelectionId == ContextSelectionId::raw);
+    *symbolsSize = raw ? reader.startRaw() : reader.start();
+    if (*symbolsSize > symbolsCapacity || (symbols == nullptr && *symbolsSize > 0))
+    {
+        return GABAC_FAILURE;
+    }
+
+    reader.readValues(
+            symbols,
+            *symbolsSize,
+            binarizationId,
+            binarizationParameters,
+            contextSelectionId
+    );
+
+    return GABAC_SUCCESS;
+}
+
+
+DecoderSession::DecoderSession()
+        : m_reader(new Reader(nullptr, 0)),
+        m_symbols(){
+}
+
+
+DecoderSession::~DecoderSession() = default;
+
+
+int DecoderSession::decode(
+        const unsigned char *const bitstream,
+        size_t bitstreamSize,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId
+){
+    if (!isValidConfiguration(binarizationId, contextSelectionId))
+    {
+        return GABAC_FAILURE;
+    }
+
+    if (bitstream == nullptr && bitstreamSize > 0)
+    {
+        return GABAC_FAILURE;
+    }
+
+    m_reader->restart(bitstream, bitstreamSize);
+    return decodeWithReader(
+            binarizationId,
+            binarizationParameters,
+            contextSelectionId,
+            m_reader.get(),
+            &m_symbols
+    );
+}
+
+
+const std::vector<int64_t>& DecoderSession::getSymbols() const
+{
+    return m_symbols;
+}
+
+
+StreamDecoder::StreamDecoder()
+        : m_isStarted(false),
+        m_isFinished(false),
+        m_binarizationId(BinarizationId::BI),
+        m_binarizationParameters(),
+        m_contextSelectionId(ContextSelectionId::bypass),
+        m_source(),
+        m_payload(),
+        m_numChunkSymbols(0),
+        m_chunkSymbols(),
+        m_chunkSymbolsPosition(0),
+        m_reader(new Reader(nullptr, 0)){
+}
+
+
+StreamDecoder::~StreamDecoder() = default;
+
+
+int StreamDecoder::begin(
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        const InputSource& source
+){
+    if (!isValidConfiguration(binarizationId, contextSelectionId))
+    {
+        return GABAC_FAILURE;
+    }
+    if (!source)
+    {
+        return GABAC_FAILURE;
+    }
+
+    m_isStarted = true;
+    m_isFinished = false;
+    m_binarizationId = binarizationId;
+    m_binarizationParameters = binarizationParameters;
+    m_contextSelectionId = contextSelectionId;
+    m_source = source;
+    m_numChunkSymbols = 0;
+    m_chunkSymbols.clear();
+    m_chunkSymbolsPosition = 0;
+
+    return GABAC_SUCCESS;
+}
+
+
+int StreamDecoder::next(
+        int64_t *const symbols,
+        size_t maxSymbols,
+        size_t *const numSymbols
+){
+    if (!m_isStarted || numSymbols == nullptr)
+    {
+        return GABAC_FAILURE;
+    }
+    assert(symbols != nullptr || maxSymbols == 0);
+
+    *numSymbols = 0;
+    try
+    {
+        while (*numSymbols < maxSymbols)
+        {
+            // Hand out what is left of the current chunk
+            if (m_chunkSymbolsPosition < m_chunkSymbols.size())
+            {
+                size_t numCopied = std::min(maxSymbols - *numSymbols, m_chunkSymbols.size() - m_chunkSymbolsPosition);
+                std::copy(
+                        m_chunkSymbols.begin() + m_chunkSymbolsPosition,
+                        m_chunkSymbols.begin() + m_chunkSymbolsPosition + numCopied,
+                        symbols + *numSymbols
+                );
+                m_chunkSymbolsPosition += numCopied;
+                *numSymbols += numCopied;
+                continue;
+            }
+
+            if (m_numChunkSymbols == 0)
+            {
+                if (m_isFinished)
+                {
+                    break;
+                }
+                if (readChunk() != GABAC_SUCCESS)
+                {
+                    return GABAC_FAILURE;
+                }
+                continue;
+            }
+
+            // A chunk which fits is decoded directly to the caller's buffer
+            int64_t *output = symbols + *numSymbols;
+            bool isDirect = (m_numChunkSymbols <= maxSymbols - *numSymbols);
+            if (!isDirect)
+            {
+                m_chunkSymbols.resize(m_numChunkSymbols);
+                m_chunkSymbolsPosition = 0;
+                output = m_chunkSymbols.data();
+            }
+            m_reader->restart(m_payload.data(), m_payload.size());
+            m_reader->readValues(
+                    output,
+                    m_numChunkSymbols,
+                    m_binarizationId,
+                    m_binarizationParameters,
+                    m_contextSelectionId
+            );
+            if (isDirect)
+            {
+                *numSymbols += m_numChunkSymbols;
+            }
+            m_numChunkSymbols = 0;
+        }
+    }
+    catch (...)
+    {
+        // Corrupt chunks make the reader throw; the stream cannot be resumed
+        m_numChunkSymbols = 0;
+        m_chunkSymbols.clear();
+        m_chunkSymbolsPosition = 0;
+        return GABAC_FAILURE;
+    }
+
+    return GABAC_SUCCESS;
+}
+
+
+// Reads the next chunk header and payload (see StreamEncoder). The header
+// is not trusted: the payload is read in steps, so that no more is
+// allocated than the source delivers, and the number of symbols must be
+// codable in the payload.
+int StreamDecoder::readChunk(){
+    unsigned char header[2 * sizeof(uint32_t)];
+    if (!readInput(header, sizeof(header)))
+    {
+        return GABAC_FAILURE;
+    }
+
+    size_t numChunkSymbols = readUint32(&header[0]);
+    if (numChunkSymbols == 0)
+    {
+        m_isFinished = true;
+        return GABAC_SUCCESS;
+    }
+
+    const size_t READ_STEP_SIZE = 1u << 20u;
+    size_t payloadSize = readUint32(&header[4]);
+    m_payload.clear();
+    while (m_payload.size() < payloadSize)
+    {
+        size_t numBytesRead = m_payload.size();
+        m_payload.resize(numBytesRead + std::min(payloadSize - numBytesRead, READ_STEP_SIZE));
+        if (!readInput(m_payload.data() + numBytesRead, m_payload.size() - numBytesRead))
+        {
+            return GABAC_FAILURE;
+        }
+    }
+
+    // Each symbol has at least one bin, unless it is binarized to nothing,
+    // and even a well-predicted bin costs more than 1/64 bit of CABAC
+    // output (raw and bypass bins cost a whole bit)
+    const size_t MAX_BINS_PER_BYTE = 512;
+    bool isEmptyBinarization = (m_binarizationId == BinarizationId::BI || m_binarizationId == BinarizationId::TU)
+                               && !m_binarizationParameters.empty() && m_binarizationParameters[0] == 0;
+    if (!isEmptyBinarization && numChunkSymbols > (payloadSize + 1) * MAX_BINS_PER_BYTE)
+    {
+        return GABAC_FAILURE;
+    }
+
+    m_numChunkSymbols = numChunkSymbols;
+    return GABAC_SUCCESS;
+}
+
+
+bool StreamDecoder::readInput(
+        unsigned char *bytes,
+        size_t numBytes
+){
+    while (numBytes > 0)
+    {
+        size_t numRead = m_source(bytes, numBytes);
+        if (numRead == 0)
+        {
+            return false;
+        }
+        assert(numRead <= numBytes);
+        bytes += numRead;
+        numBytes -= numRead;
+    }
+    return true;
+}
+
+
+// Decodes [firstSymbol, firstSymbol + numSymbols) of a block-structured
+// bitstream with numThreads threads (0: one per hardware thread)
+static int decodeBlockRange(
+        const unsigned char *const bitstream,
+        size_t bitstreamSize,
+        size_t firstSymbol,
+        size_t numSymbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        unsigned int numThreads,
+        std::vector<int64_t> *const symbols
+){
+    if (symbols == nullptr)
+    {
+        return GABAC_FAILURE;
+    }
+    if (!isValidConfiguration(binarizationId, contextSelectionId))
+    {
+        return GABAC_FAILURE;
+    }
+    if (bitstream == nullptr || bitstreamSize < 2 * sizeof(uint32_t))
+    {
+        return GABAC_FAILURE;
+    }
+
+    // Parse the block index (see encodeBlocks())
+    size_t totalNumSymbols = readUint32(&bitstream[0]);
+    size_t blockSize = readUint32(&bitstream[4]);
+    if (blockSize == 0)
+    {
+        return GABAC_FAILURE;
+    }
+    size_t numBlocks = (totalNumSymbols + blockSize - 1) / blockSize;
+    size_t headerSize = (2 + numBlocks) * sizeof(uint32_t);
+    if (headerSize > bitstreamSize)
+    {
+        return GABAC_FAILURE;
+    }
+    if (firstSymbol > totalNumSymbols || numSymbols > totalNumSymbols - firstSymbol)
+    {
+        return GABAC_FAILURE;
+    }
+
+    symbols->resize(numSymbols);
+    if (numSymbols == 0)
+    {
+        return GABAC_SUCCESS;
+    }
+
+    const unsigned char *blockIndex = bitstream + (2 * sizeof(uint32_t));
+    const unsigned char *payload = bitstream + headerSize;
+    size_t payloadSize = bitstreamSize - headerSize;
+
+    // Only the blocks overlapping [firstSymbol, firstSymbol + numSymbols)
+    // are decoded; their offsets are validated up front
+    size_t lastSymbol = firstSymbol + numSymbols;
+    size_t firstBlock = firstSymbol / blockSize;
+    size_t lastBlock = ((lastSymbol - 1) / blockSize) + 1;
+    std::vector<size_t> blockBounds(lastBlock - firstBlock + 1);
+    for (size_t block = firstBlock; block <= lastBlock; block++)
+    {
+        size_t bound = payloadSize;
+        if (block < numBlocks)
+        {
+            bound = readUint32(blockIndex + (block * sizeof(uint32_t)));
+        }
+        if (bound > payloadSize || (block > firstBlock && bound < blockBounds[block - firstBlock - 1]))
+        {
+            return GABAC_FAILURE;
+        }
+        blockBounds[block - firstBlock] = bound;
+    }
+
+    // Blocks are independent: split them into one contiguous run per thread,
+    // each writing to a disjoint part of the output
+    if (numThreads == 0)
+    {
+        numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    size_t numRuns = std::min(static_cast<size_t>(numThreads), lastBlock - firstBlock);
+    std::vector<std::exception_ptr> runExceptions(numRuns);
+
+    auto decodeRun = [&](size_t run)
+    {
+        try
+        {
+            std::vector<int64_t> blockSymbols;
+            size_t runFirstBlock = firstBlock + ((run * (lastBlock - firstBlock)) / numRuns);
+            size_t runLastBlock = firstBlock + (((run + 1) * (lastBlock - firstBlock)) / numRuns);
+            for (size_t block = runFirstBlock; block < runLastBlock; block++)
+            {
+                size_t blockBegin = blockBounds[block - firstBlock];
+                size_t blockEnd = blockBounds[block - firstBlock + 1];
+                size_t blockFirstSymbol = block * blockSize;
+                size_t blockNumSymbols = std::min(blockSize, totalNumSymbols - blockFirstSymbol);
+
+                // Blocks which are entirely inside the range are decoded in
+                // place
+                int64_t *blockOutput = nullptr;
+                bool inRange = (blockFirstSymbol >= firstSymbol) &&
+                               (blockFirstSymbol + blockNumSymbols <= lastSymbol);
+                if (inRange)
+                {
+                    blockOutput = symbols->data() + (blockFirstSymbol - firstSymbol);
+                }
+                else
+                {
+                    blockSymbols.resize(blockNumSymbols);
+                    blockOutput = blockSymbols.data();
+                }
+
+                Reader reader(payload + blockBegin, blockEnd - blockBegin);
+                reader.readValues(
+                        blockOutput,
+                        blockNumSymbols,
+                        binarizationId,
+                        binarizationParameters,
+                        contextSelectionId
+                );
+
+                if (!inRange)
+                {
+                    size_t copyBegin = std::max(firstSymbol, blockFirstSymbol);
+                    size_t copyEnd = std::min(lastSymbol, blockFirstSymbol + blockNumSymbols);
+                    std::copy(
+                            blockSymbols.begin() + (copyBegin - blockFirstSymbol),
+                            blockSymbols.begin() + (copyEnd - blockFirstSymbol),
+                            symbols->begin() + (copyBegin - firstSymbol)
+                    );
+                }
+            }
+        }
+        catch (...)
+        {
+            runExceptions[run] = std::current_exception();
+        }
+    };
+
+    // Runs for which no thread can be started are done on this thread
+    std::vector<std::thread> threads;
+    threads.reserve(numRuns - 1);
+    size_t nextRun = 1;
+    for (; nextRun < numRuns; nextRun++)
+    {
+        try
+        {
+            threads.emplace_back(decodeRun, nextRun);
+        }
+        catch (const std::system_error&)
+        {
+            break;
+        }
+    }
+    for (; nextRun < numRuns; nextRun++)
+    {
+        decodeRun(nextRun);
+    }
+    decodeRun(0);
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    for (const auto& exception : runExceptions)
+    {
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    return GABAC_SUCCESS;
+}
+
+
+int decodeRange(
+        const unsigned char *const bitstream,
+        size_t bitstreamSize,
+        size_t firstSymbol,
+        size_t numSymbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<int64_t> *const symbols
+){
+    return decodeBlockRange(
+            bitstream,
+            bitstreamSize,
+            firstSymbol,
+            numSymbols,
+            binarizationId,
+            binarizationParameters,
+            contextSelectionId,
+            1,
+            symbols
+    );
+}
+
+
+int decodeRange(
+        const std::vector<unsigned char>& bitstream,
+        size_t firstSymbol,
+        size_t numSymbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<int64_t> *const symbols
+){
+    return decodeRange(
+            bitstream.data(),
+            bitstream.size(),
+            firstSymbol,
+            numSymbols,
+            binarizationId,
+            binarizationParameters,
+            contextSelectionId,
+            symbols
+    );
+}
+
+
+int decodeBlocks(
+        const unsigned char *const bitstream,
+        size_t bitstreamSize,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        unsigned int numThreads,
+        std::vector<int64_t> *const symbols
+){
+    if (bitstream == nullptr || bitstreamSize < sizeof(uint32_t))
+    {
+        return GABAC_FAILURE;
+    }
+
+    return decodeBlockRange(
+            bitstream,
+            bitstreamSize,
+            0,
+            readUint32(bitstream),
+            binarizationId,
+            binarizationParameters,
+            contextSelectionId,
+            numThreads,
+            symbols
+    );
+}
+
+
+int decodeBlocks(
+        const std::vector<unsigned char>& bitstream,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        unsigned int numThreads,
+        std::vector<int64_t> *const symbols
+){
+    return decodeBlocks(
+            bitstream.data(),
+            bitstream.size(),
+            binarizationId,
+            binarizationParameters,
+            contextSelectionId,
+            numThreads,
+            symbols
+    );
 }
 
 
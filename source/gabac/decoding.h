@@ -33,6 +33,58 @@ int gabac_decode(
 );
 
 
+/* Number of symbols in a bitstream produced by gabac_encode() */
+int gabac_decode_size(
+        const unsigned char *bitstream,
+        size_t bitstreamSize,
+        unsigned int contextSelectionId,
+        size_t *symbolsSize
+);
+
+
+/* Like gabac_decode(), but reads the bitstream in place and writes the
+ * symbols to a caller-provided buffer. If symbolsCapacity is too small,
+ * GABAC_FAILURE is returned and *symbolsSize holds the required size. */
+int gabac_decode_into(
+        const unsigned char *bitstream,
+        size_t bitstreamSize,
+        unsigned int binarizationId,
+        unsigned int *binarizationParameters,
+        size_t binarizationParametersSize,
+        unsigned int contextSelectionId,
+        int64_t *symbols,
+        size_t symbolsCapacity,
+        size_t *symbolsSize
+);
+
+
+int gabac_decode_blocks(
+        unsigned char *bitstream,
+        size_t bitstreamSize,
+        unsigned int binarizationId,
+        unsigned int *binarizationParameters,
+        size_t binarizationParametersSize,
+        unsigned int contextSelectionId,
+        unsigned int numThreads,
+        int64_t **symbols,
+        size_t *symbolsSize
+);
+
+
+int gabac_decode_range(
+        unsigned char *bitstream,
+        size_t bitstreamSize,
+        size_t firstSymbol,
+        size_t numSymbols,
+        unsigned int binarizationId,
+        unsigned int *binarizationParameters,
+        size_t binarizationParametersSize,
+        unsigned int contextSelectionId,
+        int64_t **symbols,
+        size_t *symbolsSize
+);
+
+
 #ifdef __cplusplus
 }  // extern "C"
 
@@ -42,6 +94,8 @@ int gabac_decode(
 // ----------------------------------------------------------------------------
 
 
+#include <functional>
+#include <memory>
 #include <vector>
 
 #include "gabac/constants.h"
@@ -50,15 +104,218 @@ int gabac_decode(
 namespace gabac {
 
 
+// Decodes directly from the caller's buffer without copying it. T is int64_t
+// or, for narrow unsigned data, one of uint8_t, uint16_t, uint32_t and
+// uint64_t; the decoded values are truncated to T.
+template<typename T>
+int decode(
+        const unsigned char *bitstream,
+        size_t bitstreamSize,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<T> *symbols
+);
+
+
+template<typename T>
 int decode(
         const std::vector<unsigned char>& bitstream,
         const BinarizationId& binarizationId,
         const std::vector<unsigned int>& binarizationParameters,
         const ContextSelectionId& contextSelectionId,
+        std::vector<T> *symbols
+);
+
+
+// Decodes to symbols of the word size which symbols was constructed with
+int decode(
+        const unsigned char *bitstream,
+        size_t bitstreamSize,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        SymbolStream *symbols
+);
+
+
+// Number of symbols in a bitstream produced by encode()
+int decodeNumSymbols(
+        const unsigned char *bitstream,
+        size_t bitstreamSize,
+        const ContextSelectionId& contextSelectionId,
+        size_t *numSymbols
+);
+
+
+// Decodes to a caller-provided buffer; fails if symbolsCapacity is smaller
+// than the number of symbols, which is returned in *symbolsSize in any case
+int decode(
+        const unsigned char *bitstream,
+        size_t bitstreamSize,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        int64_t *symbols,
+        size_t symbolsCapacity,
+        size_t *symbolsSize
+);
+
+
+// Decodes a whole bitstream produced by encodeBlocks(), spreading the blocks
+// over numThreads threads (0: one per hardware thread)
+int decodeBlocks(
+        const unsigned char *bitstream,
+        size_t bitstreamSize,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        unsigned int numThreads,
         std::vector<int64_t> *symbols
 );
 
 
+int decodeBlocks(
+        const std::vector<unsigned char>& bitstream,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        unsigned int numThreads,
+        std::vector<int64_t> *symbols
+);
+
+
+// Decodes the symbols [firstSymbol, firstSymbol + numSymbols) of a bitstream
+// produced by encodeBlocks(); only the blocks overlapping that range are
+// decoded
+int decodeRange(
+        const unsigned char *bitstream,
+        size_t bitstreamSize,
+        size_t firstSymbol,
+        size_t numSymbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<int64_t> *symbols
+);
+
+
+int decodeRange(
+        const std::vector<unsigned char>& bitstream,
+        size_t firstSymbol,
+        size_t numSymbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<int64_t> *symbols
+);
+
+
+class Reader;
+
+
+// Decoder for many short streams: the context table and the symbol buffer
+// are kept between calls, so that once the buffer has grown to the largest
+// stream size, decode() does not allocate anymore
+class DecoderSession
+{
+ public:
+    DecoderSession();
+
+    DecoderSession(const DecoderSession&) = delete;
+
+    DecoderSession& operator=(const DecoderSession&) = delete;
+
+    ~DecoderSession();
+
+    // Same as gabac::decode(); the result is available via getSymbols()
+    // until the next call
+    int decode(
+            const unsigned char *bitstream,
+            size_t bitstreamSize,
+            const BinarizationId& binarizationId,
+            const std::vector<unsigned int>& binarizationParameters,
+            const ContextSelectionId& contextSelectionId
+    );
+
+    const std::vector<int64_t>& getSymbols() const;
+
+ private:
+    std::unique_ptr<Reader> m_reader;
+
+    std::vector<int64_t> m_symbols;
+};
+
+
+// Copies up to maxBytes bytes of input to bytes and returns how many were
+// copied; 0 signals the end of the input
+using InputSource = std::function<size_t(unsigned char *bytes, size_t maxBytes)>;
+
+
+// Pull-based decoder for streams produced by StreamEncoder. The input is
+// read from the source one chunk at a time, so memory use is bounded by the
+// chunk size of the encoder, not by the stream length.
+class StreamDecoder
+{
+ public:
+    StreamDecoder();
+
+    StreamDecoder(const StreamDecoder&) = delete;
+
+    StreamDecoder& operator=(const StreamDecoder&) = delete;
+
+    ~StreamDecoder();
+
+    int begin(
+            const BinarizationId& binarizationId,
+            const std::vector<unsigned int>& binarizationParameters,
+            const ContextSelectionId& contextSelectionId,
+            const InputSource& source
+    );
+
+    // Decodes up to maxSymbols symbols to symbols; *numSymbols receives the
+    // number of decoded symbols, which is 0 only at the end of the stream
+    int next(
+            int64_t *symbols,
+            size_t maxSymbols,
+            size_t *numSymbols
+    );
+
+ private:
+    int readChunk();
+
+    bool readInput(
+            unsigned char *bytes,
+            size_t numBytes
+    );
+
+    bool m_isStarted;
+
+    bool m_isFinished;
+
+    BinarizationId m_binarizationId;
+
+    std::vector<unsigned int> m_binarizationParameters;
+
+    ContextSelectionId m_contextSelectionId;
+
+    InputSource m_source;
+
+    std::vector<unsigned char> m_payload;
+
+    // Number of symbols of the current chunk which are not decoded yet
+    size_t m_numChunkSymbols;
+
+    // Decoded symbols of the current chunk, handed out from
+    // m_chunkSymbolsPosition on
+    std::vector<int64_t> m_chunkSymbols;
+
+    size_t m_chunkSymbolsPosition;
+
+    std::unique_ptr<Reader> m_reader;
+};
+
+
 }  // namespace gabac
 
 
@@ -2,7 +2,11 @@
 
 #include <algorithm>
 #include <cassert>
+#include <functional>
 #include <limits>
+#include <system_error>
+#include <thread>
+#include <vector>
 
 #include "gabac/return_codes.h"
 
@@ -79,54 +83,105 @@ int gabac_inverseTransformDiffCoding(
 }
 
 
+int gabac_transformDiffCodingInto(
+        const uint64_t *const symbols,
+        const size_t symbolsSize,
+        int64_t *const transformedSymbols,
+        const size_t transformedSymbolsCapacity
+){
+    if (symbols == nullptr && symbolsSize > 0)
+    {
+        return GABAC_FAILURE;
+    }
+    if (transformedSymbols == nullptr && symbolsSize > 0)
+    {
+        return GABAC_FAILURE;
+    }
+    if (transformedSymbolsCapacity < symbolsSize)
+    {
+        return GABAC_FAILURE;
+    }
+
+    gabac::transformDiffCoding(symbols, symbolsSize, transformedSymbols);
+
+    return GABAC_SUCCESS;
+}
+
+
+int gabac_inverseTransformDiffCodingInto(
+        const int64_t *const transformedSymbols,
+        const size_t transformedSymbolsSize,
+        uint64_t *const symbols,
+        const size_t symbolsCapacity
+){
+    if (transformedSymbols == nullptr && transformedSymbolsSize > 0)
+    {
+        return GABAC_FAILURE;
+    }
+    if (symbols == nullptr && transformedSymbolsSize > 0)
+    {
+        return GABAC_FAILURE;
+    }
+    if (symbolsCapacity < transformedSymbolsSize)
+    {
+        return GABAC_FAILURE;
+    }
+
+    gabac::inverseTransformDiffCoding(transformedSymbols, transformedSymbolsSize, symbols);
+
+    return GABAC_SUCCESS;
+}
+
+
 namespace gabac {
 
 
+template<typename T>
 void transformDiffCoding(
-        const std::vector<uint64_t>& symbols,
-        std::vector<int64_t> *const transformedSymbols
+        const T *const symbols,
+        size_t symbolsSize,
+        int64_t *const transformedSymbols
 ){
-    assert(transformedSymbols != nullptr);
-
-    // Prepare the output vector
-    transformedSymbols->clear();
-    transformedSymbols->resize(symbols.size());
+    if (symbolsSize == 0)
+    {
+        return;
+    }
 
-    // Do the diff coding
-    uint64_t previousSymbol = 0;
-    for (size_t i = 0; i < symbols.size(); i++)
+    // The differences are taken modulo 2^64 whatever the width of T, so
+    // that narrow and wide streams give the same differences. Each one
+    // depends on two input symbols only, so that the loop is vectorized.
+    transformedSymbols[0] = static_cast<int64_t>(static_cast<uint64_t>(symbols[0]));
+    for (size_t i = 1; i < symbolsSize; i++)
     {
+        uint64_t symbol = symbols[i];
+        uint64_t previousSymbol = symbols[i - 1];
 #ifndef NDEBUG
         uint64_t diff = 0;
-        if (previousSymbol < symbols[i])
+        if (previousSymbol < symbol)
         {
-            diff = symbols[i] - previousSymbol;
+            diff = symbol - previousSymbol;
             assert(diff <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max()));
         }
-        else  // previousSymbol >= symbols[i]
+        else  // previousSymbol >= symbol
         {
-            diff = previousSymbol - symbols[i];
+            diff = previousSymbol - symbol;
             assert(diff <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + 1);
         }
 #endif  // NDEBUG
-        (*transformedSymbols)[i] = symbols[i] - previousSymbol;
-        previousSymbol = symbols[i];
+        transformedSymbols[i] = static_cast<int64_t>(symbol - previousSymbol);
     }
 }
 
 
-void inverseTransformDiffCoding(
-        const std::vector<int64_t>& transformedSymbols,
-        std::vector<uint64_t> *const symbols
+// Prefix sum of the differences, starting from previousSymbol
+template<typename T>
+static void inverseTransformDiffCoding(
+        const int64_t *const transformedSymbols,
+        size_t transformedSymbolsSize,
+        uint64_t previousSymbol,
+        T *const symbols
 ){
-    assert(symbols != nullptr);
-
-    // Prepare the output vector
-    symbols->resize(transformedSymbols.size());
-
-    // Re-compute the symbols from the differences
-    uint64_t previousSymbol = 0;
-    for (size_t i = 0; i < transformedSymbols.size(); i++)
+    for (size_t i = 0; i < transformedSymbolsSize; i++)
     {
 #ifndef NDEBUG
         if (transformedSymbols[i] < 0)
@@ -143,10 +198,217 @@ void inverseTransformDiffCoding(
                    static_cast<uint64_t>(transformedSymbols[i]));
         }
 #endif  // NDEBUG
-        (*symbols)[i] = previousSymbol + transformedSymbols[i];
-        previousSymbol = (*symbols)[i];
+        symbols[i] = static_cast<T>(previousSymbol + transformedSymbols[i]);
+        previousSymbol = symbols[i];
     }
 }
 
 
+// Large inputs are split into one chunk per thread (numThreads, 0: one per
+// hardware thread). The sums of the chunks are taken concurrently; their
+// prefix sums are the offsets from which the chunks are then decoded
+// concurrently. As the sums are taken modulo 2^64, this gives the same
+// symbols as the serial prefix sum. Chunks for which no thread can be
+// started are done on the calling thread.
+template<typename T>
+void inverseTransformDiffCoding(
+        const int64_t *const transformedSymbols,
+        size_t transformedSymbolsSize,
+        T *const symbols,
+        unsigned int numThreads
+){
+    if (numThreads == 0)
+    {
+        numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    const size_t MIN_CHUNK_SIZE = 1u << 18u;
+    size_t numChunks = std::min(
+            static_cast<size_t>(numThreads),
+            std::max(transformedSymbolsSize / MIN_CHUNK_SIZE, size_t(1))
+    );
+    if (numChunks == 1)
+    {
+        inverseTransformDiffCoding(transformedSymbols, transformedSymbolsSize, 0, symbols);
+        return;
+    }
+
+    auto chunkBegin = [transformedSymbolsSize, numChunks](size_t chunk)
+    {
+        return (chunk * transformedSymbolsSize) / numChunks;
+    };
+    auto runChunks = [numChunks](const std::function<void(size_t)>& f)
+    {
+        std::vector<std::thread> threads;
+        threads.reserve(numChunks - 1);
+        size_t chunk = 1;
+        for (; chunk < numChunks; chunk++)
+        {
+            try
+            {
+                threads.emplace_back(f, chunk);
+            }
+            catch (const std::system_error&)
+            {
+                break;
+            }
+        }
+        for (; chunk < numChunks; chunk++)
+        {
+            f(chunk);
+        }
+        f(0);
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    };
+
+    // The last chunk is not needed for the offsets
+    std::vector<uint64_t> offsets(numChunks, 0);
+    runChunks([&](size_t chunk)
+              {
+                  if (chunk + 1 == numChunks)
+                  {
+                      return;
+                  }
+                  uint64_t sum = 0;
+                  for (size_t i = chunkBegin(chunk); i < chunkBegin(chunk + 1); i++)
+                  {
+                      sum += static_cast<uint64_t>(transformedSymbols[i]);
+                  }
+                  offsets[chunk + 1] = sum;
+              });
+    for (size_t chunk = 1; chunk < numChunks; chunk++)
+    {
+        offsets[chunk] += offsets[chunk - 1];
+    }
+
+    // Narrow symbols only keep the low bits of the offset, as they would
+    // have in the serial prefix sum
+    runChunks([&](size_t chunk)
+              {
+                  size_t begin = chunkBegin(chunk);
+                  inverseTransformDiffCoding(transformedSymbols + begin, chunkBegin(chunk + 1) - begin,
+                                             static_cast<uint64_t>(static_cast<T>(offsets[chunk])),
+                                             symbols + begin);
+              });
+}
+
+
+template<typename T>
+void transformDiffCoding(
+        const std::vector<T>& symbols,
+        std::vector<int64_t> *const transformedSymbols
+){
+    assert(transformedSymbols != nullptr);
+
+    // Prepare the output vector
+    transformedSymbols->clear();
+    transformedSymbols->resize(symbols.size());
+
+    // Do the diff coding
+    transformDiffCoding(symbols.data(), symbols.size(), transformedSymbols->data());
+}
+
+
+template<typename T>
+void inverseTransformDiffCoding(
+        const std::vector<int64_t>& transformedSymbols,
+        std::vector<T> *const symbols,
+        const unsigned int numThreads
+){
+    assert(symbols != nullptr);
+
+    // Prepare the output vector
+    symbols->resize(transformedSymbols.size());
+
+    // Re-compute the symbols from the differences
+    inverseTransformDiffCoding(transformedSymbols.data(), transformedSymbols.size(), symbols->data(), numThreads);
+}
+
+
+
+// Symbol widths of the gabacify pipeline (see SymbolStream)
+template void transformDiffCoding<uint8_t>(
+        const uint8_t *symbols,
+        size_t symbolsSize,
+        int64_t *transformedSymbols
+);
+template void inverseTransformDiffCoding<uint8_t>(
+        const int64_t *transformedSymbols,
+        size_t transformedSymbolsSize,
+        uint8_t *symbols,
+        unsigned int numThreads
+);
+template void transformDiffCoding<uint8_t>(
+        const std::vector<uint8_t>& symbols,
+        std::vector<int64_t> *transformedSymbols
+);
+template void inverseTransformDiffCoding<uint8_t>(
+        const std::vector<int64_t>& transformedSymbols,
+        std::vector<uint8_t> *symbols,
+        unsigned int numThreads
+);
+template void transformDiffCoding<uint16_t>(
+        const uint16_t *symbols,
+        size_t symbolsSize,
+        int64_t *transformedSymbols
+);
+template void inverseTransformDiffCoding<uint16_t>(
+        const int64_t *transformedSymbols,
+        size_t transformedSymbolsSize,
+        uint16_t *symbols,
+        unsigned int numThreads
+);
+template void transformDiffCoding<uint16_t>(
+        const std::vector<uint16_t>& symbols,
+        std::vector<int64_t> *transformedSymbols
+);
+template void inverseTransformDiffCoding<uint16_t>(
+        const std::vector<int64_t>& transformedSymbols,
+        std::vector<uint16_t> *symbols,
+        unsigned int numThreads
+);
+template void transformDiffCoding<uint32_t>(
+        const uint32_t *symbols,
+        size_t symbolsSize,
+        int64_t *transformedSymbols
+);
+template void inverseTransformDiffCoding<uint32_t>(
+        const int64_t *transformedSymbols,
+        size_t transformedSymbolsSize,
+        uint32_t *symbols,
+        unsigned int numThreads
+);
+template void transformDiffCoding<uint32_t>(
+        const std::vector<uint32_t>& symbols,
+        std::vector<int64_t> *transformedSymbols
+);
+template void inverseTransformDiffCoding<uint32_t>(
+        const std::vector<int64_t>& transformedSymbols,
+        std::vector<uint32_t> *symbols,
+        unsigned int numThreads
+);
+template void transformDiffCoding<uint64_t>(
+        const uint64_t *symbols,
+        size_t symbolsSize,
+        int64_t *transformedSymbols
+);
+template void inverseTransformDiffCoding<uint64_t>(
+        const int64_t *transformedSymbols,
+        size_t transformedSymbolsSize,
+        uint64_t *symbols,
+        unsigned int numThreads
+);
+template void transformDiffCoding<uint64_t>(
+        const std::vector<uint64_t>& symbols,
+        std::vector<int64_t> *transformedSymbols
+);
+template void inverseTransformDiffCoding<uint64_t>(
+        const std::vector<int64_t>& transformedSymbols,
+        std::vector<uint64_t> *symbols,
+        unsigned int numThreads
+);
+
+
 }  // namespace gabac
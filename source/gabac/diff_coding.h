@@ -25,6 +25,24 @@ int gabac_inverseTransformDiffCoding(
 );
 
 
+// Caller-buffer variants: nothing is allocated or copied; the output has as
+// many elements as the input, and the capacity must be at least that
+int gabac_transformDiffCodingInto(
+        const uint64_t *symbols,
+        size_t symbolsSize,
+        int64_t *transformedSymbols,
+        size_t transformedSymbolsCapacity
+);
+
+
+int gabac_inverseTransformDiffCodingInto(
+        const int64_t *transformedSymbols,
+        size_t transformedSymbolsSize,
+        uint64_t *symbols,
+        size_t symbolsCapacity
+);
+
+
 #ifdef __cplusplus
 }  // extern "C"
 
@@ -35,15 +53,39 @@ int gabac_inverseTransformDiffCoding(
 namespace gabac {
 
 
+// T is one of uint8_t, uint16_t, uint32_t and uint64_t
+template<typename T>
 void transformDiffCoding(
-        const std::vector<uint64_t>& symbols,
+        const std::vector<T>& symbols,
         std::vector<int64_t> *transformedSymbols
 );
 
 
+// Large inputs are decoded by numThreads threads (0: one per hardware
+// thread)
+template<typename T>
 void inverseTransformDiffCoding(
         const std::vector<int64_t>& transformedSymbols,
-        std::vector<uint64_t> *symbols
+        std::vector<T> *symbols,
+        unsigned int numThreads = 0
+);
+
+
+// Versions on plain arrays; the output must hold symbolsSize elements
+template<typename T>
+void transformDiffCoding(
+        const T *symbols,
+        size_t symbolsSize,
+        int64_t *transformedSymbols
+);
+
+
+template<typename T>
+void inverseTransformDiffCoding(
+        const int64_t *transformedSymbols,
+        size_t transformedSymbolsSize,
+        T *symbols,
+        unsigned int numThreads = 0
 );
 
 
@@ -2,8 +2,13 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <exception>
 #include <limits>
+#include <system_error>
+#include <thread>
 
+#include "gabac/cabac_tables.h"
 #include "gabac/constants.h"
 #include "gabac/return_codes.h"
 #include "gabac/writer.h"
@@ -28,7 +33,7 @@ int gabac_encode(
     {
         return GABAC_FAILURE;
     }
-    if (binarizationParameters == nullptr)
+    if (binarizationParameters == nullptr && binarizationParametersSize > 0)
     {
         return GABAC_FAILURE;
     }
@@ -53,7 +58,7 @@ int gabac_encode(
     std::vector<unsigned char> bitstreamVector;
 
     assert(binarizationId <= static_cast<int>(gabac::BinarizationId::STEG));
-    assert(contextSelectionId <= static_cast<int>(gabac::ContextSelectionId::adaptive_coding_order_2));
+    assert(contextSelectionId <= static_cast<int>(gabac::ContextSelectionId::raw));
     // Execute
     int rc = gabac::encode(
             symbolsVector,
@@ -76,6 +81,163 @@ int gabac_encode(
 }
 
 
+int gabac_encode_bound(
+        size_t symbolsSize,
+        unsigned int binarizationId,
+        unsigned int *const binarizationParameters,
+        size_t binarizationParametersSize,
+        unsigned int contextSelectionId,
+        size_t *const bitstreamBound
+){
+    if (binarizationParameters == nullptr && binarizationParametersSize > 0)
+    {
+        return GABAC_FAILURE;
+    }
+    if (bitstreamBound == nullptr)
+    {
+        return GABAC_FAILURE;
+    }
+    if (binarizationId > static_cast<unsigned int>(gabac::BinarizationId::STEG) ||
+        contextSelectionId > static_cast<unsigned int>(gabac::ContextSelectionId::raw))
+    {
+        return GABAC_FAILURE;
+    }
+
+    std::vector<unsigned int> binarizationParametersVector(
+            binarizationParameters,
+            (binarizationParameters + binarizationParametersSize)
+    );
+    *bitstreamBound = gabac::encodeBound(
+            symbolsSize,
+            static_cast<gabac::BinarizationId>(binarizationId),
+            binarizationParametersVector,
+            static_cast<gabac::ContextSelectionId>(contextSelectionId)
+    );
+
+    return GABAC_SUCCESS;
+}
+
+
+int gabac_encode_into(
+        const int64_t *const symbols,
+        size_t symbolsSize,
+        unsigned int binarizationId,
+        unsigned int *const binarizationParameters,
+        size_t binarizationParametersSize,
+        unsigned int contextSelectionId,
+        unsigned char *const bitstream,
+        size_t bitstreamCapacity,
+        size_t *const bitstreamSize
+){
+    if (symbols == nullptr && symbolsSize > 0)
+    {
+        return GABAC_FAILURE;
+    }
+    if (binarizationParameters == nullptr && binarizationParametersSize > 0)
+    {
+        return GABAC_FAILURE;
+    }
+    if (bitstreamSize == nullptr)
+    {
+        return GABAC_FAILURE;
+    }
+
+    std::vector<unsigned int> binarizationParametersVector(
+            binarizationParameters,
+            (binarizationParameters + binarizationParametersSize)
+    );
+
+    // One session per thread, so that repeated calls reuse the context
+    // table and the internal output buffer
+    thread_local gabac::EncoderSession session;
+    int rc = session.encode(
+            symbols,
+            symbolsSize,
+            static_cast<gabac::BinarizationId>(binarizationId),
+            binarizationParametersVector,
+            static_cast<gabac::ContextSelectionId>(contextSelectionId)
+    );
+    if (rc != GABAC_SUCCESS)
+    {
+        return GABAC_FAILURE;
+    }
+
+    const std::vector<unsigned char>& bitstreamVector = session.getBitstream();
+    *bitstreamSize = bitstreamVector.size();
+    if (bitstreamVector.size() > bitstreamCapacity || bitstream == nullptr)
+    {
+        return GABAC_FAILURE;
+    }
+    std::copy(bitstreamVector.begin(), bitstreamVector.end(), bitstream);
+
+    return GABAC_SUCCESS;
+}
+
+
+int gabac_encode_blocks(
+        int64_t *const symbols,
+        size_t symbolsSize,
+        unsigned int binarizationId,
+        unsigned int *const binarizationParameters,
+        size_t binarizationParametersSize,
+        unsigned int contextSelectionId,
+        size_t blockSize,
+        unsigned int numThreads,
+        unsigned char **const bitstream,
+        size_t *const bitstreamSize
+){
+    if (symbols == nullptr)
+    {
+        return GABAC_FAILURE;
+    }
+    if (binarizationParameters == nullptr && binarizationParametersSize > 0)
+    {
+        return GABAC_FAILURE;
+    }
+    if (bitstream == nullptr)
+    {
+        return GABAC_FAILURE;
+    }
+    if (bitstreamSize == nullptr)
+    {
+        return GABAC_FAILURE;
+    }
+
+    // C++-style vectors to receive input data / accumulate output data
+    std::vector<int64_t> symbolsVector(
+            symbols,
+            (symbols + symbolsSize)
+    );
+    std::vector<unsigned int> binarizationParametersVector(
+            binarizationParameters,
+            (binarizationParameters + binarizationParametersSize)
+    );
+    std::vector<unsigned char> bitstreamVector;
+
+    // Execute
+    int rc = gabac::encodeBlocks(
+            symbolsVector,
+            static_cast<gabac::BinarizationId>(binarizationId),
+            binarizationParametersVector,
+            static_cast<gabac::ContextSelectionId>(contextSelectionId),
+            blockSize,
+            numThreads,
+            &bitstreamVector
+    );
+    if (rc != GABAC_SUCCESS)
+    {
+        return GABAC_FAILURE;
+    }
+
+    // Extract plain C array data from result vectors
+    *bitstreamSize = bitstreamVector.size();
+    *bitstream = (unsigned char *) malloc(sizeof(char) * (*bitstreamSize));
+    std::copy(bitstreamVector.begin(), bitstreamVector.end(), *bitstream);
+
+    return GABAC_SUCCESS;
+}
+
+
 // ----------------------------------------------------------------------------
 // C wrapper END
 // ----------------------------------------------------------------------------
@@ -84,101 +246,729 @@ int gabac_encode(
 namespace gabac {
 
 
-int encode(
-        const std::vector<int64_t>& symbols,
+static bool isValidConfiguration(
+        const BinarizationId& binarizationId,
+        const ContextSelectionId& contextSelectionId
+){
+    if (static_cast<unsigned int>(binarizationId) > static_cast<unsigned int>(BinarizationId::STEG))
+    {
+        return false;
+    }
+    return static_cast<unsigned int>(contextSelectionId) <= static_cast<unsigned int>(ContextSelectionId::raw);
+}
+
+
+static void writeUint32(
+        uint32_t value,
+        unsigned char *const bytes
+){
+    bytes[0] = static_cast<unsigned char>(value);
+    bytes[1] = static_cast<unsigned char>(value >> 8u);
+    bytes[2] = static_cast<unsigned char>(value >> 16u);
+    bytes[3] = static_cast<unsigned char>(value >> 24u);
+}
+
+
+size_t encodeBound(
+        size_t numSymbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId
+){
+    // Longest bin string of a symbol in the range allowed by the
+    // binarization (see binarizationInformation); an EG code word of a value
+    // below 2^31 has at most 63 bins
+    const size_t MAX_EG_BINS = 63;
+    size_t parameter = binarizationParameters.empty() ? 0 : binarizationParameters[0];
+    size_t maxBins = 0;
+    switch (binarizationId)
+    {
+        case BinarizationId::BI:
+        case BinarizationId::TU:
+            maxBins = parameter;
+            break;
+        case BinarizationId::EG:
+        case BinarizationId::SEG:
+            maxBins = MAX_EG_BINS;
+            break;
+        case BinarizationId::TEG:
+            maxBins = parameter + MAX_EG_BINS;
+            break;
+        case BinarizationId::STEG:
+            maxBins = parameter + MAX_EG_BINS + 1;
+            break;
+    }
+
+    // A bypass bin costs exactly one bit, an adaptive bin at most 7 (the
+    // smallest LPS range is 6, which takes 6 renormalization steps)
+    size_t maxBitsPerBin = 7;
+    if (contextSelectionId == ContextSelectionId::bypass || contextSelectionId == ContextSelectionId::raw)
+    {
+        maxBitsPerBin = 1;
+    }
+
+    // 32-bit symbol count, the payload and the final flush
+    const size_t OVERHEAD = 4 + 8;
+    return OVERHEAD + ((numSymbols * maxBins * maxBitsPerBin) + 7) / 8;
+}
+
+
+template<typename T>
+static int encodeWithWriter(
+        const T *const symbols,
+        size_t numSymbols,
         const BinarizationId& binarizationId,
         const std::vector<unsigned int>& binarizationParameters,
         const ContextSelectionId& contextSelectionId,
-        std::vector<unsigned char> *const bitstream
+        size_t maxNumBytes,
+        Writer *const writer
 ){
-    assert(bitstream != nullptr);
+    if (!isValidConfiguration(binarizationId, contextSelectionId))
+    {
+        return GABAC_FAILURE;
+    }
 #ifndef NDEBUG
     const unsigned int paramSize[unsigned(BinarizationId::STEG) + 1u] = {1, 1, 0, 0, 1, 1};
 #endif
     assert(binarizationParameters.size() >= paramSize[static_cast<int>(binarizationId)]);
 
+    bool raw = (contextSelectionId == ContextSelectionId::raw);
+    if (raw)
+    {
+        writer->startRaw(numSymbols);
+    }
+    else
+    {
+        writer->start(numSymbols);
+    }
+
+    if (!writer->writeValues(
+            symbols,
+            numSymbols,
+            binarizationId,
+            binarizationParameters,
+            contextSelectionId,
+            maxNumBytes
+    ))
+    {
+        return GABAC_BUDGET_EXCEEDED;
+    }
+
+    if (raw)
+    {
+        writer->finishRaw();
+    }
+    else
+    {
+        writer->reset();
+    }
+
+    return GABAC_SUCCESS;
+}
+
+
+template<typename T>
+int encode(
+        const std::vector<T>& symbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<unsigned char> *const bitstream,
+        size_t maxNumBytes
+){
+    assert(bitstream != nullptr);
+
     bitstream->clear();
 
     Writer writer(bitstream);
-    writer.start(symbols.size());
+    int ret = encodeWithWriter(
+            symbols.data(),
+            symbols.size(),
+            binarizationId,
+            binarizationParameters,
+            contextSelectionId,
+            maxNumBytes,
+            &writer
+    );
+    if (ret == GABAC_SUCCESS && bitstream->size() > maxNumBytes)
+    {
+        ret = GABAC_BUDGET_EXCEEDED;
+    }
+    if (ret == GABAC_BUDGET_EXCEEDED)
+    {
+        bitstream->clear();
+    }
+    return ret;
+}
+
+
+template int encode<int64_t>(
+        const std::vector<int64_t>& symbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<unsigned char> *bitstream,
+        size_t maxNumBytes
+);
+
+
+template int encode<uint8_t>(
+        const std::vector<uint8_t>& symbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<unsigned char> *bitstream,
+        size_t maxNumBytes
+);
+
+
+template int encode<uint16_t>(
+        const std::vector<uint16_t>& symbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<unsigned char> *bitstream,
+        size_t maxNumBytes
+);
+
+
+template int encode<uint32_t>(
+        const std::vector<uint32_t>& symbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<unsigned char> *bitstream,
+        size_t maxNumBytes
+);
+
+
+template int encode<uint64_t>(
+        const std::vector<uint64_t>& symbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<unsigned char> *bitstream,
+        size_t maxNumBytes
+);
+
+
+int encode(
+        const SymbolStream& symbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<unsigned char> *const bitstream,
+        size_t maxNumBytes
+){
+    switch (symbols.getWordSize())
+    {
+        case 1:
+            return encode(symbols.get<uint8_t>(), binarizationId, binarizationParameters, contextSelectionId,
+                          bitstream, maxNumBytes);
+        case 2:
+            return encode(symbols.get<uint16_t>(), binarizationId, binarizationParameters, contextSelectionId,
+                          bitstream, maxNumBytes);
+        case 4:
+            return encode(symbols.get<uint32_t>(), binarizationId, binarizationParameters, contextSelectionId,
+                          bitstream, maxNumBytes);
+        default:
+            return encode(symbols.get<uint64_t>(), binarizationId, binarizationParameters, contextSelectionId,
+                          bitstream, maxNumBytes);
+    }
+}
+
+
+template<typename T>
+int estimateBits(
+        const std::vector<T>& symbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        double *const numBits,
+        size_t maxNumBytes
+){
+    assert(numBits != nullptr);
+
+    // Raw coding is as cheap as estimating it
+    std::vector<unsigned char> bitstream;
+    Writer writer(&bitstream);
+    if (contextSelectionId != ContextSelectionId::raw)
+    {
+        writer.startEstimation();
+    }
+
+    int ret = encodeWithWriter(
+            symbols.data(),
+            symbols.size(),
+            binarizationId,
+            binarizationParameters,
+            contextSelectionId,
+            maxNumBytes,
+            &writer
+    );
+    if (ret != GABAC_SUCCESS)
+    {
+        return ret;
+    }
+
+    if (contextSelectionId == ContextSelectionId::raw)
+    {
+        *numBits = 8.0 * bitstream.size();
+    }
+    else
+    {
+        *numBits = std::ldexp(static_cast<double>(writer.getFracBits()), -int(cabactables::FRAC_BITS_PRECISION));
+    }
+    if (*numBits > 8.0 * maxNumBytes)
+    {
+        return GABAC_BUDGET_EXCEEDED;
+    }
+    return GABAC_SUCCESS;
+}
+
+
+template int estimateBits<int64_t>(
+        const std::vector<int64_t>& symbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        double *numBits,
+        size_t maxNumBytes
+);
+
+
+template int estimateBits<uint8_t>(
+        const std::vector<uint8_t>& symbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        double *numBits,
+        size_t maxNumBytes
+);
 
-    unsigned int previousSymbol = 0;
-    unsigned int previousPreviousSymbol = 0;
 
-    for (int64_t symbol : symbols)
+template int estimateBits<uint16_t>(
+        const std::vector<uint16_t>& symbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        double *numBits,
+        size_t maxNumBytes
+);
+
+
+template int estimateBits<uint32_t>(
+        const std::vector<uint32_t>& symbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        double *numBits,
+        size_t maxNumBytes
+);
+
+
+template int estimateBits<uint64_t>(
+        const std::vector<uint64_t>& symbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        double *numBits,
+        size_t maxNumBytes
+);
+
+
+int estimateBits(
+        const SymbolStream& symbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        double *const numBits,
+        size_t maxNumBytes
+){
+    switch (symbols.getWordSize())
     {
-        if (contextSelectionId == ContextSelectionId::bypass)
+        case 1:
+            return estimateBits(symbols.get<uint8_t>(), binarizationId, binarizationParameters, contextSelectionId,
+                                numBits, maxNumBytes);
+        case 2:
+            return estimateBits(symbols.get<uint16_t>(), binarizationId, binarizationParameters, contextSelectionId,
+                                numBits, maxNumBytes);
+        case 4:
+            return estimateBits(symbols.get<uint32_t>(), binarizationId, binarizationParameters, contextSelectionId,
+                                numBits, maxNumBytes);
+        default:
+            return estimateBits(symbols.get<uint64_t>(), binarizationId, binarizationParameters, contextSelectionId,
+                                numBits, maxNumBytes);
+    }
+}
+
+
+EncoderSession::EncoderSession()
+        : m_bitstream(),
+        m_writer(new Writer(&m_bitstream)){
+}
+
+
+EncoderSession::~EncoderSession() = default;
+
+
+int EncoderSession::encode(
+        const int64_t *const symbols,
+        size_t numSymbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId
+){
+    assert(symbols != nullptr || numSymbols == 0);
+
+    m_writer->restart();
+    return encodeWithWriter(
+            symbols,
+            numSymbols,
+            binarizationId,
+            binarizationParameters,
+            contextSelectionId,
+            std::numeric_limits<size_t>::max(),
+            m_writer.get()
+    );
+}
+
+
+const std::vector<unsigned char>& EncoderSession::getBitstream() const
+{
+    return m_bitstream;
+}
+
+
+const size_t StreamEncoder::DEFAULT_CHUNK_SIZE;
+
+
+StreamEncoder::StreamEncoder(
+        size_t chunkSize
+)
+        : m_chunkSize(chunkSize),
+        m_isStarted(false),
+        m_binarizationId(BinarizationId::BI),
+        m_binarizationParameters(),
+        m_contextSelectionId(ContextSelectionId::bypass),
+        m_sink(),
+        m_pendingSymbols(),
+        m_bitstream(),
+        m_writer(new Writer(&m_bitstream)){
+    assert(chunkSize > 0 && chunkSize <= std::numeric_limits<uint32_t>::max());
+}
+
+
+StreamEncoder::~StreamEncoder() = default;
+
+
+int StreamEncoder::begin(
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        const OutputSink& sink
+){
+    if (!isValidConfiguration(binarizationId, contextSelectionId))
+    {
+        return GABAC_FAILURE;
+    }
+    if (!sink)
+    {
+        return GABAC_FAILURE;
+    }
+
+    m_isStarted = true;
+    m_binarizationId = binarizationId;
+    m_binarizationParameters = binarizationParameters;
+    m_contextSelectionId = contextSelectionId;
+    m_sink = sink;
+    m_pendingSymbols.clear();
+    m_pendingSymbols.reserve(m_chunkSize);
+
+    return GABAC_SUCCESS;
+}
+
+
+int StreamEncoder::push(
+        const int64_t *symbols,
+        size_t numSymbols
+){
+    if (!m_isStarted)
+    {
+        return GABAC_FAILURE;
+    }
+    assert(symbols != nullptr || numSymbols == 0);
+
+    // Top up the pending chunk first
+    if (!m_pendingSymbols.empty())
+    {
+        size_t numCopied = std::min(numSymbols, m_chunkSize - m_pendingSymbols.size());
+        m_pendingSymbols.insert(m_pendingSymbols.end(), symbols, symbols + numCopied);
+        symbols += numCopied;
+        numSymbols -= numCopied;
+        if (m_pendingSymbols.size() < m_chunkSize)
         {
-            writer.writeBypassValue(
-                    symbol,
-                    binarizationId,
-                    binarizationParameters
-            );
+            return GABAC_SUCCESS;
         }
-        else if (contextSelectionId == ContextSelectionId::adaptive_coding_order_0)
+        int rc = writeChunk(m_pendingSymbols.data(), m_pendingSymbols.size());
+        m_pendingSymbols.clear();
+        if (rc != GABAC_SUCCESS)
         {
-            writer.writeCabacAdaptiveValue(
-                    symbol,
-                    binarizationId,
-                    binarizationParameters,
-                    0,
-                    0
-            );
+            return GABAC_FAILURE;
         }
-        else if (contextSelectionId == ContextSelectionId::adaptive_coding_order_1)
+    }
+
+    // Full chunks are coded straight from the caller's buffer
+    while (numSymbols >= m_chunkSize)
+    {
+        if (writeChunk(symbols, m_chunkSize) != GABAC_SUCCESS)
         {
-            writer.writeCabacAdaptiveValue(
-                    symbol,
-                    binarizationId,
-                    binarizationParameters,
-                    previousSymbol,
-                    0
-            );
-            if (symbol < 0)
-            {
-                symbol = -symbol;
-            }
-            if (symbol > 3)
-            {
-                previousSymbol = 3;
-            }
-            else
-            {
-                assert(symbol <= std::numeric_limits<unsigned int>::max());
-                previousSymbol = static_cast<unsigned int>(symbol);
-            }
+            return GABAC_FAILURE;
+        }
+        symbols += m_chunkSize;
+        numSymbols -= m_chunkSize;
+    }
+    m_pendingSymbols.insert(m_pendingSymbols.end(), symbols, symbols + numSymbols);
+
+    return GABAC_SUCCESS;
+}
+
+
+int StreamEncoder::finish(){
+    if (!m_isStarted)
+    {
+        return GABAC_FAILURE;
+    }
+
+    if (!m_pendingSymbols.empty())
+    {
+        int rc = writeChunk(m_pendingSymbols.data(), m_pendingSymbols.size());
+        m_pendingSymbols.clear();
+        if (rc != GABAC_SUCCESS)
+        {
+            return GABAC_FAILURE;
+        }
+    }
+
+    unsigned char terminator[2 * sizeof(uint32_t)] = {0};
+    m_sink(terminator, sizeof(terminator));
+    m_isStarted = false;
+
+    return GABAC_SUCCESS;
+}
+
+
+int StreamEncoder::writeChunk(
+        const int64_t *const symbols,
+        size_t numSymbols
+){
+    assert(numSymbols > 0 && numSymbols <= m_chunkSize);
+
+    m_writer->restart();
+    m_writer->writeValues(
+            symbols,
+            numSymbols,
+            m_binarizationId,
+            m_binarizationParameters,
+            m_contextSelectionId
+    );
+    if (m_contextSelectionId == ContextSelectionId::raw)
+    {
+        m_writer->finishRaw();
+    }
+    else
+    {
+        m_writer->reset();
+    }
+
+    if (m_bitstream.size() > std::numeric_limits<uint32_t>::max())
+    {
+        return GABAC_FAILURE;
+    }
+    unsigned char header[2 * sizeof(uint32_t)];
+    writeUint32(static_cast<uint32_t>(numSymbols), &header[0]);
+    writeUint32(static_cast<uint32_t>(m_bitstream.size()), &header[4]);
+    m_sink(header, sizeof(header));
+    m_sink(m_bitstream.data(), m_bitstream.size());
+
+    return GABAC_SUCCESS;
+}
+
+
+// Appends the blocks [firstBlock, lastBlock) to *bitstream and records the
+// offset of each block relative to baseOffset
+static void encodeBlockRun(
+        const std::vector<int64_t>& symbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        size_t blockSize,
+        size_t firstBlock,
+        size_t lastBlock,
+        size_t baseOffset,
+        std::vector<unsigned char> *const bitstream,
+        std::vector<size_t> *const blockOffsets
+){
+    // Each block is coded from freshly initialized contexts and ends with a
+    // flush of the arithmetic coder, so that it can be decoded on its own
+    Writer writer(bitstream);
+    bool raw = (contextSelectionId == ContextSelectionId::raw);
+    for (size_t block = firstBlock; block < lastBlock; block++)
+    {
+        blockOffsets->push_back(bitstream->size() - baseOffset);
+
+        size_t firstSymbol = block * blockSize;
+        writer.writeValues(
+                symbols.data() + firstSymbol,
+                std::min(blockSize, symbols.size() - firstSymbol),
+                binarizationId,
+                binarizationParameters,
+                contextSelectionId
+        );
+
+        if (raw)
+        {
+            writer.finishRaw();
         }
-        else if (contextSelectionId == ContextSelectionId::adaptive_coding_order_2)
+        else
         {
-            writer.writeCabacAdaptiveValue(
-                    symbol,
+            writer.reset();
+        }
+    }
+}
+
+
+int encodeBlocks(
+        const std::vector<int64_t>& symbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        size_t blockSize,
+        unsigned int numThreads,
+        std::vector<unsigned char> *const bitstream
+){
+    assert(bitstream != nullptr);
+
+    if (!isValidConfiguration(binarizationId, contextSelectionId))
+    {
+        return GABAC_FAILURE;
+    }
+#ifndef NDEBUG
+    const unsigned int paramSize[unsigned(BinarizationId::STEG) + 1u] = {1, 1, 0, 0, 1, 1};
+#endif
+    assert(binarizationParameters.size() >= paramSize[static_cast<int>(binarizationId)]);
+    if (blockSize == 0 || blockSize > std::numeric_limits<uint32_t>::max())
+    {
+        return GABAC_FAILURE;
+    }
+    if (symbols.size() > std::numeric_limits<uint32_t>::max())
+    {
+        return GABAC_FAILURE;
+    }
+
+    // Header: number of symbols, block size and the byte offset of each
+    // block relative to the end of the header (all 32 bit little-endian)
+    size_t numBlocks = (symbols.size() + blockSize - 1) / blockSize;
+    size_t headerSize = (2 + numBlocks) * sizeof(uint32_t);
+    bitstream->assign(headerSize, 0);
+    writeUint32(static_cast<uint32_t>(symbols.size()), &(*bitstream)[0]);
+    writeUint32(static_cast<uint32_t>(blockSize), &(*bitstream)[4]);
+
+    // Split the blocks into one contiguous run per thread. The first run is
+    // coded directly into the output, the others into buffers which are
+    // appended in order afterwards. Block borders only depend on blockSize,
+    // so the output is the same for any number of threads.
+    if (numThreads == 0)
+    {
+        numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    size_t numRuns = std::max(std::min(static_cast<size_t>(numThreads), numBlocks), static_cast<size_t>(1));
+    std::vector<std::vector<unsigned char>> runBitstreams(numRuns);
+    std::vector<std::vector<size_t>> runBlockOffsets(numRuns);
+    std::vector<std::exception_ptr> runExceptions(numRuns);
+
+    auto encodeRun = [&](size_t run)
+    {
+        try
+        {
+            std::vector<unsigned char> *runBitstream = (run == 0) ? bitstream : &runBitstreams[run];
+            encodeBlockRun(
+                    symbols,
                     binarizationId,
                     binarizationParameters,
-                    previousSymbol,
-                    previousPreviousSymbol
+                    contextSelectionId,
+                    blockSize,
+                    (run * numBlocks) / numRuns,
+                    ((run + 1) * numBlocks) / numRuns,
+                    runBitstream->size(),
+                    runBitstream,
+                    &runBlockOffsets[run]
             );
-            previousPreviousSymbol = previousSymbol;
-            if (symbol < 0)
-            {
-                symbol = -symbol;
-            }
-            if (symbol > 3)
-            {
-                previousSymbol = 3;
-            }
-            else
+        }
+        catch (...)
+        {
+            runExceptions[run] = std::current_exception();
+        }
+    };
+
+    // Runs for which no thread can be started are done on this thread
+    std::vector<std::thread> threads;
+    threads.reserve(numRuns - 1);
+    size_t nextRun = 1;
+    for (; nextRun < numRuns; nextRun++)
+    {
+        try
+        {
+            threads.emplace_back(encodeRun, nextRun);
+        }
+        catch (const std::system_error&)
+        {
+            break;
+        }
+    }
+    for (; nextRun < numRuns; nextRun++)
+    {
+        encodeRun(nextRun);
+    }
+    encodeRun(0);
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    for (const auto& exception : runExceptions)
+    {
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    // Concatenate the runs and fill in the block offsets
+    size_t block = 0;
+    for (size_t run = 0; run < numRuns; run++)
+    {
+        // Run 0 already sits at the start of the payload
+        size_t runOffset = (run == 0) ? 0 : (bitstream->size() - headerSize);
+        for (size_t blockOffset : runBlockOffsets[run])
+        {
+            if (runOffset + blockOffset > std::numeric_limits<uint32_t>::max())
             {
-                assert(symbol <= std::numeric_limits<unsigned int>::max());
-                previousSymbol = static_cast<unsigned int>(symbol);
+                return GABAC_FAILURE;
             }
+            writeUint32(
+                    static_cast<uint32_t>(runOffset + blockOffset),
+                    &(*bitstream)[(2 + block) * sizeof(uint32_t)]
+            );
+            block++;
         }
-        else
+        if (run > 0)
         {
-            return GABAC_FAILURE;
+            bitstream->insert(bitstream->end(), runBitstreams[run].begin(), runBitstreams[run].end());
+            runBitstreams[run].clear();
+            runBitstreams[run].shrink_to_fit();
         }
     }
-
-    writer.reset();
+    assert(block == numBlocks);
 
     return GABAC_SUCCESS;
 }
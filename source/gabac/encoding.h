@@ -23,10 +23,55 @@ int gabac_encode(
 );
 
 
+/* Upper bound of the size of the bitstream which gabac_encode() produces for
+ * symbolsSize symbols */
+int gabac_encode_bound(
+        size_t symbolsSize,
+        unsigned int binarizationId,
+        unsigned int *binarizationParameters,
+        size_t binarizationParametersSize,
+        unsigned int contextSelectionId,
+        size_t *bitstreamBound
+);
+
+
+/* Like gabac_encode(), but reads the symbols in place and writes the
+ * bitstream to a caller-provided buffer. If bitstreamCapacity is too small,
+ * GABAC_FAILURE is returned and *bitstreamSize holds the required size. */
+int gabac_encode_into(
+        const int64_t *symbols,
+        size_t symbolsSize,
+        unsigned int binarizationId,
+        unsigned int *binarizationParameters,
+        size_t binarizationParametersSize,
+        unsigned int contextSelectionId,
+        unsigned char *bitstream,
+        size_t bitstreamCapacity,
+        size_t *bitstreamSize
+);
+
+
+int gabac_encode_blocks(
+        int64_t *symbols,
+        size_t symbolsSize,
+        unsigned int binarizationId,
+        unsigned int *binarizationParameters,
+        size_t binarizationParametersSize,
+        unsigned int contextSelectionId,
+        size_t blockSize,
+        unsigned int numThreads,
+        unsigned char **bitstream,
+        size_t *bitstreamSize
+);
+
+
 #ifdef __cplusplus
 }  // extern "C"
 
 
+#include <functional>
+#include <limits>
+#include <memory>
 #include <vector>
 
 #include "gabac/constants.h"
@@ -35,15 +80,190 @@ int gabac_encode(
 namespace gabac {
 
 
+// T is int64_t or, for narrow unsigned data, one of uint8_t, uint16_t,
+// uint32_t and uint64_t; the bitstream does not depend on T.
+// If the bitstream would be larger than maxNumBytes, GABAC_BUDGET_EXCEEDED
+// is returned, as soon as the output passes the budget, and the bitstream
+// is left empty.
+template<typename T>
+int encode(
+        const std::vector<T>& symbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<unsigned char> *bitstream,
+        size_t maxNumBytes = std::numeric_limits<size_t>::max()
+);
+
+
+// Codes the symbols in the width they are held in
 int encode(
+        const SymbolStream& symbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        std::vector<unsigned char> *bitstream,
+        size_t maxNumBytes = std::numeric_limits<size_t>::max()
+);
+
+
+// Worst-case size of the bitstream produced by encode()
+size_t encodeBound(
+        size_t numSymbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId
+);
+
+
+// Codes the symbols in independent blocks of blockSize symbols: contexts are
+// reset and the arithmetic coder is flushed after each block. The stream
+// starts with an index of the block offsets, so that single blocks can be
+// decoded with decodeRange().
+// The blocks are coded by numThreads threads (0: one per hardware thread);
+// the output does not depend on the number of threads.
+int encodeBlocks(
         const std::vector<int64_t>& symbols,
         const BinarizationId& binarizationId,
         const std::vector<unsigned int>& binarizationParameters,
         const ContextSelectionId& contextSelectionId,
+        size_t blockSize,
+        unsigned int numThreads,
         std::vector<unsigned char> *bitstream
 );
 
 
+// Size in bits of the bitstream which encode() would produce, without
+// producing it: the adaptive bins are charged with the fractional costs of
+// their context states. The estimate is mostly within 0.5% of the actual
+// size; for the raw context selection it is exact. The byte budget works as
+// for encode().
+template<typename T>
+int estimateBits(
+        const std::vector<T>& symbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        double *numBits,
+        size_t maxNumBytes = std::numeric_limits<size_t>::max()
+);
+
+
+int estimateBits(
+        const SymbolStream& symbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        double *numBits,
+        size_t maxNumBytes = std::numeric_limits<size_t>::max()
+);
+
+
+class Writer;
+
+
+// Encoder for many short streams: the context table and the output buffer
+// are kept between calls, so that once the buffer has grown to the largest
+// stream size, encode() does not allocate anymore
+class EncoderSession
+{
+ public:
+    EncoderSession();
+
+    EncoderSession(const EncoderSession&) = delete;
+
+    EncoderSession& operator=(const EncoderSession&) = delete;
+
+    ~EncoderSession();
+
+    // Same as gabac::encode(); the result is available via getBitstream()
+    // until the next call
+    int encode(
+            const int64_t *symbols,
+            size_t numSymbols,
+            const BinarizationId& binarizationId,
+            const std::vector<unsigned int>& binarizationParameters,
+            const ContextSelectionId& contextSelectionId
+    );
+
+    const std::vector<unsigned char>& getBitstream() const;
+
+ private:
+    std::vector<unsigned char> m_bitstream;
+
+    std::unique_ptr<Writer> m_writer;
+};
+
+
+// Receives the output of a StreamEncoder piece by piece
+using OutputSink = std::function<void(const unsigned char *bytes, size_t numBytes)>;
+
+
+// Push-based encoder for streams of unknown, unbounded length. The symbols
+// are coded in independent chunks of at most chunkSize symbols, each of
+// which is handed to the sink as soon as it is complete:
+//
+//   chunk := numSymbols (32 bit LE), payloadSize (32 bit LE), payload
+//
+// The payload is coded like a block of encodeBlocks(). The stream ends with
+// a chunk with numSymbols == 0 and no payload.
+class StreamEncoder
+{
+ public:
+    static const size_t DEFAULT_CHUNK_SIZE = 1u << 16u;
+
+    explicit StreamEncoder(
+            size_t chunkSize = DEFAULT_CHUNK_SIZE
+    );
+
+    StreamEncoder(const StreamEncoder&) = delete;
+
+    StreamEncoder& operator=(const StreamEncoder&) = delete;
+
+    ~StreamEncoder();
+
+    int begin(
+            const BinarizationId& binarizationId,
+            const std::vector<unsigned int>& binarizationParameters,
+            const ContextSelectionId& contextSelectionId,
+            const OutputSink& sink
+    );
+
+    int push(
+            const int64_t *symbols,
+            size_t numSymbols
+    );
+
+    // Codes the pending symbols and terminates the stream
+    int finish();
+
+ private:
+    int writeChunk(
+            const int64_t *symbols,
+            size_t numSymbols
+    );
+
+    size_t m_chunkSize;
+
+    bool m_isStarted;
+
+    BinarizationId m_binarizationId;
+
+    std::vector<unsigned int> m_binarizationParameters;
+
+    ContextSelectionId m_contextSelectionId;
+
+    OutputSink m_sink;
+
+    // Symbols of the current, incomplete chunk
+    std::vector<int64_t> m_pendingSymbols;
+
+    std::vector<unsigned char> m_bitstream;
+
+    std::unique_ptr<Writer> m_writer;
+};
+
+
 }  // namespace gabac
 
 #endif  /* __cplusplus */
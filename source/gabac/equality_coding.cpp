@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <stdexcept>
 
 #include "gabac/return_codes.h"
 
@@ -99,85 +100,309 @@ int gabac_inverseTransformEqualityCoding(
 }
 
 
+
+int gabac_transformEqualityCodingInto(
+        const uint64_t *const symbols,
+        const size_t symbolsSize,
+        uint64_t *const equalityFlags,
+        const size_t equalityFlagsCapacity,
+        uint64_t *const values,
+        const size_t valuesCapacity,
+        size_t *const valuesSize
+){
+    if ((symbols == nullptr || equalityFlags == nullptr || values == nullptr) && symbolsSize > 0)
+    {
+        return GABAC_FAILURE;
+    }
+    if (valuesSize == nullptr)
+    {
+        return GABAC_FAILURE;
+    }
+    if (equalityFlagsCapacity < symbolsSize || valuesCapacity < symbolsSize)
+    {
+        return GABAC_FAILURE;
+    }
+
+    *valuesSize = gabac::transformEqualityCoding(symbols, symbolsSize, equalityFlags, values);
+
+    return GABAC_SUCCESS;
+}
+
+
+int gabac_inverseTransformEqualityCodingInto(
+        const uint64_t *const equalityFlags,
+        const size_t equalityFlagsSize,
+        const uint64_t *const values,
+        const size_t valuesSize,
+        uint64_t *const symbols,
+        const size_t symbolsCapacity
+){
+    if ((equalityFlags == nullptr || symbols == nullptr) && equalityFlagsSize > 0)
+    {
+        return GABAC_FAILURE;
+    }
+    if (values == nullptr && valuesSize > 0)
+    {
+        return GABAC_FAILURE;
+    }
+    if (symbolsCapacity < equalityFlagsSize)
+    {
+        return GABAC_FAILURE;
+    }
+
+    try
+    {
+        gabac::inverseTransformEqualityCoding(equalityFlags, equalityFlagsSize, values, valuesSize, symbols);
+    }
+    catch (...)
+    {
+        return GABAC_FAILURE;
+    }
+
+    return GABAC_SUCCESS;
+}
+
+
 namespace gabac {
 
 
+// The previous symbol only changes where a symbol differs from it, so it is
+// always the preceding input symbol. The flags are therefore a plain
+// compare with the preceding symbol, which is vectorized, and the values
+// are gathered without branches: every symbol is stored, but the value
+// count only advances past the differing ones.
+template<typename T, typename F>
+size_t transformEqualityCoding(
+        const T *const symbols,
+        size_t symbolsSize,
+        F *const equalityFlags,
+        T *const values
+){
+    if (symbolsSize == 0)
+    {
+        return 0;
+    }
+
+    equalityFlags[0] = static_cast<F>(symbols[0] == 0);
+    for (size_t i = 1; i < symbolsSize; i++)
+    {
+        equalityFlags[i] = static_cast<F>(symbols[i] == symbols[i - 1]);
+    }
+
+    size_t valuesSize = 0;
+    T previousSymbol = 0;
+    for (size_t i = 0; i < symbolsSize; i++)
+    {
+        T symbol = symbols[i];
+        values[valuesSize] = static_cast<T>(symbol - (symbol > previousSymbol));
+        valuesSize += 1 - equalityFlags[i];
+        previousSymbol = symbol;
+    }
+
+    return valuesSize;
+}
+
+// ----------------------------------------------------------------------------
+
+// The values are first decoded on their own to the differing symbols,
+// which are written to the front of symbols. A backward pass then spreads
+// them out: the number of differing symbols up to each position is the
+// index of the symbol it repeats. Reading never overtakes writing, as that
+// index is never larger than the position.
+template<typename T, typename F>
+void inverseTransformEqualityCoding(
+        const F *const equalityFlags,
+        size_t equalityFlagsSize,
+        const T *const values,
+        size_t valuesSize,
+        T *const symbols
+){
+    size_t numValues = 0;
+    for (size_t i = 0; i < equalityFlagsSize; i++)
+    {
+        numValues += (equalityFlags[i] != 1);
+    }
+    if (numValues > valuesSize)
+    {
+        throw std::out_of_range("inverseTransformEqualityCoding: too few values");
+    }
+
+    // Re-compute the differing symbols from the values
+    T previousSymbol = 0;
+    for (size_t i = 0; i < numValues; i++)
+    {
+        T value = values[i];
+        previousSymbol = static_cast<T>(value + (value >= previousSymbol));
+        symbols[i] = previousSymbol;
+    }
+
+    // Expand them to where the equality flags are set
+    size_t valuesIdx = numValues;
+    size_t i = equalityFlagsSize;
+    while (valuesIdx > 0)
+    {
+        i--;
+        symbols[i] = symbols[valuesIdx - 1];
+        valuesIdx -= (equalityFlags[i] != 1);
+    }
+    std::fill(symbols, symbols + i, T(0));
+}
+
+// ----------------------------------------------------------------------------
+
+template<typename T, typename F>
 void transformEqualityCoding(
-        const std::vector<uint64_t>& symbols,
-        std::vector<uint64_t> *const equalityFlags,
-        std::vector<uint64_t> *const values
+        const std::vector<T>& symbols,
+        std::vector<F> *const equalityFlags,
+        std::vector<T> *const values
 ){
     assert(equalityFlags != nullptr);
     assert(values != nullptr);
 
     // Prepare the output vectors
-    equalityFlags->clear();
-    values->clear();
-
-    // Leave everything empty if we do not have any symbols
-    if (symbols.empty())
-    {
-        return;
-    }
-    uint64_t previousSymbol = 0;
-    for (uint64_t symbol : symbols)
-    {
-        if (symbol == previousSymbol)
-        {
-            equalityFlags->push_back(1);
-        }
-        else
-        {
-            equalityFlags->push_back(0);
-            if (symbol > previousSymbol)
-            {
-                values->push_back(symbol - 1);
-            }
-            else
-            {
-                values->push_back(symbol);
-            }
-            previousSymbol = symbol;
-        }
-    }
+    equalityFlags->resize(symbols.size());
+    values->resize(symbols.size());
+
+    size_t valuesSize = transformEqualityCoding(symbols.data(), symbols.size(), equalityFlags->data(), values->data());
+    values->resize(valuesSize);
 }
 
 // ----------------------------------------------------------------------------
 
+template<typename T, typename F>
 void inverseTransformEqualityCoding(
-        const std::vector<uint64_t>& equalityFlags,
-        const std::vector<uint64_t>& values,
-        std::vector<uint64_t> *const symbols
+        const std::vector<F>& equalityFlags,
+        const std::vector<T>& values,
+        std::vector<T> *const symbols
 ){
     assert(symbols != nullptr);
 
     // Prepare the output vector
-    symbols->clear();
-
-    // Re-compute the symbols from the equality flags and values
-    uint64_t previousSymbol = 0;
-    size_t valuesIdx = 0;
-    for (size_t i = 0; i < equalityFlags.size(); i++)
-    {
-        if (equalityFlags[i] == 1)
-        {
-            symbols->push_back(previousSymbol);
-        }
-        else
-        {
-            if (values[valuesIdx] >= previousSymbol)
-            {
-                symbols->push_back(values[valuesIdx] + 1);
-            }
-            else
-            {
-                symbols->push_back(values[valuesIdx]);
-            }
-            previousSymbol = (*symbols)[i];
-            valuesIdx++;
-        }
-    }
+    symbols->resize(equalityFlags.size());
+
+    inverseTransformEqualityCoding(equalityFlags.data(), equalityFlags.size(), values.data(), values.size(),
+                                   symbols->data());
 }
 
 
+
+// The C interface works on 64-bit flags, the gabacify pipeline on 8-bit flags
+// (see SymbolStream)
+template size_t transformEqualityCoding<uint64_t, uint64_t>(
+        const uint64_t *symbols,
+        size_t symbolsSize,
+        uint64_t *equalityFlags,
+        uint64_t *values
+);
+template void inverseTransformEqualityCoding<uint64_t, uint64_t>(
+        const uint64_t *equalityFlags,
+        size_t equalityFlagsSize,
+        const uint64_t *values,
+        size_t valuesSize,
+        uint64_t *symbols
+);
+template void transformEqualityCoding<uint64_t, uint64_t>(
+        const std::vector<uint64_t>& symbols,
+        std::vector<uint64_t> *equalityFlags,
+        std::vector<uint64_t> *values
+);
+template void inverseTransformEqualityCoding<uint64_t, uint64_t>(
+        const std::vector<uint64_t>& equalityFlags,
+        const std::vector<uint64_t>& values,
+        std::vector<uint64_t> *symbols
+);
+template size_t transformEqualityCoding<uint8_t, uint8_t>(
+        const uint8_t *symbols,
+        size_t symbolsSize,
+        uint8_t *equalityFlags,
+        uint8_t *values
+);
+template void inverseTransformEqualityCoding<uint8_t, uint8_t>(
+        const uint8_t *equalityFlags,
+        size_t equalityFlagsSize,
+        const uint8_t *values,
+        size_t valuesSize,
+        uint8_t *symbols
+);
+template void transformEqualityCoding<uint8_t, uint8_t>(
+        const std::vector<uint8_t>& symbols,
+        std::vector<uint8_t> *equalityFlags,
+        std::vector<uint8_t> *values
+);
+template void inverseTransformEqualityCoding<uint8_t, uint8_t>(
+        const std::vector<uint8_t>& equalityFlags,
+        const std::vector<uint8_t>& values,
+        std::vector<uint8_t> *symbols
+);
+template size_t transformEqualityCoding<uint16_t, uint8_t>(
+        const uint16_t *symbols,
+        size_t symbolsSize,
+        uint8_t *equalityFlags,
+        uint16_t *values
+);
+template void inverseTransformEqualityCoding<uint16_t, uint8_t>(
+        const uint8_t *equalityFlags,
+        size_t equalityFlagsSize,
+        const uint16_t *values,
+        size_t valuesSize,
+        uint16_t *symbols
+);
+template void transformEqualityCoding<uint16_t, uint8_t>(
+        const std::vector<uint16_t>& symbols,
+        std::vector<uint8_t> *equalityFlags,
+        std::vector<uint16_t> *values
+);
+template void inverseTransformEqualityCoding<uint16_t, uint8_t>(
+        const std::vector<uint8_t>& equalityFlags,
+        const std::vector<uint16_t>& values,
+        std::vector<uint16_t> *symbols
+);
+template size_t transformEqualityCoding<uint32_t, uint8_t>(
+        const uint32_t *symbols,
+        size_t symbolsSize,
+        uint8_t *equalityFlags,
+        uint32_t *values
+);
+template void inverseTransformEqualityCoding<uint32_t, uint8_t>(
+        const uint8_t *equalityFlags,
+        size_t equalityFlagsSize,
+        const uint32_t *values,
+        size_t valuesSize,
+        uint32_t *symbols
+);
+template void transformEqualityCoding<uint32_t, uint8_t>(
+        const std::vector<uint32_t>& symbols,
+        std::vector<uint8_t> *equalityFlags,
+        std::vector<uint32_t> *values
+);
+template void inverseTransformEqualityCoding<uint32_t, uint8_t>(
+        const std::vector<uint8_t>& equalityFlags,
+        const std::vector<uint32_t>& values,
+        std::vector<uint32_t> *symbols
+);
+template size_t transformEqualityCoding<uint64_t, uint8_t>(
+        const uint64_t *symbols,
+        size_t symbolsSize,
+        uint8_t *equalityFlags,
+        uint64_t *values
+);
+template void inverseTransformEqualityCoding<uint64_t, uint8_t>(
+        const uint8_t *equalityFlags,
+        size_t equalityFlagsSize,
+        const uint64_t *values,
+        size_t valuesSize,
+        uint64_t *symbols
+);
+template void transformEqualityCoding<uint64_t, uint8_t>(
+        const std::vector<uint64_t>& symbols,
+        std::vector<uint8_t> *equalityFlags,
+        std::vector<uint64_t> *values
+);
+template void inverseTransformEqualityCoding<uint64_t, uint8_t>(
+        const std::vector<uint8_t>& equalityFlags,
+        const std::vector<uint64_t>& values,
+        std::vector<uint64_t> *symbols
+);
+
+
 }  // namespace gabac
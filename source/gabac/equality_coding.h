@@ -29,6 +29,30 @@ int gabac_inverseTransformEqualityCoding(
 );
 
 
+// Caller-buffer variants: nothing is allocated or copied. equalityFlags,
+// values and symbols need a capacity of symbolsSize / equalityFlagsSize
+// elements.
+int gabac_transformEqualityCodingInto(
+        const uint64_t *symbols,
+        size_t symbolsSize,
+        uint64_t *equalityFlags,
+        size_t equalityFlagsCapacity,
+        uint64_t *values,
+        size_t valuesCapacity,
+        size_t *valuesSize
+);
+
+
+int gabac_inverseTransformEqualityCodingInto(
+        const uint64_t *equalityFlags,
+        size_t equalityFlagsSize,
+        const uint64_t *values,
+        size_t valuesSize,
+        uint64_t *symbols,
+        size_t symbolsCapacity
+);
+
+
 #ifdef __cplusplus
 }  // extern "C"
 
@@ -39,17 +63,42 @@ int gabac_inverseTransformEqualityCoding(
 namespace gabac {
 
 
+// T is one of uint8_t, uint16_t, uint32_t and uint64_t, the type of the
+// flags F is uint8_t or uint64_t
+template<typename T, typename F>
 void transformEqualityCoding(
-        const std::vector<uint64_t>& symbols,
-        std::vector<uint64_t> *equalityFlags,
-        std::vector<uint64_t> *values
+        const std::vector<T>& symbols,
+        std::vector<F> *equalityFlags,
+        std::vector<T> *values
 );
 
 
+template<typename T, typename F>
 void inverseTransformEqualityCoding(
-        const std::vector<uint64_t>& equalityFlags,
-        const std::vector<uint64_t>& values,
-        std::vector<uint64_t> *symbols
+        const std::vector<F>& equalityFlags,
+        const std::vector<T>& values,
+        std::vector<T> *symbols
+);
+
+
+// Versions on plain arrays. The forward transform returns the number of
+// values; both outputs must hold symbolsSize elements.
+template<typename T, typename F>
+size_t transformEqualityCoding(
+        const T *symbols,
+        size_t symbolsSize,
+        F *equalityFlags,
+        T *values
+);
+
+
+template<typename T, typename F>
+void inverseTransformEqualityCoding(
+        const F *equalityFlags,
+        size_t equalityFlagsSize,
+        const T *values,
+        size_t valuesSize,
+        T *symbols
 );
 
 
@@ -2,10 +2,14 @@
 
 #include <algorithm>
 #include <cassert>
+#include <exception>
 #include <iostream>
 #include <limits>
-#include <unordered_map>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include "gabac/return_codes.h"
 
@@ -75,120 +79,679 @@ int gabac_inverseTransformLutTransform0(
     return GABAC_SUCCESS;
 }
 
+int gabac_transformLutTransform0Into(
+        const uint64_t *const symbols,
+        const size_t symbolsSize,
+        uint64_t *const transformedSymbols,
+        const size_t transformedSymbolsCapacity,
+        uint64_t *const inverseLUT,
+        const size_t inverseLUTCapacity,
+        size_t *const inverseLUTSize
+){
+    if ((symbols == nullptr || transformedSymbols == nullptr || inverseLUT == nullptr) && symbolsSize > 0)
+    {
+        return GABAC_FAILURE;
+    }
+    if (inverseLUTSize == nullptr)
+    {
+        return GABAC_FAILURE;
+    }
+    if (transformedSymbolsCapacity < symbolsSize || inverseLUTCapacity < symbolsSize)
+    {
+        return GABAC_FAILURE;
+    }
+
+    *inverseLUTSize = gabac::transformLutTransform0(symbols, symbolsSize, transformedSymbols, inverseLUT);
+
+    return GABAC_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+int gabac_inverseTransformLutTransform0Into(
+        const uint64_t *const transformedSymbols,
+        const size_t transformedSymbolsSize,
+        const uint64_t *const inverseLUT,
+        const size_t inverseLUTSize,
+        uint64_t *const symbols,
+        const size_t symbolsCapacity
+){
+    if ((transformedSymbols == nullptr || symbols == nullptr) && transformedSymbolsSize > 0)
+    {
+        return GABAC_FAILURE;
+    }
+    if (inverseLUT == nullptr && inverseLUTSize > 0)
+    {
+        return GABAC_FAILURE;
+    }
+    if (symbolsCapacity < transformedSymbolsSize)
+    {
+        return GABAC_FAILURE;
+    }
+
+    gabac::inverseTransformLutTransform0(transformedSymbols, transformedSymbolsSize, inverseLUT, inverseLUTSize,
+                                         symbols);
+
+    return GABAC_SUCCESS;
+}
+
 // ----------------------------------------------------------------------------
 // C wrapper END
 // ----------------------------------------------------------------------------
 
 namespace gabac {
 
+// ----------------------------------------------------------------------------
+
+namespace {
+
+
+// Value per symbol: a directly indexed table for symbols of up to 16 bits,
+// an open-addressing hash table with linear probing for wider ones. Entries
+// which were never accessed read as 0 and are not visited by forEach().
+template<typename T, bool DENSE = (sizeof(T) <= 2)>
+class SymbolTable;
+
+
+template<typename T>
+class SymbolTable<T, true>
+{
+ public:
+    SymbolTable()
+            : m_values(size_t(1) << (8 * sizeof(T)), 0){
+    }
+
+    uint64_t& operator[](const T symbol){
+        return m_values[symbol];
+    }
+
+    uint64_t at(const T symbol) const {
+        return m_values[symbol];
+    }
+
+    // Number of entries which are not 0
+    size_t size() const {
+        return static_cast<size_t>(std::count_if(m_values.begin(), m_values.end(), [](uint64_t v)
+        {
+            return v != 0;
+        }));
+    }
+
+    template<typename F>
+    void forEach(F f) const {
+        for (size_t symbol = 0; symbol < m_values.size(); symbol++)
+        {
+            if (m_values[symbol] != 0)
+            {
+                f(static_cast<T>(symbol), m_values[symbol]);
+            }
+        }
+    }
+
+    // Counts the symbols; never gives up, as the table has room for all
+    // symbols anyway
+    bool count(
+            const T *const symbols,
+            const size_t symbolsSize,
+            const size_t
+    ){
+        for (size_t i = 0; i < symbolsSize; i++)
+        {
+            m_values[symbols[i]]++;
+        }
+        return true;
+    }
+
+ private:
+    std::vector<uint64_t> m_values;
+};
+
+
+template<typename T>
+class SymbolTable<T, false>
+{
+ public:
+    SymbolTable()
+            : m_keys(),
+            m_values(),
+            m_used(),
+            m_size(0),
+            m_mask(0){
+        rehash(1024);
+    }
+
+    uint64_t& operator[](const T symbol){
+        size_t slot = find(symbol);
+        if (!m_used[slot])
+        {
+            if (2 * (m_size + 1) > m_keys.size())
+            {
+                rehash(2 * m_keys.size());
+                slot = find(symbol);
+            }
+            m_used[slot] = 1;
+            m_keys[slot] = symbol;
+            m_values[slot] = 0;
+            m_size++;
+        }
+        return m_values[slot];
+    }
+
+    uint64_t at(const T symbol) const {
+        size_t slot = find(symbol);
+        return m_used[slot] ? m_values[slot] : 0;
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+
+    template<typename F>
+    void forEach(F f) const {
+        for (size_t slot = 0; slot < m_keys.size(); slot++)
+        {
+            if (m_used[slot])
+            {
+                f(m_keys[slot], m_values[slot]);
+            }
+        }
+    }
+
+    // Counts the symbols; gives up as soon as maxSize different symbols
+    // were seen
+    bool count(
+            const T *const symbols,
+            const size_t symbolsSize,
+            const size_t maxSize
+    ){
+        for (size_t i = 0; i < symbolsSize; i++)
+        {
+            (*this)[symbols[i]]++;
+            if (m_size >= maxSize)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+ private:
+    size_t find(
+            const T symbol
+    ) const {
+        uint64_t hash = static_cast<uint64_t>(symbol) * 0x9E3779B97F4A7C15ull;
+        size_t slot = static_cast<size_t>(hash ^ (hash >> 32)) & m_mask;
+        while (m_used[slot] && m_keys[slot] != symbol)
+        {
+            slot = (slot + 1) & m_mask;
+        }
+        return slot;
+    }
+
+    void rehash(
+            const size_t capacity
+    ){
+        std::vector<T> keys(capacity);
+        std::vector<uint64_t> values(capacity);
+        std::vector<uint8_t> used(capacity, 0);
+        keys.swap(m_keys);
+        values.swap(m_values);
+        used.swap(m_used);
+        m_mask = capacity - 1;
+        for (size_t slot = 0; slot < keys.size(); slot++)
+        {
+            if (used[slot])
+            {
+                size_t newSlot = find(keys[slot]);
+                m_used[newSlot] = 1;
+                m_keys[newSlot] = keys[slot];
+                m_values[newSlot] = values[slot];
+            }
+        }
+    }
+
+    std::vector<T> m_keys;
+
+    std::vector<uint64_t> m_values;
+
+    std::vector<uint8_t> m_used;
+
+    size_t m_size;
+
+    size_t m_mask;
+};
+
+
+}  // namespace
+
+// ----------------------------------------------------------------------------
+
+// Histogram of the symbols. Large inputs are split into one shard per
+// thread (numThreads, 0: one per hardware thread), which are counted
+// concurrently and merged afterwards. Shards for which no thread can be
+// started are counted on the calling thread. Returns false if there are
+// maxSize or more different symbols.
+template<typename T>
+static bool countSymbols(
+        const T *const symbols,
+        const size_t symbolsSize,
+        const size_t maxSize,
+        unsigned int numThreads,
+        SymbolTable<T> *const histogram
+){
+    if (numThreads == 0)
+    {
+        numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    const size_t MIN_SHARD_SIZE = 1u << 18u;
+    size_t numShards = std::min(
+            static_cast<size_t>(numThreads),
+            std::max(symbolsSize / MIN_SHARD_SIZE, size_t(1))
+    );
+    if (numShards == 1)
+    {
+        return histogram->count(symbols, symbolsSize, maxSize);
+    }
+
+    std::vector<SymbolTable<T>> shards(numShards - 1);
+    std::vector<uint8_t> shardComplete(numShards, 0);
+    std::vector<std::exception_ptr> shardExceptions(numShards);
+    auto countShard = [&](size_t shard)
+    {
+        try
+        {
+            size_t begin = (shard * symbolsSize) / numShards;
+            size_t end = ((shard + 1) * symbolsSize) / numShards;
+            SymbolTable<T> *table = (shard == 0) ? histogram : &shards[shard - 1];
+            shardComplete[shard] = table->count(symbols + begin, end - begin, maxSize);
+        }
+        catch (...)
+        {
+            shardExceptions[shard] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(numShards - 1);
+    size_t nextShard = 1;
+    for (; nextShard < numShards; nextShard++)
+    {
+        try
+        {
+            threads.emplace_back(countShard, nextShard);
+        }
+        catch (const std::system_error&)
+        {
+            break;
+        }
+    }
+    for (; nextShard < numShards; nextShard++)
+    {
+        countShard(nextShard);
+    }
+    countShard(0);
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    for (const auto& exception : shardExceptions)
+    {
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    // Each shard sees at most as many different symbols as the whole input
+    for (size_t shard = 0; shard < numShards; shard++)
+    {
+        if (!shardComplete[shard])
+        {
+            return false;
+        }
+    }
+    for (const auto& shard : shards)
+    {
+        shard.forEach([histogram](T symbol, uint64_t count)
+                      {
+                          (*histogram)[symbol] += count;
+                      });
+    }
+    return histogram->size() < maxSize;
+}
+
+// ----------------------------------------------------------------------------
+
+// Histogram of the candidates for a partial LUT, for inputs with too many
+// different symbols to count all of them. The candidates are selected with
+// a frequent-items summary of at most maxSize entries: whenever it is full,
+// only the maxSize / 2 most frequent entries are kept, and their counts are
+// lowered by the smallest kept count. This keeps every symbol which is more
+// frequent than 2 * symbolsSize / maxSize, and always more than maxSize / 2
+// candidates. The candidates are then counted exactly in a second pass; all
+// counts are 1 too high, which does not change their ranking.
+template<typename T>
+static void countPartialLutCandidates(
+        const T *const symbols,
+        const size_t symbolsSize,
+        const size_t maxSize,
+        SymbolTable<T> *const histogram
+){
+    SymbolTable<T> summary;
+    std::vector<std::pair<T, uint64_t>> entries;
+    for (size_t i = 0; i < symbolsSize; i++)
+    {
+        summary[symbols[i]]++;
+        if (summary.size() < maxSize)
+        {
+            continue;
+        }
+        entries.clear();
+        summary.forEach([&entries](T symbol, uint64_t count)
+                        {
+                            entries.emplace_back(symbol, count);
+                        });
+        const size_t numKept = maxSize / 2;
+        std::nth_element(entries.begin(), entries.begin() + (numKept - 1), entries.end(),
+                         [](const std::pair<T, uint64_t>& a, const std::pair<T, uint64_t>& b)
+                         {
+                             return a.second > b.second;
+                         });
+        const uint64_t threshold = entries[numKept - 1].second;
+        summary = SymbolTable<T>();
+        for (size_t e = 0; e < numKept; e++)
+        {
+            summary[entries[e].first] = entries[e].second - threshold;
+        }
+    }
+
+    *histogram = SymbolTable<T>();
+    summary.forEach([histogram](T symbol, uint64_t)
+                    {
+                        (*histogram)[symbol] = 1;
+                    });
+    for (size_t i = 0; i < symbolsSize; i++)
+    {
+        if (histogram->at(symbols[i]) != 0)
+        {
+            (*histogram)[symbols[i]]++;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+// Symbols sorted by descending frequency; the forward LUT maps each symbol
+// to its position in the inverse LUT plus 1, so that symbols without a rank
+// read as 0 (see lut0Rank()). With too many different symbols, no LUT is
+// built, or, if allowPartial, a partial one of the PARTIAL_LUT_SIZE most
+// frequent symbols.
+template<typename T>
 static void inferLut0(
-        const std::vector<uint64_t>& symbols,
-        std::vector<std::pair<uint64_t, uint64_t>> *const lut,
-        std::vector<uint64_t> *const inverseLut
+        const T *const symbols,
+        const size_t symbolsSize,
+        const bool allowPartial,
+        const unsigned int numThreads,
+        SymbolTable<T> *const lut,
+        std::vector<T> *const inverseLut
 ){
     // Clear
-    lut->clear();
     inverseLut->clear();
-    if (symbols.empty())
+    if (symbolsSize == 0)
     {
         return;
     }
 
-    std::unordered_map<uint64_t, uint64_t> freq;
+    const size_t MAX_LUT_SIZE = 1u << 20u; // 8MB table
+    // The histogram for a partial LUT is bounded as well
+    const size_t MAX_PARTIAL_LUT_HISTOGRAM_SIZE = 2 * (PARTIAL_LUT_SIZE + 1);
+    SymbolTable<T> freq;
+    if (!countSymbols(symbols, symbolsSize, allowPartial ? MAX_PARTIAL_LUT_HISTOGRAM_SIZE : MAX_LUT_SIZE,
+                      numThreads, &freq))
+    {
+        if (!allowPartial)
+        {
+            return;
+        }
+        countPartialLutCandidates(symbols, symbolsSize, MAX_PARTIAL_LUT_HISTOGRAM_SIZE, &freq);
+    }
 
+    std::vector<std::pair<T, uint64_t>> freqVec;
+    freqVec.reserve(freq.size());
+    freq.forEach([&freqVec](T symbol, uint64_t count)
+                 {
+                     freqVec.emplace_back(symbol, count);
+                 });
 
-    const size_t MAX_LUT_SIZE = 1u << 20u; // 8MB table
-    for (const auto& symbol : symbols)
+    // Sort symbol frequencies in descending order
+    auto moreFrequent = [](const std::pair<T, uint64_t>& a,
+                           const std::pair<T, uint64_t>& b
+    )
+    {
+        if (a.second > b.second)
+        {
+            return true;
+        }
+        if (a.second < b.second)
+        {
+            return false;
+        }
+        return a.first < b.first;
+    };
+    size_t lutSize = freqVec.size();
+    if (allowPartial && lutSize >= PARTIAL_LUT_SIZE)
     {
-        freq[symbol]++;
-        if(freq.size() >= MAX_LUT_SIZE) {
+        lutSize = PARTIAL_LUT_SIZE;
+        if (freqVec.size() > lutSize)
+        {
+            std::nth_element(freqVec.begin(), freqVec.begin() + lutSize, freqVec.end(), moreFrequent);
+        }
+    }
+    std::sort(freqVec.begin(), freqVec.begin() + lutSize, moreFrequent);
+
+    inverseLut->reserve(lutSize);
+    for (size_t i = 0; i < lutSize; i++)
+    {
+        (*lut)[freqVec[i].first] = i + 1;
+        inverseLut->emplace_back(freqVec[i].first);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+// Order-0 rank of symbol; lut0Size (the escape) if it has none
+template<typename T>
+inline uint64_t lut0Rank(
+        const SymbolTable<T>& lut0,
+        const uint64_t lut0Size,
+        const T symbol
+){
+    return std::min(lut0.at(symbol) - 1, lut0Size);
+}
+
+// ----------------------------------------------------------------------------
+
+// Index of the current order-0 rank lastSymbols[0] in the context of the
+// ORDER previous ones, as used for the higher-order LUTs. The alphabet of
+// the order-0 ranks includes the escape, i.e. it is the size of the order-0
+// LUT plus 1.
+static uint64_t lutIndex(
+        const size_t ORDER,
+        const std::vector<uint64_t>& lastSymbols,
+        const uint64_t alphabetSize
+){
+    uint64_t index = 0;
+    for (size_t i = ORDER; i > 0; --i)
+    {
+        index *= alphabetSize;
+        index += lastSymbols[i];
+    }
+    index *= alphabetSize;
+    index += lastSymbols[0];
+    return index;
+}
+
+// ----------------------------------------------------------------------------
+
+static void updateHistory(
+        const size_t ORDER,
+        const uint64_t symbol,
+        std::vector<uint64_t> *const lastSymbols
+){
+    for (size_t i = ORDER; i > 0; --i)
+    {
+        (*lastSymbols)[i] = (*lastSymbols)[i - 1];
+    }
+    (*lastSymbols)[0] = symbol;
+}
+
+// ----------------------------------------------------------------------------
+
+// Ranks the order-0 ranks again among all which follow the same ORDER
+// previous ones. Only the (context, symbol) pairs which occur are stored,
+// so the tables grow with the input, not with alphabetSize^(ORDER+1). The
+// forward LUT maps the index of a pair to its rank. The inverse LUT is
+// stored per context as the ORDER context ranks, the number of symbols
+// in the context and the order-0 ranks of these symbols by descending
+// frequency.
+template<typename T>
+static void inferLutHigherOrder(
+        const size_t ORDER,
+        const T *const symbols,
+        const size_t symbolsSize,
+        const SymbolTable<T>& lut0,
+        const uint64_t lut0Size,
+        SymbolTable<uint64_t> *const lut,
+        std::vector<uint32_t> *const inverseLut
+){
+    inverseLut->clear();
+
+    const uint64_t alphabetSize = lut0Size + 1;
+    const size_t MAX_LUT_SIZE = 1u << 20u;
+    SymbolTable<uint64_t> freq;
+    std::vector<uint64_t> lastSymbols(ORDER + 1, 0);
+    for (size_t j = 0; j < symbolsSize; j++)
+    {
+        updateHistory(ORDER, lut0Rank(lut0, lut0Size, symbols[j]), &lastSymbols);
+        freq[lutIndex(ORDER, lastSymbols, alphabetSize)]++;
+        if (freq.size() >= MAX_LUT_SIZE)
+        {
             return;
         }
     }
 
     std::vector<std::pair<uint64_t, uint64_t>> freqVec;
-    std::copy(freq.begin(), freq.end(), std::back_inserter(freqVec));
+    freqVec.reserve(freq.size());
+    freq.forEach([&freqVec](uint64_t index, uint64_t count)
+                 {
+                     freqVec.emplace_back(index, count);
+                 });
 
-    // Sort symbol frequencies in descending order
+    // Group by context, then sort by descending frequency within each
     std::sort(
             freqVec.begin(), freqVec.end(),
-            [](const std::pair<uint64_t, uint64_t>& a,
-               const std::pair<uint64_t, uint64_t>& b
+            [alphabetSize](const std::pair<uint64_t, uint64_t>& a,
+                           const std::pair<uint64_t, uint64_t>& b
             )
             {
-                if (a.second > b.second)
+                uint64_t contextA = a.first / alphabetSize;
+                uint64_t contextB = b.first / alphabetSize;
+                if (contextA != contextB)
                 {
-                    return true;
+                    return contextA < contextB;
                 }
-                if (a.second < b.second)
+                if (a.second != b.second)
                 {
-                    return false;
+                    return a.second > b.second;
                 }
                 return a.first < b.first;
             }
     );
 
-    for (const auto& symbol : freqVec)
+    for (size_t begin = 0; begin < freqVec.size();)
     {
-        lut->emplace_back(symbol.first, inverseLut->size());
-        inverseLut->emplace_back(symbol.first);
-    }
+        uint64_t context = freqVec[begin].first / alphabetSize;
+        size_t end = begin;
+        while (end < freqVec.size() && freqVec[end].first / alphabetSize == context)
+        {
+            end++;
+        }
 
-    // Sort symbols
-    std::sort(
-            lut->begin(), lut->end(),
-            [](const std::pair<uint64_t, uint64_t>& a,
-               const std::pair<uint64_t, uint64_t>& b
-            )
-            {
-                if (a.first < b.first)
-                {
-                    return true;
-                }
-                if (a.first > b.first)
-                {
-                    return false;
-                }
-                return a.second > b.second;
-            }
-    );
+        std::vector<uint32_t> contextSymbols(ORDER);
+        for (size_t i = 0; i < ORDER; i++)
+        {
+            contextSymbols[i] = static_cast<uint32_t>(context % alphabetSize);
+            context /= alphabetSize;
+        }
+        inverseLut->insert(inverseLut->end(), contextSymbols.begin(), contextSymbols.end());
+        inverseLut->push_back(static_cast<uint32_t>(end - begin));
+        for (size_t i = begin; i < end; i++)
+        {
+            (*lut)[freqVec[i].first] = i - begin;
+            inverseLut->push_back(static_cast<uint32_t>(freqVec[i].first % alphabetSize));
+        }
+        begin = end;
+    }
 }
 
 // ----------------------------------------------------------------------------
 
-static uint64_t lut0SingleTransform(
-        const std::vector<std::pair<uint64_t, uint64_t>>& lut0,
-        uint64_t symbol
+// Inverse of the storage format of inferLutHigherOrder(): maps the index of
+// (context, rank) to the order-0 rank
+static void parseLutHigherOrder(
+        const size_t ORDER,
+        const std::vector<uint32_t>& inverseLut,
+        const uint64_t lut0Size,
+        SymbolTable<uint64_t> *const lut
 ){
-    auto it = std::lower_bound(
-            lut0.begin(), lut0.end(), std::make_pair(symbol, uint(0)),
-            [](const std::pair<uint64_t, uint64_t>& a,
-               const std::pair<uint64_t, uint64_t>& b
-            )
+    const uint64_t alphabetSize = lut0Size + 1;
+    size_t position = 0;
+    while (position < inverseLut.size())
+    {
+        if (inverseLut.size() - position < ORDER + 1)
+        {
+            throw std::runtime_error("inverseTransformLutTransform: truncated higher-order LUT");
+        }
+        uint64_t context = 0;
+        for (size_t i = ORDER; i > 0; --i)
+        {
+            context *= alphabetSize;
+            context += inverseLut[position + i - 1];
+        }
+        position += ORDER;
+        uint64_t numSymbols = inverseLut[position++];
+        if (numSymbols > inverseLut.size() - position)
+        {
+            throw std::runtime_error("inverseTransformLutTransform: truncated higher-order LUT");
+        }
+        for (uint64_t rank = 0; rank < numSymbols; rank++)
+        {
+            uint64_t symbol = inverseLut[position++];
+            if (symbol >= alphabetSize)
             {
-                return a.first < b.first;
+                throw std::runtime_error("inverseTransformLutTransform: invalid higher-order LUT");
             }
-    );
-    assert(it != lut0.end());
-    assert(it->first == symbol);
-    return it->second;
+            (*lut)[context * alphabetSize + rank] = symbol;
+        }
+    }
 }
 
 // ----------------------------------------------------------------------------
 
+// Symbols without an order-0 rank are appended to escapedSymbols, which may
+// only be a nullptr if the LUT holds all symbols
+template<typename T>
 static void transformLutTransform_core(
         const size_t ORDER,
-        const std::vector<uint64_t>& symbols,
-        const std::vector<std::pair<uint64_t, uint64_t>>& lut0,
-        const std::vector<uint64_t>& lut,
-        std::vector<uint64_t> *const transformedSymbols
+        const T *const symbols,
+        const size_t symbolsSize,
+        const SymbolTable<T>& lut0,
+        const uint64_t lut0Size,
+        const SymbolTable<uint64_t>& lut,
+        T *const transformedSymbols,
+        std::vector<T> *const escapedSymbols
 ){
-    assert(transformedSymbols != nullptr);
-
-    // Prepare the output vector
-    transformedSymbols->clear();
-
-    if (symbols.empty())
+    if (symbolsSize == 0)
     {
         return;
     }
@@ -196,114 +759,386 @@ static void transformLutTransform_core(
     std::vector<uint64_t> lastSymbols(ORDER + 1, 0);
 
     // Do the LUT transform
-    for (const auto& symbol : symbols)
+    for (size_t j = 0; j < symbolsSize; j++)
     {
-        // Update history
-        for (size_t i = ORDER; i > 0; --i)
+        uint64_t rank = lut0Rank(lut0, lut0Size, symbols[j]);
+        if (rank == lut0Size)
         {
-            lastSymbols[i] = lastSymbols[i - 1];
+            escapedSymbols->push_back(symbols[j]);
         }
-        lastSymbols[0] = lut0SingleTransform(lut0, symbol);
-
-
-        // Compute position
-        size_t index = 0;
-        for (size_t i = ORDER; i > 0; --i)
-        {
-            index *= lut0.size();
-            index += lastSymbols[i];
-        }
-        index *= lut0.size();
-        index += lastSymbols[0];
-
-        // Transform
-        uint64_t transformed = lastSymbols[0];
-        if (ORDER > 0)
+        if (ORDER == 0)
         {
-            transformed = lut[index];
+            transformedSymbols[j] = static_cast<T>(rank);
+            continue;
         }
-        transformedSymbols->emplace_back(transformed);
+        updateHistory(ORDER, rank, &lastSymbols);
+        transformedSymbols[j] = static_cast<T>(lut.at(lutIndex(ORDER, lastSymbols, lut0Size + 1)));
     }
 }
 
 // ----------------------------------------------------------------------------
 
+template<typename T>
 static void inverseTransformLutTransform_core(
         const size_t ORDER,
-        const std::vector<uint64_t>& transformedSymbols,
-        const std::vector<uint64_t>& inverseLut0,
-        const std::vector<uint64_t>& inverseLut,
-        std::vector<uint64_t> *const symbols
+        const T *const transformedSymbols,
+        const size_t transformedSymbolsSize,
+        const T *const inverseLut0,
+        const size_t inverseLut0Size,
+        const SymbolTable<uint64_t>& inverseLut,
+        const T *const escapedSymbols,
+        const size_t escapedSymbolsSize,
+        T *const symbols
 ){
-    assert(symbols != nullptr);
-
-    // Prepare the output vector
-    symbols->clear();
-
-    if (transformedSymbols.empty())
+    if (transformedSymbolsSize == 0)
     {
         return;
     }
 
-    std::vector<uint64_t> lastSymbols(ORDER + 1, 0);
-
-    // Do the LUT transform
-    for (const auto& symbol : transformedSymbols)
+    size_t numEscapedSymbols = 0;
+    auto symbolOfRank = [&](uint64_t rank) -> T
     {
-        // Update history
-        for (size_t i = ORDER; i > 0; --i)
+        if (rank < inverseLut0Size)
         {
-            lastSymbols[i] = lastSymbols[i - 1];
+            return inverseLut0[rank];
         }
-        lastSymbols[0] = static_cast<uint64_t>(symbol);
-
-        if (ORDER == 0)
+        if (rank == inverseLut0Size && numEscapedSymbols < escapedSymbolsSize)
         {
-            symbols->emplace_back(inverseLut0[lastSymbols[0]]);
-            continue;
+            return escapedSymbols[numEscapedSymbols++];
         }
+        throw std::out_of_range("inverseTransformLutTransform: invalid rank or too few escaped symbols");
+    };
 
-        // Compute position
-        size_t index = 0;
-        for (size_t i = ORDER; i > 0; --i)
+    if (ORDER == 0)
+    {
+        for (size_t j = 0; j < transformedSymbolsSize; j++)
         {
-            index *= inverseLut0.size();
-            index += lastSymbols[i];
+            symbols[j] = symbolOfRank(transformedSymbols[j]);
         }
-        index *= inverseLut0.size();
-        index += lastSymbols[0];
+        return;
+    }
+
+    std::vector<uint64_t> lastSymbols(ORDER + 1, 0);
 
-        // Transform
-        uint64_t unTransformed = inverseLut[index];
+    // Do the inverse LUT transform
+    for (size_t j = 0; j < transformedSymbolsSize; j++)
+    {
+        updateHistory(ORDER, transformedSymbols[j], &lastSymbols);
+        uint64_t unTransformed = inverseLut.at(lutIndex(ORDER, lastSymbols, inverseLut0Size + 1));
         lastSymbols[0] = unTransformed;
-        symbols->emplace_back(inverseLut0[unTransformed]);
+        symbols[j] = symbolOfRank(unTransformed);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+template<typename T>
+size_t transformLutTransform0(
+        const T *const symbols,
+        const size_t symbolsSize,
+        T *const transformedSymbols,
+        T *const inverseLUT
+){
+    SymbolTable<T> lut;
+    std::vector<T> inverseLUTVector;
+    inferLut0(symbols, symbolsSize, false, 0, &lut, &inverseLUTVector);
+    if(inverseLUTVector.empty()) {
+        return 0;
     }
+    std::copy(inverseLUTVector.begin(), inverseLUTVector.end(), inverseLUT);
+    // The LUT is complete, so that no symbols are escaped
+    std::vector<T> escapedSymbols;
+    transformLutTransform_core(0, symbols, symbolsSize, lut, inverseLUTVector.size(), SymbolTable<uint64_t>(),
+                               transformedSymbols, &escapedSymbols);
+    return inverseLUTVector.size();
 }
 
 // ----------------------------------------------------------------------------
 
+template<typename T>
+void inverseTransformLutTransform0(
+        const T *const transformedSymbols,
+        const size_t transformedSymbolsSize,
+        const T *const inverseLUT,
+        const size_t inverseLUTSize,
+        T *const symbols
+){
+    inverseTransformLutTransform_core(0, transformedSymbols, transformedSymbolsSize, inverseLUT, inverseLUTSize,
+                                      SymbolTable<uint64_t>(), static_cast<const T *>(nullptr), 0, symbols);
+}
+
+// ----------------------------------------------------------------------------
+
+template<typename T>
 void transformLutTransform0(
-        const std::vector<uint64_t>& symbols,
-        std::vector<uint64_t> *transformedSymbols,
-        std::vector<uint64_t> *inverseLUT
+        const std::vector<T>& symbols,
+        std::vector<T> *transformedSymbols,
+        std::vector<T> *inverseLUT
 ){
-    std::vector<std::pair<uint64_t, uint64_t>> lut;
-    inferLut0(symbols, &lut, inverseLUT);
-    if(lut.empty()) {
+    assert(transformedSymbols != nullptr);
+    assert(inverseLUT != nullptr);
+
+    SymbolTable<T> lut;
+    inferLut0(symbols.data(), symbols.size(), false, 0, &lut, inverseLUT);
+    if(inverseLUT->empty()) {
         return;
     }
-    transformLutTransform_core(0, symbols, lut, std::vector<uint64_t>(), transformedSymbols);
+    transformedSymbols->resize(symbols.size());
+    transformLutTransform_core(0, symbols.data(), symbols.size(), lut, inverseLUT->size(), SymbolTable<uint64_t>(),
+                               transformedSymbols->data(), static_cast<std::vector<T> *>(nullptr));
 }
 
 // ----------------------------------------------------------------------------
 
+template<typename T>
 void inverseTransformLutTransform0(
+        const std::vector<T>& transformedSymbols,
+        const std::vector<T>& inverseLUT,
+        std::vector<T> *symbols
+){
+    assert(symbols != nullptr);
+
+    symbols->resize(transformedSymbols.size());
+    inverseTransformLutTransform0(transformedSymbols.data(), transformedSymbols.size(), inverseLUT.data(),
+                                  inverseLUT.size(), symbols->data());
+}
+
+// ----------------------------------------------------------------------------
+
+template<typename T>
+void transformLutTransform(
+        const unsigned int order,
+        const std::vector<T>& symbols,
+        const unsigned int numThreads,
+        std::vector<T> *const transformedSymbols,
+        std::vector<T> *const inverseLUT,
+        std::vector<uint32_t> *const inverseLUTHigherOrder,
+        std::vector<T> *const escapedSymbols
+){
+    assert(transformedSymbols != nullptr);
+    assert(inverseLUT != nullptr);
+    assert(inverseLUTHigherOrder != nullptr);
+    assert(escapedSymbols != nullptr);
+    if (order > 2)
+    {
+        throw std::out_of_range("transformLutTransform: order must be 0, 1 or 2");
+    }
+
+    inverseLUTHigherOrder->clear();
+    escapedSymbols->clear();
+    SymbolTable<T> lut0;
+    inferLut0(symbols.data(), symbols.size(), true, numThreads, &lut0, inverseLUT);
+    if(inverseLUT->empty()) {
+        return;
+    }
+
+    SymbolTable<uint64_t> lut;
+    if (order > 0)
+    {
+        inferLutHigherOrder(order, symbols.data(), symbols.size(), lut0, inverseLUT->size(), &lut,
+                            inverseLUTHigherOrder);
+        if (inverseLUTHigherOrder->empty())
+        {
+            inverseLUT->clear();
+            return;
+        }
+    }
+    transformedSymbols->resize(symbols.size());
+    transformLutTransform_core(order, symbols.data(), symbols.size(), lut0, inverseLUT->size(), lut,
+                               transformedSymbols->data(), escapedSymbols);
+}
+
+// ----------------------------------------------------------------------------
+
+template<typename T>
+void inverseTransformLutTransform(
+        const unsigned int order,
+        const std::vector<T>& transformedSymbols,
+        const std::vector<T>& inverseLUT,
+        const std::vector<uint32_t>& inverseLUTHigherOrder,
+        const std::vector<T>& escapedSymbols,
+        std::vector<T> *const symbols
+){
+    assert(symbols != nullptr);
+    if (order > 2)
+    {
+        throw std::out_of_range("inverseTransformLutTransform: order must be 0, 1 or 2");
+    }
+
+    SymbolTable<uint64_t> lut;
+    if (order > 0)
+    {
+        parseLutHigherOrder(order, inverseLUTHigherOrder, inverseLUT.size(), &lut);
+    }
+    symbols->resize(transformedSymbols.size());
+    inverseTransformLutTransform_core(order, transformedSymbols.data(), transformedSymbols.size(), inverseLUT.data(),
+                                      inverseLUT.size(), lut, escapedSymbols.data(), escapedSymbols.size(),
+                                      symbols->data());
+}
+
+// ----------------------------------------------------------------------------
+
+// Symbol widths of the gabacify pipeline (see SymbolStream)
+template size_t transformLutTransform0<uint8_t>(
+        const uint8_t *symbols,
+        size_t symbolsSize,
+        uint8_t *transformedSymbols,
+        uint8_t *inverseLUT
+);
+template void inverseTransformLutTransform0<uint8_t>(
+        const uint8_t *transformedSymbols,
+        size_t transformedSymbolsSize,
+        const uint8_t *inverseLUT,
+        size_t inverseLUTSize,
+        uint8_t *symbols
+);
+template void transformLutTransform0<uint8_t>(
+        const std::vector<uint8_t>& symbols,
+        std::vector<uint8_t> *transformedSymbols,
+        std::vector<uint8_t> *inverseLUT
+);
+template void inverseTransformLutTransform0<uint8_t>(
+        const std::vector<uint8_t>& transformedSymbols,
+        const std::vector<uint8_t>& inverseLUT,
+        std::vector<uint8_t> *symbols
+);
+template void transformLutTransform<uint8_t>(
+        unsigned int order,
+        const std::vector<uint8_t>& symbols,
+        unsigned int numThreads,
+        std::vector<uint8_t> *transformedSymbols,
+        std::vector<uint8_t> *inverseLUT,
+        std::vector<uint32_t> *inverseLUTHigherOrder,
+        std::vector<uint8_t> *escapedSymbols
+);
+template void inverseTransformLutTransform<uint8_t>(
+        unsigned int order,
+        const std::vector<uint8_t>& transformedSymbols,
+        const std::vector<uint8_t>& inverseLUT,
+        const std::vector<uint32_t>& inverseLUTHigherOrder,
+        const std::vector<uint8_t>& escapedSymbols,
+        std::vector<uint8_t> *symbols
+);
+template size_t transformLutTransform0<uint16_t>(
+        const uint16_t *symbols,
+        size_t symbolsSize,
+        uint16_t *transformedSymbols,
+        uint16_t *inverseLUT
+);
+template void inverseTransformLutTransform0<uint16_t>(
+        const uint16_t *transformedSymbols,
+        size_t transformedSymbolsSize,
+        const uint16_t *inverseLUT,
+        size_t inverseLUTSize,
+        uint16_t *symbols
+);
+template void transformLutTransform0<uint16_t>(
+        const std::vector<uint16_t>& symbols,
+        std::vector<uint16_t> *transformedSymbols,
+        std::vector<uint16_t> *inverseLUT
+);
+template void inverseTransformLutTransform0<uint16_t>(
+        const std::vector<uint16_t>& transformedSymbols,
+        const std::vector<uint16_t>& inverseLUT,
+        std::vector<uint16_t> *symbols
+);
+template void transformLutTransform<uint16_t>(
+        unsigned int order,
+        const std::vector<uint16_t>& symbols,
+        unsigned int numThreads,
+        std::vector<uint16_t> *transformedSymbols,
+        std::vector<uint16_t> *inverseLUT,
+        std::vector<uint32_t> *inverseLUTHigherOrder,
+        std::vector<uint16_t> *escapedSymbols
+);
+template void inverseTransformLutTransform<uint16_t>(
+        unsigned int order,
+        const std::vector<uint16_t>& transformedSymbols,
+        const std::vector<uint16_t>& inverseLUT,
+        const std::vector<uint32_t>& inverseLUTHigherOrder,
+        const std::vector<uint16_t>& escapedSymbols,
+        std::vector<uint16_t> *symbols
+);
+template size_t transformLutTransform0<uint32_t>(
+        const uint32_t *symbols,
+        size_t symbolsSize,
+        uint32_t *transformedSymbols,
+        uint32_t *inverseLUT
+);
+template void inverseTransformLutTransform0<uint32_t>(
+        const uint32_t *transformedSymbols,
+        size_t transformedSymbolsSize,
+        const uint32_t *inverseLUT,
+        size_t inverseLUTSize,
+        uint32_t *symbols
+);
+template void transformLutTransform0<uint32_t>(
+        const std::vector<uint32_t>& symbols,
+        std::vector<uint32_t> *transformedSymbols,
+        std::vector<uint32_t> *inverseLUT
+);
+template void inverseTransformLutTransform0<uint32_t>(
+        const std::vector<uint32_t>& transformedSymbols,
+        const std::vector<uint32_t>& inverseLUT,
+        std::vector<uint32_t> *symbols
+);
+template void transformLutTransform<uint32_t>(
+        unsigned int order,
+        const std::vector<uint32_t>& symbols,
+        unsigned int numThreads,
+        std::vector<uint32_t> *transformedSymbols,
+        std::vector<uint32_t> *inverseLUT,
+        std::vector<uint32_t> *inverseLUTHigherOrder,
+        std::vector<uint32_t> *escapedSymbols
+);
+template void inverseTransformLutTransform<uint32_t>(
+        unsigned int order,
+        const std::vector<uint32_t>& transformedSymbols,
+        const std::vector<uint32_t>& inverseLUT,
+        const std::vector<uint32_t>& inverseLUTHigherOrder,
+        const std::vector<uint32_t>& escapedSymbols,
+        std::vector<uint32_t> *symbols
+);
+template size_t transformLutTransform0<uint64_t>(
+        const uint64_t *symbols,
+        size_t symbolsSize,
+        uint64_t *transformedSymbols,
+        uint64_t *inverseLUT
+);
+template void inverseTransformLutTransform0<uint64_t>(
+        const uint64_t *transformedSymbols,
+        size_t transformedSymbolsSize,
+        const uint64_t *inverseLUT,
+        size_t inverseLUTSize,
+        uint64_t *symbols
+);
+template void transformLutTransform0<uint64_t>(
+        const std::vector<uint64_t>& symbols,
+        std::vector<uint64_t> *transformedSymbols,
+        std::vector<uint64_t> *inverseLUT
+);
+template void inverseTransformLutTransform0<uint64_t>(
         const std::vector<uint64_t>& transformedSymbols,
         const std::vector<uint64_t>& inverseLUT,
         std::vector<uint64_t> *symbols
-){
-    inverseTransformLutTransform_core(0, transformedSymbols, inverseLUT, std::vector<uint64_t>(), symbols);
-}
+);
+template void transformLutTransform<uint64_t>(
+        unsigned int order,
+        const std::vector<uint64_t>& symbols,
+        unsigned int numThreads,
+        std::vector<uint64_t> *transformedSymbols,
+        std::vector<uint64_t> *inverseLUT,
+        std::vector<uint32_t> *inverseLUTHigherOrder,
+        std::vector<uint64_t> *escapedSymbols
+);
+template void inverseTransformLutTransform<uint64_t>(
+        unsigned int order,
+        const std::vector<uint64_t>& transformedSymbols,
+        const std::vector<uint64_t>& inverseLUT,
+        const std::vector<uint32_t>& inverseLUTHigherOrder,
+        const std::vector<uint64_t>& escapedSymbols,
+        std::vector<uint64_t> *symbols
+);
 
 // ----------------------------------------------------------------------------
 
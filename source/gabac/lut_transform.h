@@ -54,6 +54,35 @@ int gabac_inverseTransformLutTransform0(
         uint64_t **symbols
 );
 
+/**
+ * Caller-buffer variant of gabac_transformLutTransform0(): nothing is
+ * allocated or copied. Both outputs need a capacity of symbolsSize elements.
+ * An inverseLUTSize of 0 means that no LUT was built for a non-empty input;
+ * transformedSymbols is not written then.
+ */
+int gabac_transformLutTransform0Into(
+        const uint64_t *symbols,
+        size_t symbolsSize,
+        uint64_t *transformedSymbols,
+        size_t transformedSymbolsCapacity,
+        uint64_t *inverseLUT,
+        size_t inverseLUTCapacity,
+        size_t *inverseLUTSize
+);
+
+/**
+ * Caller-buffer variant of gabac_inverseTransformLutTransform0(); symbols
+ * needs a capacity of transformedSymbolsSize elements.
+ */
+int gabac_inverseTransformLutTransform0Into(
+        const uint64_t *transformedSymbols,
+        size_t transformedSymbolsSize,
+        const uint64_t *inverseLUT,
+        size_t inverseLUTSize,
+        uint64_t *symbols,
+        size_t symbolsCapacity
+);
+
 
 #ifdef __cplusplus
 }  // extern "C"
@@ -68,15 +97,17 @@ int gabac_inverseTransformLutTransform0(
 namespace gabac {
 
 /**
- *
+ * T is one of uint8_t, uint16_t, uint32_t and uint64_t; the transformed
+ * symbols and the inverse LUT have the type of the input.
  * @param symbols
  * @param transformedSymbols
  * @param inverseLUT
  */
+template<typename T>
 void transformLutTransform0(
-        const std::vector<uint64_t>& symbols,
-        std::vector<uint64_t> *transformedSymbols,
-        std::vector<uint64_t> *inverseLUT
+        const std::vector<T>& symbols,
+        std::vector<T> *transformedSymbols,
+        std::vector<T> *inverseLUT
 );
 
 /**
@@ -85,10 +116,90 @@ void transformLutTransform0(
  * @param inverseLUT
  * @param symbols
  */
+template<typename T>
+void inverseTransformLutTransform0(
+        const std::vector<T>& transformedSymbols,
+        const std::vector<T>& inverseLUT,
+        std::vector<T> *symbols
+);
+
+/**
+ * Version on plain arrays; both outputs must hold symbolsSize elements.
+ * @return Size of the inverse LUT, 0 if no LUT was built
+ */
+template<typename T>
+size_t transformLutTransform0(
+        const T *symbols,
+        size_t symbolsSize,
+        T *transformedSymbols,
+        T *inverseLUT
+);
+
+/**
+ * Version on plain arrays; symbols must hold transformedSymbolsSize elements.
+ */
+template<typename T>
 void inverseTransformLutTransform0(
-        const std::vector<uint64_t>& transformedSymbols,
-        const std::vector<uint64_t>& inverseLUT,
-        std::vector<uint64_t> *symbols
+        const T *transformedSymbols,
+        size_t transformedSymbolsSize,
+        const T *inverseLUT,
+        size_t inverseLUTSize,
+        T *symbols
+);
+
+/**
+ * Size of an order-0 LUT which holds only the most frequent symbols. The
+ * rank PARTIAL_LUT_SIZE then escapes to the next of the escaped symbols.
+ */
+const size_t PARTIAL_LUT_SIZE = (1u << 20u) - 1;
+
+/**
+ * LUT transform of the given order. Order 0 is like
+ * transformLutTransform0(), except that an input with too many different
+ * symbols gets a partial LUT (see PARTIAL_LUT_SIZE) instead of none. For
+ * order 1 and 2, the order-0 ranks are ranked again among the ranks which
+ * follow the same order previous ones, so that symbols which are
+ * predictable from their predecessors become small. For each context, the
+ * higher-order inverse LUT holds the order context ranks, the number of
+ * symbols in the context and their order-0 ranks. All outputs are empty if
+ * no LUT was built. The symbols are counted by numThreads threads (0: one
+ * per hardware thread).
+ * @param order
+ * @param symbols
+ * @param numThreads
+ * @param transformedSymbols
+ * @param inverseLUT
+ * @param inverseLUTHigherOrder
+ * @param escapedSymbols
+ */
+template<typename T>
+void transformLutTransform(
+        unsigned int order,
+        const std::vector<T>& symbols,
+        unsigned int numThreads,
+        std::vector<T> *transformedSymbols,
+        std::vector<T> *inverseLUT,
+        std::vector<uint32_t> *inverseLUTHigherOrder,
+        std::vector<T> *escapedSymbols
+);
+
+/**
+ *
+ * @param order
+ * @param transformedSymbols
+ * @param inverseLUT
+ * @param inverseLUTHigherOrder
+ * @param escapedSymbols
+ * @param symbols
+ */
+template<typename T>
+void inverseTransformLutTransform(
+        unsigned int order,
+        const std::vector<T>& transformedSymbols,
+        const std::vector<T>& inverseLUT,
+        const std::vector<uint32_t>& inverseLUTHigherOrder,
+        const std::vector<T>& escapedSymbols,
+        std::vector<T> *symbols
 );
 
 }  // namespace gabac
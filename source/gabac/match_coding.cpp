@@ -2,7 +2,10 @@
 
 #include <cassert>
 #include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
 
 #include "gabac/return_codes.h"
 
@@ -155,71 +158,360 @@ int gabac_inverseTransformMatchCoding(
 
 
 // ----------------------------------------------------------------------------
-// C wrapper END
-// ----------------------------------------------------------------------------
 
+int gabac_transformMatchCodingInto(
+        const uint64_t *const symbols,
+        const size_t symbolsSize,
+        const uint32_t windowSize,
+        uint64_t *const pointers,
+        const size_t pointersCapacity,
+        size_t *const pointersSize,
+        uint64_t *const lengths,
+        const size_t lengthsCapacity,
+        size_t *const lengthsSize,
+        uint64_t *const rawValues,
+        const size_t rawValuesCapacity,
+        size_t *const rawValuesSize
+){
+    if ((symbols == nullptr || pointers == nullptr || lengths == nullptr || rawValues == nullptr) &&
+        symbolsSize > 0)
+    {
+        return GABAC_FAILURE;
+    }
+    if (pointersSize == nullptr || lengthsSize == nullptr || rawValuesSize == nullptr)
+    {
+        return GABAC_FAILURE;
+    }
+    if (pointersCapacity < symbolsSize || lengthsCapacity < symbolsSize || rawValuesCapacity < symbolsSize)
+    {
+        return GABAC_FAILURE;
+    }
+
+    gabac::transformMatchCoding(
+            symbols,
+            symbolsSize,
+            windowSize,
+            pointers,
+            pointersSize,
+            lengths,
+            lengthsSize,
+            rawValues,
+            rawValuesSize
+    );
 
-namespace gabac {
+    return GABAC_SUCCESS;
+}
 
+// ----------------------------------------------------------------------------
 
-void transformMatchCoding(
-        const std::vector<uint64_t>& symbols,
-        const uint32_t windowSize,
-        std::vector<uint64_t> *const pointers,
-        std::vector<uint64_t> *const lengths,
-        std::vector<uint64_t> *const rawValues
+int gabac_inverseTransformMatchCodingSize(
+        const uint64_t *const lengths,
+        const size_t lengthsSize,
+        size_t *const symbolsSize
 ){
-    assert(pointers != nullptr);
-    assert(lengths != nullptr);
-    assert(rawValues != nullptr);
+    if (lengths == nullptr && lengthsSize > 0)
+    {
+        return GABAC_FAILURE;
+    }
+    if (symbolsSize == nullptr)
+    {
+        return GABAC_FAILURE;
+    }
 
-    // Prepare the output vectors
-    pointers->clear();
-    lengths->clear();
-    rawValues->clear();
+    *symbolsSize = gabac::inverseTransformMatchCodingSize(lengths, lengthsSize);
 
-    if (windowSize == 0)
+    return GABAC_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+int gabac_inverseTransformMatchCodingInto(
+        const uint64_t *const pointers,
+        const size_t pointersSize,
+        const uint64_t *const lengths,
+        const size_t lengthsSize,
+        const uint64_t *const rawValues,
+        const size_t rawValuesSize,
+        uint64_t *const symbols,
+        const size_t symbolsCapacity,
+        size_t *const symbolsSize
+){
+    if ((pointers == nullptr && pointersSize > 0) ||
+        (lengths == nullptr && lengthsSize > 0) ||
+        (rawValues == nullptr && rawValuesSize > 0))
     {
-        lengths->resize(symbols.size());
-        std::fill(lengths->begin(), lengths->end(), 0);
-        *rawValues = symbols;
-        return;
+        return GABAC_FAILURE;
+    }
+    if (symbolsSize == nullptr)
+    {
+        return GABAC_FAILURE;
     }
 
-    // Do the match coding
-    const uint64_t symbolsSize = symbols.size();
-    for (uint64_t i = 0; i < symbolsSize; i++)
+    *symbolsSize = gabac::inverseTransformMatchCodingSize(lengths, lengthsSize);
+    if (*symbolsSize > symbolsCapacity || (symbols == nullptr && *symbolsSize > 0))
     {
-        uint64_t pointer = 0;
-        uint64_t length = 0;
-        uint64_t windowStartIdx = i - windowSize;
-        uint64_t windowEndIdx = i;
+        return GABAC_FAILURE;
+    }
+
+    try
+    {
+        gabac::inverseTransformMatchCoding(
+                pointers,
+                pointersSize,
+                lengths,
+                lengthsSize,
+                rawValues,
+                rawValuesSize,
+                symbols
+        );
+    }
+    catch (...)
+    {
+        return GABAC_FAILURE;
+    }
+
+    return GABAC_SUCCESS;
+}
+
+
+// ----------------------------------------------------------------------------
+// C wrapper END
+// ----------------------------------------------------------------------------
+
+
+namespace gabac {
 
-        for (uint64_t w = windowStartIdx; w < windowEndIdx; w++)
+
+namespace {
+
+
+// Hash chains over the positions in the window. Matches shorter than 2
+// symbols are never used, so every position is chained by the hash of its
+// first 2 symbols. With small alphabets these chains get long and only reach
+// a few thousand symbols back within the search depth, so positions are
+// also chained by the hash of their first longChainKeyLength symbols, which
+// finds long-range repeats anywhere in a large window. Chain entries are of
+// type E, which must hold the number of symbols.
+template<typename T, typename E>
+class MatchFinder
+{
+ public:
+    MatchFinder(
+            const T *const symbols,
+            const size_t symbolsSize,
+            const uint32_t windowSize
+    )
+            : m_symbols(symbols),
+            m_symbolsSize(symbolsSize),
+            m_windowSize(windowSize),
+            m_hashShift(0),
+            m_ringMask(0),
+            m_shortHeads(),
+            m_shortChains(),
+            m_longHeads(),
+            m_longChains(){
+        // Chain links are only followed within the window, so a ring buffer
+        // longer than the window holds all of them. For large windows, the
+        // ring only keeps the links of the last maxRingSize positions; older
+        // candidates are still found as chain heads. With 32-bit entries,
+        // this bounds the memory to 2 * 4 bytes per head and ring entry,
+        // i.e. 40 MiB.
+        size_t numPositions = std::min({symbolsSize, static_cast<size_t>(windowSize) + 1, maxRingSize});
+        unsigned int hashBits = 8;
+        while (hashBits < 20 && (size_t(1) << hashBits) < numPositions)
+        {
+            hashBits++;
+        }
+        size_t ringSize = 1;
+        while (ringSize < numPositions)
+        {
+            ringSize <<= 1;
+        }
+        m_hashShift = 64 - hashBits;
+        m_ringMask = ringSize - 1;
+        m_shortHeads.assign(size_t(1) << hashBits, 0);
+        m_shortChains.assign(ringSize, 0);
+        m_longHeads.assign(size_t(1) << hashBits, 0);
+        m_longChains.assign(ringSize, 0);
+    }
+
+    // Finds the longest match for position, preferring the closest one
+    // among equally long matches, as an exhaustive search of the window
+    // would. The match may overlap position. A length of 0 means that no
+    // match was found.
+    void find(
+            const size_t position,
+            const uint64_t maxLength,
+            uint64_t *const pointer,
+            uint64_t *const length
+    ) const {
+        *pointer = 0;
+        *length = 0;
+        if (position + 1 >= m_symbolsSize)
+        {
+            return;
+        }
+        uint64_t lengthLimit = std::min(static_cast<uint64_t>(m_symbolsSize - position), maxLength);
+        search(position, lengthLimit, m_shortHeads[shortHash(position)], m_shortChains, maxShortChainDepth,
+               pointer, length);
+        if (*length < lengthLimit && position + longChainKeyLength <= m_symbolsSize)
+        {
+            search(position, lengthLimit, m_longHeads[longHash(position)], m_longChains, maxLongChainDepth,
+                   pointer, length);
+        }
+    }
+
+    // Positions must be inserted in increasing order
+    void insert(
+            const size_t position
+    ){
+        if (position + 1 >= m_symbolsSize)
+        {
+            return;
+        }
+        E& shortHead = m_shortHeads[shortHash(position)];
+        m_shortChains[position & m_ringMask] = shortHead;
+        shortHead = static_cast<E>(position + 1);
+        if (position + longChainKeyLength <= m_symbolsSize)
         {
-            uint64_t offset = i;
-            while (
-                    (offset < symbolsSize)
-                    && (symbols[offset] == (symbols[w + offset - i])))
+            E& longHead = m_longHeads[longHash(position)];
+            m_longChains[position & m_ringMask] = longHead;
+            longHead = static_cast<E>(position + 1);
+        }
+    }
+
+ private:
+    static const size_t longChainKeyLength = 16;
+
+    static const size_t maxRingSize = size_t(1) << 22u;
+
+    static const unsigned int maxShortChainDepth = 256;
+
+    static const unsigned int maxLongChainDepth = 64;
+
+    // Walks a chain from the closest candidate on. Chain entries hold
+    // position + 1, 0 ends the chain.
+    void search(
+            const size_t position,
+            const uint64_t lengthLimit,
+            E entry,
+            const std::vector<E>& chains,
+            unsigned int depth,
+            uint64_t *const pointer,
+            uint64_t *const length
+    ) const {
+        while (entry != 0 && depth-- > 0)
+        {
+            size_t candidate = entry - 1;
+            uint64_t distance = position - candidate;
+            if (distance > m_windowSize)
+            {
+                break;
+            }
+            entry = (distance <= m_ringMask + 1) ? chains[candidate & m_ringMask] : 0;
+
+            // Cheap check whether the candidate can be longer than the best
+            // match so far
+            if (*length > 0 && *length < lengthLimit &&
+                m_symbols[candidate + *length] != m_symbols[position + *length])
             {
-                offset++;
+                continue;
             }
-            offset -= i;
-            if (offset >= length)
+            uint64_t l = 0;
+            while (l < lengthLimit && m_symbols[candidate + l] == m_symbols[position + l])
             {
-                length = offset;
-                pointer = w;
+                l++;
             }
+            if (l > *length || (l == *length && l > 0 && distance < *pointer))
+            {
+                *length = l;
+                *pointer = distance;
+                if (l == lengthLimit)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    size_t shortHash(
+            const size_t position
+    ) const {
+        uint64_t key = static_cast<uint64_t>(m_symbols[position]) * 0x9E3779B97F4A7C15ull;
+        key ^= static_cast<uint64_t>(m_symbols[position + 1]);
+        return static_cast<size_t>((key * 0xC2B2AE3D27D4EB4Full) >> m_hashShift);
+    }
+
+    size_t longHash(
+            const size_t position
+    ) const {
+        uint64_t key = 0;
+        for (size_t k = 0; k < longChainKeyLength; k++)
+        {
+            key = (key ^ static_cast<uint64_t>(m_symbols[position + k])) * 0x9E3779B97F4A7C15ull;
         }
+        return static_cast<size_t>((key ^ (key >> 29)) >> m_hashShift);
+    }
+
+    const T *m_symbols;
+
+    size_t m_symbolsSize;
+
+    uint64_t m_windowSize;
+
+    unsigned int m_hashShift;
+
+    size_t m_ringMask;
+
+    std::vector<E> m_shortHeads;
+
+    std::vector<E> m_shortChains;
+
+    std::vector<E> m_longHeads;
+
+    std::vector<E> m_longChains;
+};
+
+
+}  // namespace
+
+
+// Match codes the symbols with chain entries of type E.
+template<typename T, typename I, typename E>
+static void findMatches(
+        const T *const symbols,
+        const size_t symbolsSize,
+        const uint32_t windowSize,
+        I *const pointers,
+        size_t *const numPointers,
+        I *const lengths,
+        size_t *const numLengths,
+        T *const rawValues,
+        size_t *const numRawValues
+){
+    MatchFinder<T, E> matchFinder(symbols, symbolsSize, windowSize);
+    const uint64_t maxLength = std::numeric_limits<I>::max();
+
+    // Do the match coding
+    for (size_t i = 0; i < symbolsSize; i++)
+    {
+        uint64_t pointer = 0;
+        uint64_t length = 0;
+        matchFinder.find(i, maxLength, &pointer, &length);
         if (length < 2)
         {
-            lengths->push_back(0);
-            rawValues->push_back(symbols[i]);
+            lengths[(*numLengths)++] = 0;
+            rawValues[(*numRawValues)++] = symbols[i];
+            matchFinder.insert(i);
         }
         else
         {
-            pointers->push_back(i - pointer);
-            lengths->push_back(length);
+            pointers[(*numPointers)++] = static_cast<I>(pointer);
+            lengths[(*numLengths)++] = static_cast<I>(length);
+            for (uint64_t l = 0; l < length; l++)
+            {
+                matchFinder.insert(i + l);
+            }
             i += (length - 1);
         }
     }
@@ -227,45 +519,384 @@ void transformMatchCoding(
 
 // ----------------------------------------------------------------------------
 
-void inverseTransformMatchCoding(
-        const std::vector<uint64_t>& pointers,
-        const std::vector<uint64_t>& lengths,
-        const std::vector<uint64_t>& rawValues,
-        std::vector<uint64_t> *const symbols
+template<typename T, typename I>
+void transformMatchCoding(
+        const T *const symbols,
+        const size_t symbolsSize,
+        const uint32_t windowSize,
+        I *const pointers,
+        size_t *const pointersSize,
+        I *const lengths,
+        size_t *const lengthsSize,
+        T *const rawValues,
+        size_t *const rawValuesSize
 ){
-    assert(symbols != nullptr);
-    assert(lengths.size() == pointers.size() + rawValues.size());
+    assert(pointersSize != nullptr);
+    assert(lengthsSize != nullptr);
+    assert(rawValuesSize != nullptr);
 
-    // Prepare the output vector
-    symbols->clear();
+    size_t numPointers = 0;
+    size_t numLengths = 0;
+    size_t numRawValues = 0;
 
+    if (windowSize == 0)
+    {
+        std::fill(lengths, lengths + symbolsSize, 0);
+        std::copy(symbols, symbols + symbolsSize, rawValues);
+        *pointersSize = 0;
+        *lengthsSize = symbolsSize;
+        *rawValuesSize = symbolsSize;
+        return;
+    }
+
+    // 32-bit chain entries halve the memory of the match finder
+    if (symbolsSize < std::numeric_limits<uint32_t>::max())
+    {
+        findMatches<T, I, uint32_t>(
+                symbols, symbolsSize, windowSize, pointers, &numPointers, lengths, &numLengths, rawValues, &numRawValues
+        );
+    }
+    else
+    {
+        findMatches<T, I, uint64_t>(
+                symbols, symbolsSize, windowSize, pointers, &numPointers, lengths, &numLengths, rawValues, &numRawValues
+        );
+    }
+
+    *pointersSize = numPointers;
+    *lengthsSize = numLengths;
+    *rawValuesSize = numRawValues;
+}
+
+// ----------------------------------------------------------------------------
+
+// Copies length symbols from pointer symbols before destination to
+// destination. If the match overlaps its own output, the copied pattern is
+// replicated with copies which double in size, each reading only symbols
+// which are already written.
+template<typename T>
+static void copyMatch(
+        T *const destination,
+        const uint64_t pointer,
+        const uint64_t length
+){
+    if (pointer == 1)
+    {
+        std::fill(destination, destination + length, destination[-1]);
+        return;
+    }
+    uint64_t distance = pointer;
+    uint64_t copied = 0;
+    while (copied < length)
+    {
+        uint64_t chunk = std::min(distance, length - copied);
+        std::memcpy(destination + copied, destination + copied - distance, chunk * sizeof(T));
+        copied += chunk;
+        distance = copied + pointer;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+template<typename I>
+size_t inverseTransformMatchCodingSize(
+        const I *const lengths,
+        const size_t lengthsSize
+){
+    size_t numSymbols = 0;
+    for (size_t i = 0; i < lengthsSize; i++)
+    {
+        numSymbols += (lengths[i] == 0) ? 1 : lengths[i];
+    }
+    return numSymbols;
+}
+
+// ----------------------------------------------------------------------------
+
+template<typename T, typename I>
+void inverseTransformMatchCoding(
+        const I *const pointers,
+        const size_t pointersSize,
+        const I *const lengths,
+        const size_t lengthsSize,
+        const T *const rawValues,
+        const size_t rawValuesSize,
+        T *const symbols
+){
     // Re-compute the symbols from the pointer, lengths and raw values
     size_t n = 0;
     size_t t0 = 0;
-    size_t t1 = 0;
     size_t t2 = 0;
-    for (t1 = 0; t1 < lengths.size(); t1++)
+    for (size_t t1 = 0; t1 < lengthsSize; t1++)
     {
         uint64_t length = lengths[t1];
         if (length == 0)
         {
-            symbols->push_back(rawValues[t2++]);
-            n++;
+            if (t2 >= rawValuesSize)
+            {
+                throw std::out_of_range("inverseTransformMatchCoding: too few raw values");
+            }
+            symbols[n++] = rawValues[t2++];
         }
         else
         {
+            if (t0 >= pointersSize)
+            {
+                throw std::out_of_range("inverseTransformMatchCoding: too few pointers");
+            }
             uint64_t pointer = pointers[t0++];
-            for (uint64_t l = 0; l < length; l++)
+            if (pointer == 0 || pointer > n)
             {
-                symbols->push_back(symbols->at(n - pointer));
-                n++;
+                throw std::out_of_range("inverseTransformMatchCoding: pointer out of range");
             }
+            copyMatch(symbols + n, pointer, length);
+            n += length;
         }
     }
 }
 
 // ----------------------------------------------------------------------------
 
+template<typename T, typename I>
+void transformMatchCoding(
+        const std::vector<T>& symbols,
+        const uint32_t windowSize,
+        std::vector<I> *const pointers,
+        std::vector<I> *const lengths,
+        std::vector<T> *const rawValues
+){
+    assert(pointers != nullptr);
+    assert(lengths != nullptr);
+    assert(rawValues != nullptr);
+
+    // Prepare the output vectors
+    pointers->resize(symbols.size());
+    lengths->resize(symbols.size());
+    rawValues->resize(symbols.size());
+
+    size_t pointersSize = 0;
+    size_t lengthsSize = 0;
+    size_t rawValuesSize = 0;
+    transformMatchCoding(
+            symbols.data(),
+            symbols.size(),
+            windowSize,
+            pointers->data(),
+            &pointersSize,
+            lengths->data(),
+            &lengthsSize,
+            rawValues->data(),
+            &rawValuesSize
+    );
+    pointers->resize(pointersSize);
+    lengths->resize(lengthsSize);
+    rawValues->resize(rawValuesSize);
+}
+
+// ----------------------------------------------------------------------------
+
+template<typename T, typename I>
+void inverseTransformMatchCoding(
+        const std::vector<I>& pointers,
+        const std::vector<I>& lengths,
+        const std::vector<T>& rawValues,
+        std::vector<T> *const symbols
+){
+    assert(symbols != nullptr);
+    assert(lengths.size() == pointers.size() + rawValues.size());
+
+    symbols->resize(inverseTransformMatchCodingSize(lengths.data(), lengths.size()));
+    inverseTransformMatchCoding(
+            pointers.data(),
+            pointers.size(),
+            lengths.data(),
+            lengths.size(),
+            rawValues.data(),
+            rawValues.size(),
+            symbols->data()
+    );
+}
+
+// ----------------------------------------------------------------------------
+
+// The C interface works on 64-bit pointers and lengths, the gabacify pipeline
+// on 32-bit ones (see SymbolStream)
+template size_t inverseTransformMatchCodingSize<uint64_t>(
+        const uint64_t *lengths,
+        size_t lengthsSize
+);
+template size_t inverseTransformMatchCodingSize<uint32_t>(
+        const uint32_t *lengths,
+        size_t lengthsSize
+);
+template void transformMatchCoding<uint64_t, uint64_t>(
+        const uint64_t *symbols,
+        size_t symbolsSize,
+        uint32_t windowSize,
+        uint64_t *pointers,
+        size_t *pointersSize,
+        uint64_t *lengths,
+        size_t *lengthsSize,
+        uint64_t *rawValues,
+        size_t *rawValuesSize
+);
+template void inverseTransformMatchCoding<uint64_t, uint64_t>(
+        const uint64_t *pointers,
+        size_t pointersSize,
+        const uint64_t *lengths,
+        size_t lengthsSize,
+        const uint64_t *rawValues,
+        size_t rawValuesSize,
+        uint64_t *symbols
+);
+template void transformMatchCoding<uint64_t, uint64_t>(
+        const std::vector<uint64_t>& symbols,
+        uint32_t windowSize,
+        std::vector<uint64_t> *pointers,
+        std::vector<uint64_t> *lengths,
+        std::vector<uint64_t> *rawValues
+);
+template void inverseTransformMatchCoding<uint64_t, uint64_t>(
+        const std::vector<uint64_t>& pointers,
+        const std::vector<uint64_t>& lengths,
+        const std::vector<uint64_t>& rawValues,
+        std::vector<uint64_t> *symbols
+);
+template void transformMatchCoding<uint8_t, uint32_t>(
+        const uint8_t *symbols,
+        size_t symbolsSize,
+        uint32_t windowSize,
+        uint32_t *pointers,
+        size_t *pointersSize,
+        uint32_t *lengths,
+        size_t *lengthsSize,
+        uint8_t *rawValues,
+        size_t *rawValuesSize
+);
+template void inverseTransformMatchCoding<uint8_t, uint32_t>(
+        const uint32_t *pointers,
+        size_t pointersSize,
+        const uint32_t *lengths,
+        size_t lengthsSize,
+        const uint8_t *rawValues,
+        size_t rawValuesSize,
+        uint8_t *symbols
+);
+template void transformMatchCoding<uint8_t, uint32_t>(
+        const std::vector<uint8_t>& symbols,
+        uint32_t windowSize,
+        std::vector<uint32_t> *pointers,
+        std::vector<uint32_t> *lengths,
+        std::vector<uint8_t> *rawValues
+);
+template void inverseTransformMatchCoding<uint8_t, uint32_t>(
+        const std::vector<uint32_t>& pointers,
+        const std::vector<uint32_t>& lengths,
+        const std::vector<uint8_t>& rawValues,
+        std::vector<uint8_t> *symbols
+);
+template void transformMatchCoding<uint16_t, uint32_t>(
+        const uint16_t *symbols,
+        size_t symbolsSize,
+        uint32_t windowSize,
+        uint32_t *pointers,
+        size_t *pointersSize,
+        uint32_t *lengths,
+        size_t *lengthsSize,
+        uint16_t *rawValues,
+        size_t *rawValuesSize
+);
+template void inverseTransformMatchCoding<uint16_t, uint32_t>(
+        const uint32_t *pointers,
+        size_t pointersSize,
+        const uint32_t *lengths,
+        size_t lengthsSize,
+        const uint16_t *rawValues,
+        size_t rawValuesSize,
+        uint16_t *symbols
+);
+template void transformMatchCoding<uint16_t, uint32_t>(
+        const std::vector<uint16_t>& symbols,
+        uint32_t windowSize,
+        std::vector<uint32_t> *pointers,
+        std::vector<uint32_t> *lengths,
+        std::vector<uint16_t> *rawValues
+);
+template void inverseTransformMatchCoding<uint16_t, uint32_t>(
+        const std::vector<uint32_t>& pointers,
+        const std::vector<uint32_t>& lengths,
+        const std::vector<uint16_t>& rawValues,
+        std::vector<uint16_t> *symbols
+);
+template void transformMatchCoding<uint32_t, uint32_t>(
+        const uint32_t *symbols,
+        size_t symbolsSize,
+        uint32_t windowSize,
+        uint32_t *pointers,
+        size_t *pointersSize,
+        uint32_t *lengths,
+        size_t *lengthsSize,
+        uint32_t *rawValues,
+        size_t *rawValuesSize
+);
+template void inverseTransformMatchCoding<uint32_t, uint32_t>(
+        const uint32_t *pointers,
+        size_t pointersSize,
+        const uint32_t *lengths,
+        size_t lengthsSize,
+        const uint32_t *rawValues,
+        size_t rawValuesSize,
+        uint32_t *symbols
+);
+template void transformMatchCoding<uint32_t, uint32_t>(
+        const std::vector<uint32_t>& symbols,
+        uint32_t windowSize,
+        std::vector<uint32_t> *pointers,
+        std::vector<uint32_t> *lengths,
+        std::vector<uint32_t> *rawValues
+);
+template void inverseTransformMatchCoding<uint32_t, uint32_t>(
+        const std::vector<uint32_t>& pointers,
+        const std::vector<uint32_t>& lengths,
+        const std::vector<uint32_t>& rawValues,
+        std::vector<uint32_t> *symbols
+);
+template void transformMatchCoding<uint64_t, uint32_t>(
+        const uint64_t *symbols,
+        size_t symbolsSize,
+        uint32_t windowSize,
+        uint32_t *pointers,
+        size_t *pointersSize,
+        uint32_t *lengths,
+        size_t *lengthsSize,
+        uint64_t *rawValues,
+        size_t *rawValuesSize
+);
+template void inverseTransformMatchCoding<uint64_t, uint32_t>(
+        const uint32_t *pointers,
+        size_t pointersSize,
+        const uint32_t *lengths,
+        size_t lengthsSize,
+        const uint64_t *rawValues,
+        size_t rawValuesSize,
+        uint64_t *symbols
+);
+template void transformMatchCoding<uint64_t, uint32_t>(
+        const std::vector<uint64_t>& symbols,
+        uint32_t windowSize,
+        std::vector<uint32_t> *pointers,
+        std::vector<uint32_t> *lengths,
+        std::vector<uint64_t> *rawValues
+);
+template void inverseTransformMatchCoding<uint64_t, uint32_t>(
+        const std::vector<uint32_t>& pointers,
+        const std::vector<uint32_t>& lengths,
+        const std::vector<uint64_t>& rawValues,
+        std::vector<uint64_t> *symbols
+);
+
+// ----------------------------------------------------------------------------
+
 }  // namespace gabac
 
 // ----------------------------------------------------------------------------
@@ -37,6 +37,45 @@ int gabac_inverseTransformMatchCoding(
 );
 
 
+// Caller-buffer variants: nothing is allocated or copied. Each output of the
+// forward transform needs a capacity of symbolsSize elements; the size of the
+// inverse transform can be queried in advance.
+int gabac_transformMatchCodingInto(
+        const uint64_t *symbols,
+        size_t symbolsSize,
+        uint32_t windowSize,
+        uint64_t *pointers,
+        size_t pointersCapacity,
+        size_t *pointersSize,
+        uint64_t *lengths,
+        size_t lengthsCapacity,
+        size_t *lengthsSize,
+        uint64_t *rawValues,
+        size_t rawValuesCapacity,
+        size_t *rawValuesSize
+);
+
+
+int gabac_inverseTransformMatchCodingSize(
+        const uint64_t *lengths,
+        size_t lengthsSize,
+        size_t *symbolsSize
+);
+
+
+int gabac_inverseTransformMatchCodingInto(
+        const uint64_t *pointers,
+        size_t pointersSize,
+        const uint64_t *lengths,
+        size_t lengthsSize,
+        const uint64_t *rawValues,
+        size_t rawValuesSize,
+        uint64_t *symbols,
+        size_t symbolsCapacity,
+        size_t *symbolsSize
+);
+
+
 #ifdef __cplusplus
 }  // extern "C"
 
@@ -48,20 +87,62 @@ int gabac_inverseTransformMatchCoding(
 namespace gabac {
 
 
+// T is one of uint8_t, uint16_t, uint32_t and uint64_t, the type of the
+// pointers and lengths I is uint32_t or uint64_t. Matches are searched with
+// hash chains, so windows of millions of symbols are practical; for windows
+// of up to 256 symbols the result equals that of an exhaustive search.
+template<typename T, typename I>
+void transformMatchCoding(
+        const std::vector<T>& symbols,
+        uint32_t windowSize,
+        std::vector<I> *pointers,
+        std::vector<I> *lengths,
+        std::vector<T> *rawValues
+);
+
+
+template<typename T, typename I>
+void inverseTransformMatchCoding(
+        const std::vector<I>& pointers,
+        const std::vector<I>& lengths,
+        const std::vector<T>& rawValues,
+        std::vector<T> *symbols
+);
+
+
+// Versions on plain arrays; each output of the forward transform must hold
+// symbolsSize elements
+template<typename T, typename I>
 void transformMatchCoding(
-        const std::vector<uint64_t>& symbols,
+        const T *symbols,
+        size_t symbolsSize,
         uint32_t windowSize,
-        std::vector<uint64_t> *pointers,
-        std::vector<uint64_t> *lengths,
-        std::vector<uint64_t> *rawValues
+        I *pointers,
+        size_t *pointersSize,
+        I *lengths,
+        size_t *lengthsSize,
+        T *rawValues,
+        size_t *rawValuesSize
 );
 
 
+// Number of symbols which the inverse transform will produce
+template<typename I>
+size_t inverseTransformMatchCodingSize(
+        const I *lengths,
+        size_t lengthsSize
+);
+
+
+template<typename T, typename I>
 void inverseTransformMatchCoding(
-        const std::vector<uint64_t>& pointers,
-        const std::vector<uint64_t>& lengths,
-        const std::vector<uint64_t>& rawValues,
-        std::vector<uint64_t> *symbols
+        const I *pointers,
+        size_t pointersSize,
+        const I *lengths,
+        size_t lengthsSize,
+        const T *rawValues,
+        size_t rawValuesSize,
+        T *symbols
 );
 
 
@@ -2,6 +2,7 @@
 
 #include <cassert>
 #include <limits>
+#include <stdexcept>
 
 #include "gabac/constants.h"
 #include "gabac/context_tables.h"
@@ -18,93 +19,299 @@ namespace gabac {
 
 
 Reader::Reader(
-        const std::vector<unsigned char>& bitstream
+        const unsigned char *const bitstream,
+        size_t bitstreamSize
 )
-        : m_bitInputStream(bitstream),
+        : m_bitInputStream(bitstream, bitstreamSize),
+        m_rawBits(0),
+        m_numRawBits(0),
+        m_rawCursor(m_bitInputStream.getReadPointer()),
+        m_rawEnd(m_bitInputStream.getReadPointer() + m_bitInputStream.getNumBytesLeft()),
         // m_contextSelector(),
         m_decBinCabac(m_bitInputStream),
         m_contextModels(contexttables::buildContextTable()){
 }
 
 
+Reader::Reader(
+        const std::vector<unsigned char>& bitstream
+)
+        : Reader(bitstream.data(), bitstream.size()){
+}
+
+
 Reader::~Reader() = default;
 
 
-int64_t Reader::readBypassValue(
-        const BinarizationId& binarizationId,
-        const std::vector<unsigned int>& binarizationParameters
+size_t Reader::startRaw()
+{
+    return static_cast<size_t>(readRawBits(32));
+}
+
+
+inline uint64_t Reader::readRawBits(
+        unsigned int numBits
 ){
-    uint64_t ureturn = 0;
-    switch (binarizationId)
+    assert(numBits <= 32);
+
+    if (m_numRawBits < numBits)
     {
-        case BinarizationId::BI:
-            ureturn = readAsBIbypass(binarizationParameters[0]);
-            assert(ureturn <= std::numeric_limits<int64_t>::max());
-            return static_cast<int64_t>(ureturn);
-        case BinarizationId::TU:
-            ureturn = readAsTUbypass(binarizationParameters[0]);
-            assert(ureturn <= std::numeric_limits<int64_t>::max());
-            return static_cast<int64_t>(ureturn);
-        case BinarizationId::EG:
-            ureturn = readAsEGbypass();
-            assert(ureturn <= std::numeric_limits<int64_t>::max());
-            return static_cast<int64_t>(ureturn);
-        case BinarizationId::SEG:
-            return readAsSEGbypass();
-        case BinarizationId::TEG:
-            ureturn = readAsTEGbypass(binarizationParameters[0]);
-            assert(ureturn <= std::numeric_limits<int64_t>::max());
-            return static_cast<int64_t>(ureturn);
-        case BinarizationId::STEG:
-            return readAsSTEGbypass(binarizationParameters[0]);
+        if (m_rawEnd - m_rawCursor >= 8)
+        {
+            // Fast path: top up the window with as many whole bytes as fit
+            unsigned int numBytes = (63 - m_numRawBits) >> 3u;
+            m_rawBits = (m_rawBits << (8 * numBytes)) | (loadBigEndian64(m_rawCursor) >> (64 - 8 * numBytes));
+            m_rawCursor += numBytes;
+            m_numRawBits += 8 * numBytes;
+        }
+        else
+        {
+            while (m_numRawBits <= 56 && m_rawCursor != m_rawEnd)
+            {
+                m_rawBits = (m_rawBits << 8u) | *(m_rawCursor++);
+                m_numRawBits += 8;
+            }
+            if (m_numRawBits < numBits)
+            {
+                throw std::out_of_range("Reader: read past the end of the raw bitstream");
+            }
+        }
+    }
+
+    m_numRawBits -= numBits;
+    return (m_rawBits >> m_numRawBits) & ((1ull << numBits) - 1);
+}
+
+
+template<typename T, BinarizationId binarizationId, ContextSelectionId contextSelectionId>
+void Reader::readValuesKernel(
+        T *const symbols,
+        size_t numSymbols,
+        unsigned int binarizationParameter
+){
+    // Binarization and context selection are fixed for the whole stream, so
+    // all switches below are resolved at compile time
+    unsigned int previousSymbol = 0;
+    unsigned int previousPreviousSymbol = 0;
+
+    for (size_t i = 0; i < numSymbols; i++)
+    {
+        uint64_t ureturn = 0;
+        int64_t symbol = 0;
+
+        if (contextSelectionId == ContextSelectionId::raw)
+        {
+            switch (binarizationId)
+            {
+                case BinarizationId::BI:
+                    symbol = static_cast<int64_t>(readAsBIraw(binarizationParameter));
+                    break;
+                case BinarizationId::TU:
+                    symbol = static_cast<int64_t>(readAsTUraw(binarizationParameter));
+                    break;
+                case BinarizationId::EG:
+                    symbol = static_cast<int64_t>(readAsEGraw());
+                    break;
+                case BinarizationId::SEG:
+                    symbol = readAsSEGraw();
+                    break;
+                case BinarizationId::TEG:
+                    symbol = static_cast<int64_t>(readAsTEGraw(binarizationParameter));
+                    break;
+                case BinarizationId::STEG:
+                    symbol = readAsSTEGraw(binarizationParameter);
+                    break;
+            }
+            symbols[i] = static_cast<T>(symbol);
+            continue;
+        }
+
+        if (contextSelectionId == ContextSelectionId::bypass)
+        {
+            switch (binarizationId)
+            {
+                case BinarizationId::BI:
+                    ureturn = readAsBIbypass(binarizationParameter);
+                    assert(ureturn <= std::numeric_limits<int64_t>::max());
+                    symbol = static_cast<int64_t>(ureturn);
+                    break;
+                case BinarizationId::TU:
+                    ureturn = readAsTUbypass(binarizationParameter);
+                    assert(ureturn <= std::numeric_limits<int64_t>::max());
+                    symbol = static_cast<int64_t>(ureturn);
+                    break;
+                case BinarizationId::EG:
+                    ureturn = readAsEGbypass();
+                    assert(ureturn <= std::numeric_limits<int64_t>::max());
+                    symbol = static_cast<int64_t>(ureturn);
+                    break;
+                case BinarizationId::SEG:
+                    symbol = readAsSEGbypass();
+                    break;
+                case BinarizationId::TEG:
+                    ureturn = readAsTEGbypass(binarizationParameter);
+                    assert(ureturn <= std::numeric_limits<int64_t>::max());
+                    symbol = static_cast<int64_t>(ureturn);
+                    break;
+                case BinarizationId::STEG:
+                    symbol = readAsSTEGbypass(binarizationParameter);
+                    break;
+            }
+            symbols[i] = static_cast<T>(symbol);
+            continue;
+        }
+
+        unsigned int offset = (previousSymbol << 2u) + previousPreviousSymbol;
+        switch (binarizationId)
+        {
+            case BinarizationId::BI:
+                symbol = static_cast<int64_t>(readAsBIcabac(binarizationParameter, offset));
+                break;
+            case BinarizationId::TU:
+                symbol = static_cast<int64_t>(readAsTUcabac(binarizationParameter, offset));
+                break;
+            case BinarizationId::EG:
+                symbol = static_cast<int64_t>(readAsEGcabac(offset));
+                break;
+            case BinarizationId::SEG:
+                symbol = readAsSEGcabac(offset);
+                break;
+            case BinarizationId::TEG:
+                symbol = static_cast<int64_t>(readAsTEGcabac(binarizationParameter, offset));
+                break;
+            case BinarizationId::STEG:
+                symbol = readAsSTEGcabac(binarizationParameter, offset);
+                break;
+        }
+        symbols[i] = static_cast<T>(symbol);
+
+        if (contextSelectionId == ContextSelectionId::adaptive_coding_order_2)
+        {
+            previousPreviousSymbol = previousSymbol;
+        }
+        if (contextSelectionId != ContextSelectionId::adaptive_coding_order_0)
+        {
+            previousSymbol = ContextSelector::getContextHistoryValue(symbol);
+        }
+    }
+}
+
+
+template<typename T, BinarizationId binarizationId>
+void Reader::readValuesWithBinarization(
+        T *const symbols,
+        size_t numSymbols,
+        unsigned int binarizationParameter,
+        const ContextSelectionId& contextSelectionId
+){
+    switch (contextSelectionId)
+    {
+        case ContextSelectionId::bypass:
+            readValuesKernel<T, binarizationId, ContextSelectionId::bypass>(
+                    symbols,
+                    numSymbols,
+                    binarizationParameter
+            );
+            break;
+        case ContextSelectionId::adaptive_coding_order_0:
+            readValuesKernel<T, binarizationId, ContextSelectionId::adaptive_coding_order_0>(
+                    symbols,
+                    numSymbols,
+                    binarizationParameter
+            );
+            break;
+        case ContextSelectionId::adaptive_coding_order_1:
+            readValuesKernel<T, binarizationId, ContextSelectionId::adaptive_coding_order_1>(
+                    symbols,
+                    numSymbols,
+                    binarizationParameter
+            );
+            break;
+        case ContextSelectionId::adaptive_coding_order_2:
+            readValuesKernel<T, binarizationId, ContextSelectionId::adaptive_coding_order_2>(
+                    symbols,
+                    numSymbols,
+                    binarizationParameter
+            );
+            break;
+        case ContextSelectionId::raw:
+            readValuesKernel<T, binarizationId, ContextSelectionId::raw>(
+                    symbols,
+                    numSymbols,
+                    binarizationParameter
+            );
+            break;
         default:
-            // TODO(Jan): handle default case
+            assert(false);
             break;
     }
-    assert(false);  // We should not get here
-    return ureturn;
 }
 
 
-int64_t Reader::readAdaptiveCabacValue(
+template<typename T>
+void Reader::readValues(
+        T *const symbols,
+        size_t numSymbols,
         const BinarizationId& binarizationId,
         const std::vector<unsigned int>& binarizationParameters,
-        unsigned int prevValue,
-        unsigned int prevPrevValue
+        const ContextSelectionId& contextSelectionId
 ){
-    unsigned int offset = (prevValue << 2u) + prevPrevValue;
+    unsigned int binarizationParameter = binarizationParameters.empty() ? 0 : binarizationParameters[0];
+
     switch (binarizationId)
     {
         case BinarizationId::BI:
-            return readAsBIcabac(
-                    binarizationParameters[0],
-                    offset
+            readValuesWithBinarization<T, BinarizationId::BI>(
+                    symbols,
+                    numSymbols,
+                    binarizationParameter,
+                    contextSelectionId
             );
+            break;
         case BinarizationId::TU:
-            return readAsTUcabac(
-                    binarizationParameters[0],
-                    offset
+            readValuesWithBinarization<T, BinarizationId::TU>(
+                    symbols,
+                    numSymbols,
+                    binarizationParameter,
+                    contextSelectionId
             );
+            break;
         case BinarizationId::EG:
-            return readAsEGcabac(offset);
+            readValuesWithBinarization<T, BinarizationId::EG>(
+                    symbols,
+                    numSymbols,
+                    binarizationParameter,
+                    contextSelectionId
+            );
+            break;
         case BinarizationId::SEG:
-            return readAsSEGcabac(offset);
+            readValuesWithBinarization<T, BinarizationId::SEG>(
+                    symbols,
+                    numSymbols,
+                    binarizationParameter,
+                    contextSelectionId
+            );
+            break;
         case BinarizationId::TEG:
-            return readAsTEGcabac(
-                    binarizationParameters[0],
-                    offset
+            readValuesWithBinarization<T, BinarizationId::TEG>(
+                    symbols,
+                    numSymbols,
+                    binarizationParameter,
+                    contextSelectionId
             );
+            break;
         case BinarizationId::STEG:
-            return readAsSTEGcabac(
-                    binarizationParameters[0],
-                    offset
+            readValuesWithBinarization<T, BinarizationId::STEG>(
+                    symbols,
+                    numSymbols,
+                    binarizationParameter,
+                    contextSelectionId
             );
+            break;
         default:
-            // TODO(Jan): handle default case
+            assert(false);
             break;
     }
-    assert(false);  // We should not get here
-    return 0;
 }
 
 
@@ -129,6 +336,13 @@ uint64_t Reader::readAsBIcabac(
 }
 
 
+uint64_t Reader::readAsBIraw(
+        unsigned int cLength
+){
+    return readRawBits(cLength);
+}
+
+
 uint64_t Reader::readAsTUbypass(
         unsigned int cMax
 ){
@@ -167,6 +381,18 @@ uint64_t Reader::readAsTUcabac(
 }
 
 
+uint64_t Reader::readAsTUraw(
+        unsigned int cMax
+){
+    unsigned int i = 0;
+    while (i < cMax && readRawBits(1) == 1)
+    {
+        i++;
+    }
+    return i;
+}
+
+
 uint64_t Reader::readAsEGbypass(){
     unsigned int bins = 0;
     unsigned int i = 0;
@@ -209,6 +435,20 @@ uint64_t Reader::readAsEGcabac(
 }
 
 
+uint64_t Reader::readAsEGraw(){
+    unsigned int i = 0;
+    while (readRawBits(1) == 0)
+    {
+        i++;
+    }
+    if (i == 0)
+    {
+        return 0;
+    }
+    return ((1ull << i) | readRawBits(i)) - 1;
+}
+
+
 int64_t Reader::readAsSEGbypass(){
     int64_t tmp = readAsEGbypass();
     // Save, only last bit
@@ -252,6 +492,16 @@ int64_t Reader::readAsSEGcabac(
 }
 
 
+int64_t Reader::readAsSEGraw(){
+    auto tmp = static_cast<int64_t>(readAsEGraw());
+    if ((static_cast<uint64_t> (tmp) & 0x1u) == 0)
+    {
+        return (-1 * static_cast<int64_t>((static_cast<uint64_t>(tmp) >> 1u)));
+    }
+    return static_cast<int64_t>((static_cast<uint64_t>(tmp + 1) >> 1u));
+}
+
+
 uint64_t Reader::readAsTEGbypass(
         unsigned int treshold
 ){
@@ -277,6 +527,18 @@ uint64_t Reader::readAsTEGcabac(
 }
 
 
+uint64_t Reader::readAsTEGraw(
+        unsigned int treshold
+){
+    uint64_t value = readAsTUraw(treshold);
+    if (value == treshold)
+    {
+        value += readAsEGraw();
+    }
+    return value;
+}
+
+
 int64_t Reader::readAsSTEGbypass(
         unsigned int treshold
 ){
@@ -316,6 +578,18 @@ int64_t Reader::readAsSTEGcabac(
 }
 
 
+int64_t Reader::readAsSTEGraw(
+        unsigned int treshold
+){
+    auto value = static_cast<int64_t>(readAsTEGraw(treshold));
+    if (value != 0 && readRawBits(1) == 1)
+    {
+        return -1 * value;
+    }
+    return value;
+}
+
+
 size_t Reader::readNumSymbols()
 {
     auto result = readAsBIbypass(32);
@@ -331,9 +605,61 @@ size_t Reader::start()
 
 void Reader::reset()
 {
-    m_contextModels = contexttables::buildContextTable();
+    contexttables::resetContextTable(&m_contextModels);
     m_decBinCabac.reset();
 }
 
 
+void Reader::restart(
+        const unsigned char *const bitstream,
+        size_t bitstreamSize
+){
+    m_bitInputStream = BitInputStream(bitstream, bitstreamSize);
+    m_rawBits = 0;
+    m_numRawBits = 0;
+    m_rawCursor = m_bitInputStream.getReadPointer();
+    m_rawEnd = m_bitInputStream.getReadPointer() + m_bitInputStream.getNumBytesLeft();
+    m_decBinCabac = BinaryArithmeticDecoder(m_bitInputStream);
+    contexttables::resetContextTable(&m_contextModels);
+}
+
+
+// Symbol widths used by the encoding/decoding front ends
+template void Reader::readValues<int64_t>(
+        int64_t *symbols,
+        size_t numSymbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId
+);
+template void Reader::readValues<uint8_t>(
+        uint8_t *symbols,
+        size_t numSymbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId
+);
+template void Reader::readValues<uint16_t>(
+        uint16_t *symbols,
+        size_t numSymbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId
+);
+template void Reader::readValues<uint32_t>(
+        uint32_t *symbols,
+        size_t numSymbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId
+);
+template void Reader::readValues<uint64_t>(
+        uint64_t *symbols,
+        size_t numSymbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId
+);
+
+
 }  // namespace gabac
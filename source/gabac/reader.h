@@ -18,6 +18,12 @@ namespace gabac {
 class Reader
 {
  public:
+    // The bitstream is borrowed, not copied, and must outlive the reader
+    Reader(
+            const unsigned char *bitstream,
+            size_t bitstreamSize
+    );
+
     explicit Reader(
             const std::vector<unsigned char>& bitstream
     );
@@ -26,16 +32,15 @@ class Reader
 
     size_t readNumSymbols();
 
-    int64_t readBypassValue(
-            const BinarizationId& binarizationId,
-            const std::vector<unsigned int>& binarizationParameters
-    );
-
-    int64_t readAdaptiveCabacValue(
+    // T is int64_t or one of uint8_t, uint16_t, uint32_t, uint64_t; the
+    // decoded values are truncated to T
+    template<typename T>
+    void readValues(
+            T *symbols,
+            size_t numSymbols,
             const BinarizationId& binarizationId,
             const std::vector<unsigned int>& binarizationParameters,
-            unsigned int prevValue,
-            unsigned int prevPrevValue
+            const ContextSelectionId& contextSelectionId
     );
 
     uint64_t readAsBIbypass(
@@ -47,6 +52,10 @@ class Reader
             unsigned int offset
     );
 
+    uint64_t readAsBIraw(
+            unsigned int cLength
+    );
+
     uint64_t readAsTUbypass(
             unsigned int cMax
     );
@@ -56,18 +65,26 @@ class Reader
             unsigned int offset
     );
 
+    uint64_t readAsTUraw(
+            unsigned int cMax
+    );
+
     uint64_t readAsEGbypass();
 
     uint64_t readAsEGcabac(
             unsigned int offset
     );
 
+    uint64_t readAsEGraw();
+
     int64_t readAsSEGbypass();
 
     int64_t readAsSEGcabac(
             unsigned int offset
     );
 
+    int64_t readAsSEGraw();
+
     uint64_t readAsTEGbypass(
             unsigned int treshold
     );
@@ -77,6 +94,10 @@ class Reader
             unsigned int offset
     );
 
+    uint64_t readAsTEGraw(
+            unsigned int treshold
+    );
+
     int64_t readAsSTEGbypass(
             unsigned int treshold
     );
@@ -86,13 +107,57 @@ class Reader
             unsigned int offset
     );
 
+    int64_t readAsSTEGraw(
+            unsigned int treshold
+    );
+
     size_t start();
 
     void reset();
 
+    // Starts over on another bitstream, which is borrowed as in the
+    // constructor; the context table is reused
+    void restart(
+            const unsigned char *bitstream,
+            size_t bitstreamSize
+    );
+
+    // Raw mode: the bins of all symbols are bit-packed directly in the
+    // bitstream; the arithmetic decoder is not used at all
+    size_t startRaw();
+
  private:
+    template<typename T, BinarizationId binarizationId>
+    void readValuesWithBinarization(
+            T *symbols,
+            size_t numSymbols,
+            unsigned int binarizationParameter,
+            const ContextSelectionId& contextSelectionId
+    );
+
+    template<typename T, BinarizationId binarizationId, ContextSelectionId contextSelectionId>
+    void readValuesKernel(
+            T *symbols,
+            size_t numSymbols,
+            unsigned int binarizationParameter
+    );
+
+    uint64_t readRawBits(
+            unsigned int numBits
+    );
+
     BitInputStream m_bitInputStream;
 
+    // Bit window for raw mode: m_numRawBits valid bits in the LSBs of
+    // m_rawBits, refilled from m_rawCursor
+    uint64_t m_rawBits;
+
+    unsigned int m_numRawBits;
+
+    const unsigned char *m_rawCursor;
+
+    const unsigned char *m_rawEnd;
+
     // ContextSelector m_contextSelector;
 
     BinaryArithmeticDecoder m_decBinCabac;
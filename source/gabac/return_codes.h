@@ -6,5 +6,8 @@
 
 #define GABAC_FAILURE (-1)
 
+/* The output would be larger than the byte budget given to the encoder */
+#define GABAC_BUDGET_EXCEEDED (-2)
+
 
 #endif  /* GABAC_RETURN_CODES_H_ */
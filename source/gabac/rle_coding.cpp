@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <stdexcept>
 
 #include "gabac/return_codes.h"
 
@@ -86,76 +87,487 @@ int gabac_inverseTransformRleCoding(
 }
 
 
-namespace gabac {
 
+int gabac_transformRleCodingInto(
+        const uint64_t * const symbols,
+        const size_t symbolsSize,
+        const uint64_t guard,
+        uint64_t * const rawValues,
+        const size_t rawValuesCapacity,
+        size_t * const rawValuesSize,
+        uint64_t * const lengths,
+        const size_t lengthsCapacity,
+        size_t * const lengthsSize
+){
+    if (symbols == nullptr && symbolsSize > 0) { return GABAC_FAILURE; }
+    if (rawValues == nullptr && symbolsSize > 0) { return GABAC_FAILURE; }
+    if (rawValuesSize == nullptr) { return GABAC_FAILURE; }
+    if (lengths == nullptr && symbolsSize > 0) { return GABAC_FAILURE; }
+    if (lengthsSize == nullptr) { return GABAC_FAILURE; }
+    if (guard == 0) { return GABAC_FAILURE; }
+    if (rawValuesCapacity < symbolsSize || lengthsCapacity < symbolsSize) { return GABAC_FAILURE; }
 
-void transformRleCoding(
-        const std::vector<uint64_t>& symbols,
+    gabac::transformRleCoding(symbols, symbolsSize, guard, rawValues, rawValuesSize, lengths, lengthsSize);
+
+    return GABAC_SUCCESS;
+}
+
+
+int gabac_inverseTransformRleCodingSize(
+        const uint64_t * const lengths,
+        const size_t lengthsSize,
+        const size_t rawValuesSize,
         const uint64_t guard,
-        std::vector<uint64_t> * const rawValues,
-        std::vector<uint64_t> * const lengths
+        size_t * const symbolsSize
 ){
-    assert(guard > 0);
-    assert(rawValues != nullptr);
-    assert(lengths != nullptr);
+    if (lengths == nullptr && lengthsSize > 0) { return GABAC_FAILURE; }
+    if (symbolsSize == nullptr) { return GABAC_FAILURE; }
+    if (guard == 0) { return GABAC_FAILURE; }
+
+    try
+    {
+        *symbolsSize = gabac::inverseTransformRleCodingSize(lengths, lengthsSize, rawValuesSize, guard);
+    }
+    catch (...)
+    {
+        return GABAC_FAILURE;
+    }
 
-    // Prepare the output vectors
-    rawValues->clear();
-    lengths->clear();
+    return GABAC_SUCCESS;
+}
 
-    // Do the RLE coding
-    for (size_t i = 0; i < symbols.size();)
+
+int gabac_inverseTransformRleCodingInto(
+        const uint64_t * const rawValues,
+        const size_t rawValuesSize,
+        const uint64_t * const lengths,
+        const size_t lengthsSize,
+        const uint64_t guard,
+        uint64_t * const symbols,
+        const size_t symbolsCapacity,
+        size_t * const symbolsSize
+){
+    if (rawValues == nullptr && rawValuesSize > 0) { return GABAC_FAILURE; }
+    if (lengths == nullptr && lengthsSize > 0) { return GABAC_FAILURE; }
+    if (symbolsSize == nullptr) { return GABAC_FAILURE; }
+    if (guard == 0) { return GABAC_FAILURE; }
+
+    try
     {
-        rawValues->push_back(symbols[i++]);
-        uint64_t lengthValue = 1;
-        while ((i < symbols.size()) && (symbols[i] == symbols[i - 1]))
+        *symbolsSize = gabac::inverseTransformRleCodingSize(lengths, lengthsSize, rawValuesSize, guard);
+        if (*symbolsSize > symbolsCapacity || (symbols == nullptr && *symbolsSize > 0))
         {
-            lengthValue++;
-            i++;
+            return GABAC_FAILURE;
         }
-        while (lengthValue > guard)
+        gabac::inverseTransformRleCoding(rawValues, rawValuesSize, lengths, lengthsSize, guard, symbols);
+    }
+    catch (...)
+    {
+        return GABAC_FAILURE;
+    }
+
+    return GABAC_SUCCESS;
+}
+
+
+namespace gabac {
+
+
+// Continues a run of value at i up to its end. The symbols are compared
+// block by block with a branch-free OR of the differences, which the
+// compiler turns into vector code; only the block containing the end of the
+// run is searched symbol by symbol.
+template<typename T>
+static size_t findLongRunEnd(
+        const T * const symbols,
+        size_t i,
+        const size_t end,
+        const T value
+){
+    const size_t blockSize = 64 / sizeof(T);
+    while (end - i >= blockSize)
+    {
+        T difference = 0;
+        for (size_t k = 0; k < blockSize; k++)
+        {
+            difference |= static_cast<T>(symbols[i + k] ^ value);
+        }
+        if (difference != 0)
         {
-            lengths->push_back(guard);
-            lengthValue -= guard;
+            break;
         }
-        lengths->push_back(lengthValue - 1);
+        i += blockSize;
+    }
+    while ((i < end) && (symbols[i] == value))
+    {
+        i++;
     }
+    return i;
 }
 
 
-void inverseTransformRleCoding(
-        const std::vector<uint64_t>& rawValues,
-        const std::vector<uint64_t>& lengths,
+// Returns the end of the run of equal symbols starting at begin. Short runs
+// are scanned symbol by symbol, longer ones by findLongRunEnd().
+template<typename T>
+inline size_t findRunEnd(
+        const T * const symbols,
+        const size_t begin,
+        const size_t end
+){
+    const T value = symbols[begin];
+    const size_t shortRunEnd = std::min(end, begin + 1 + 64 / sizeof(T));
+    size_t i = begin + 1;
+    while ((i < shortRunEnd) && (symbols[i] == value))
+    {
+        i++;
+    }
+    if (i < shortRunEnd || i == end)
+    {
+        return i;
+    }
+    return findLongRunEnd(symbols, i, end, value);
+}
+
+
+// Number of raw values and lengths which transformRleCoding() produces
+template<typename T>
+static void transformRleCodingSizes(
+        const T * const symbols,
+        const size_t symbolsSize,
         const uint64_t guard,
-        std::vector<uint64_t> * const symbols
+        size_t * const rawValuesSize,
+        size_t * const lengthsSize
+){
+    size_t numRawValues = 0;
+    size_t numLengths = 0;
+    for (size_t i = 0; i < symbolsSize;)
+    {
+        size_t runEnd = findRunEnd(symbols, i, symbolsSize);
+        uint64_t lengthValue = runEnd - i;
+        i = runEnd;
+        numRawValues++;
+        numLengths += (lengthValue > guard) ? ((lengthValue - 1) / guard + 1) : 1;
+    }
+    *rawValuesSize = numRawValues;
+    *lengthsSize = numLengths;
+}
+
+
+template<typename T, typename I>
+void transformRleCoding(
+        const T * const symbols,
+        const size_t symbolsSize,
+        const uint64_t guard,
+        T * const rawValues,
+        size_t * const rawValuesSize,
+        I * const lengths,
+        size_t * const lengthsSize
 ){
-    assert(!rawValues.empty());
-    assert(!lengths.empty());
     assert(guard > 0);
-    assert(symbols != nullptr);
+    assert(rawValuesSize != nullptr);
+    assert(lengthsSize != nullptr);
 
-    // Prepare the output vectors
-    symbols->clear();
+    // Do the RLE coding
+    size_t numRawValues = 0;
+    size_t numLengths = 0;
+    for (size_t i = 0; i < symbolsSize;)
+    {
+        size_t runEnd = findRunEnd(symbols, i, symbolsSize);
+        uint64_t lengthValue = runEnd - i;
+        rawValues[numRawValues++] = symbols[i];
+        i = runEnd;
 
-    // Re-compute the symbol sequence
+        // Runs longer than the guard are split into guard-sized parts
+        if (lengthValue > guard)
+        {
+            uint64_t numGuards = (lengthValue - 1) / guard;
+            std::fill(lengths + numLengths, lengths + numLengths + numGuards, static_cast<I>(guard));
+            numLengths += numGuards;
+            lengthValue -= numGuards * guard;
+        }
+        lengths[numLengths++] = static_cast<I>(lengthValue - 1);
+    }
+
+    *rawValuesSize = numRawValues;
+    *lengthsSize = numLengths;
+}
+
+
+// Walks the run lengths like the inverse transform; the symbols are only
+// written if there is an output
+template<bool WRITE_SYMBOLS, typename T, typename I>
+static size_t inverseTransformRleCodingRuns(
+        const T * const rawValues,
+        const size_t rawValuesSize,
+        const I * const lengths,
+        const size_t lengthsSize,
+        const uint64_t guard,
+        T * const symbols
+){
+    size_t numSymbols = 0;
     size_t j = 0;
-    for (const auto& rawValue : rawValues)
+    for (size_t i = 0; i < rawValuesSize; i++)
     {
-        uint64_t lengthValue = lengths.at(j++);
+        if (j >= lengthsSize)
+        {
+            throw std::out_of_range("inverseTransformRleCoding: too few lengths");
+        }
+        uint64_t lengthValue = lengths[j++];
         uint64_t totalLengthValue = lengthValue;
-        while ((lengthValue != 0) && (totalLengthValue % guard == 0))
+        // Only a length of at least the guard can continue the run, which
+        // saves the division for all others
+        while ((lengthValue >= guard) && (totalLengthValue % guard == 0))
         {
-            lengthValue = lengths.at(j++);
+            if (j >= lengthsSize)
+            {
+                throw std::out_of_range("inverseTransformRleCoding: too few lengths");
+            }
+            lengthValue = lengths[j++];
             totalLengthValue += lengthValue;
         }
         totalLengthValue++;
-        while (totalLengthValue > 0)
+        if (WRITE_SYMBOLS)
         {
-            totalLengthValue--;
-            symbols->push_back(rawValue);
+            std::fill(symbols + numSymbols, symbols + numSymbols + totalLengthValue, rawValues[i]);
         }
+        numSymbols += totalLengthValue;
     }
+
+    return numSymbols;
+}
+
+
+template<typename I>
+size_t inverseTransformRleCodingSize(
+        const I * const lengths,
+        const size_t lengthsSize,
+        const size_t rawValuesSize,
+        const uint64_t guard
+){
+    assert(guard > 0);
+    return inverseTransformRleCodingRuns<false, uint64_t>(nullptr, rawValuesSize, lengths, lengthsSize, guard,
+                                                          nullptr);
+}
+
+
+template<typename T, typename I>
+void inverseTransformRleCoding(
+        const T * const rawValues,
+        const size_t rawValuesSize,
+        const I * const lengths,
+        const size_t lengthsSize,
+        const uint64_t guard,
+        T * const symbols
+){
+    assert(guard > 0);
+    inverseTransformRleCodingRuns<true>(rawValues, rawValuesSize, lengths, lengthsSize, guard, symbols);
+}
+
+
+template<typename T, typename I>
+void transformRleCoding(
+        const std::vector<T>& symbols,
+        const uint64_t guard,
+        std::vector<T> * const rawValues,
+        std::vector<I> * const lengths
+){
+    assert(guard > 0);
+    assert(rawValues != nullptr);
+    assert(lengths != nullptr);
+
+    // Prepare the output vectors. Sizing them exactly costs an extra pass
+    // over the runs, but for long runs the outputs are much shorter than
+    // the input and are not worth allocating and clearing at full size.
+    size_t rawValuesSize = 0;
+    size_t lengthsSize = 0;
+    transformRleCodingSizes(symbols.data(), symbols.size(), guard, &rawValuesSize, &lengthsSize);
+    rawValues->resize(rawValuesSize);
+    lengths->resize(lengthsSize);
+
+    transformRleCoding(symbols.data(), symbols.size(), guard, rawValues->data(), &rawValuesSize, lengths->data(),
+                       &lengthsSize);
 }
 
 
+template<typename T, typename I>
+void inverseTransformRleCoding(
+        const std::vector<T>& rawValues,
+        const std::vector<I>& lengths,
+        const uint64_t guard,
+        std::vector<T> * const symbols
+){
+    assert(!rawValues.empty());
+    assert(!lengths.empty());
+    assert(guard > 0);
+    assert(symbols != nullptr);
+
+    // Re-compute the symbol sequence
+    symbols->resize(inverseTransformRleCodingSize(lengths.data(), lengths.size(), rawValues.size(), guard));
+    inverseTransformRleCoding(rawValues.data(), rawValues.size(), lengths.data(), lengths.size(), guard,
+                              symbols->data());
+}
+
+
+
+// The C interface works on 64-bit lengths, the gabacify pipeline on 32-bit
+// ones (see SymbolStream)
+template size_t inverseTransformRleCodingSize<uint64_t>(
+        const uint64_t *lengths,
+        size_t lengthsSize,
+        size_t rawValuesSize,
+        uint64_t guard
+);
+template size_t inverseTransformRleCodingSize<uint32_t>(
+        const uint32_t *lengths,
+        size_t lengthsSize,
+        size_t rawValuesSize,
+        uint64_t guard
+);
+template void transformRleCoding<uint64_t, uint64_t>(
+        const uint64_t *symbols,
+        size_t symbolsSize,
+        uint64_t guard,
+        uint64_t *rawValues,
+        size_t *rawValuesSize,
+        uint64_t *lengths,
+        size_t *lengthsSize
+);
+template void inverseTransformRleCoding<uint64_t, uint64_t>(
+        const uint64_t *rawValues,
+        size_t rawValuesSize,
+        const uint64_t *lengths,
+        size_t lengthsSize,
+        uint64_t guard,
+        uint64_t *symbols
+);
+template void transformRleCoding<uint64_t, uint64_t>(
+        const std::vector<uint64_t>& symbols,
+        uint64_t guard,
+        std::vector<uint64_t> *rawValues,
+        std::vector<uint64_t> *lengths
+);
+template void inverseTransformRleCoding<uint64_t, uint64_t>(
+        const std::vector<uint64_t>& rawValues,
+        const std::vector<uint64_t>& lengths,
+        uint64_t guard,
+        std::vector<uint64_t> *symbols
+);
+template void transformRleCoding<uint8_t, uint32_t>(
+        const uint8_t *symbols,
+        size_t symbolsSize,
+        uint64_t guard,
+        uint8_t *rawValues,
+        size_t *rawValuesSize,
+        uint32_t *lengths,
+        size_t *lengthsSize
+);
+template void inverseTransformRleCoding<uint8_t, uint32_t>(
+        const uint8_t *rawValues,
+        size_t rawValuesSize,
+        const uint32_t *lengths,
+        size_t lengthsSize,
+        uint64_t guard,
+        uint8_t *symbols
+);
+template void transformRleCoding<uint8_t, uint32_t>(
+        const std::vector<uint8_t>& symbols,
+        uint64_t guard,
+        std::vector<uint8_t> *rawValues,
+        std::vector<uint32_t> *lengths
+);
+template void inverseTransformRleCoding<uint8_t, uint32_t>(
+        const std::vector<uint8_t>& rawValues,
+        const std::vector<uint32_t>& lengths,
+        uint64_t guard,
+        std::vector<uint8_t> *symbols
+);
+template void transformRleCoding<uint16_t, uint32_t>(
+        const uint16_t *symbols,
+        size_t symbolsSize,
+        uint64_t guard,
+        uint16_t *rawValues,
+        size_t *rawValuesSize,
+        uint32_t *lengths,
+        size_t *lengthsSize
+);
+template void inverseTransformRleCoding<uint16_t, uint32_t>(
+        const uint16_t *rawValues,
+        size_t rawValuesSize,
+        const uint32_t *lengths,
+        size_t lengthsSize,
+        uint64_t guard,
+        uint16_t *symbols
+);
+template void transformRleCoding<uint16_t, uint32_t>(
+        const std::vector<uint16_t>& symbols,
+        uint64_t guard,
+        std::vector<uint16_t> *rawValues,
+        std::vector<uint32_t> *lengths
+);
+template void inverseTransformRleCoding<uint16_t, uint32_t>(
+        const std::vector<uint16_t>& rawValues,
+        const std::vector<uint32_t>& lengths,
+        uint64_t guard,
+        std::vector<uint16_t> *symbols
+);
+template void transformRleCoding<uint32_t, uint32_t>(
+        const uint32_t *symbols,
+        size_t symbolsSize,
+        uint64_t guard,
+        uint32_t *rawValues,
+        size_t *rawValuesSize,
+        uint32_t *lengths,
+        size_t *lengthsSize
+);
+template void inverseTransformRleCoding<uint32_t, uint32_t>(
+        const uint32_t *rawValues,
+        size_t rawValuesSize,
+        const uint32_t *lengths,
+        size_t lengthsSize,
+        uint64_t guard,
+        uint32_t *symbols
+);
+template void transformRleCoding<uint32_t, uint32_t>(
+        const std::vector<uint32_t>& symbols,
+        uint64_t guard,
+        std::vector<uint32_t> *rawValues,
+        std::vector<uint32_t> *lengths
+);
+template void inverseTransformRleCoding<uint32_t, uint32_t>(
+        const std::vector<uint32_t>& rawValues,
+        const std::vector<uint32_t>& lengths,
+        uint64_t guard,
+        std::vector<uint32_t> *symbols
+);
+template void transformRleCoding<uint64_t, uint32_t>(
+        const uint64_t *symbols,
+        size_t symbolsSize,
+        uint64_t guard,
+        uint64_t *rawValues,
+        size_t *rawValuesSize,
+        uint32_t *lengths,
+        size_t *lengthsSize
+);
+template void inverseTransformRleCoding<uint64_t, uint32_t>(
+        const uint64_t *rawValues,
+        size_t rawValuesSize,
+        const uint32_t *lengths,
+        size_t lengthsSize,
+        uint64_t guard,
+        uint64_t *symbols
+);
+template void transformRleCoding<uint64_t, uint32_t>(
+        const std::vector<uint64_t>& symbols,
+        uint64_t guard,
+        std::vector<uint64_t> *rawValues,
+        std::vector<uint32_t> *lengths
+);
+template void inverseTransformRleCoding<uint64_t, uint32_t>(
+        const std::vector<uint64_t>& rawValues,
+        const std::vector<uint32_t>& lengths,
+        uint64_t guard,
+        std::vector<uint64_t> *symbols
+);
+
+
 }  // namespace gabac
@@ -33,6 +33,43 @@ int gabac_inverseTransformRleCoding(
 );
 
 
+// Caller-buffer variants: nothing is allocated or copied. rawValues and
+// lengths need a capacity of symbolsSize elements each; the size of the
+// inverse transform can be queried in advance.
+int gabac_transformRleCodingInto(
+        const uint64_t *symbols,
+        size_t symbolsSize,
+        uint64_t guard,
+        uint64_t *rawValues,
+        size_t rawValuesCapacity,
+        size_t *rawValuesSize,
+        uint64_t *lengths,
+        size_t lengthsCapacity,
+        size_t *lengthsSize
+);
+
+
+int gabac_inverseTransformRleCodingSize(
+        const uint64_t *lengths,
+        size_t lengthsSize,
+        size_t rawValuesSize,
+        uint64_t guard,
+        size_t *symbolsSize
+);
+
+
+int gabac_inverseTransformRleCodingInto(
+        const uint64_t *rawValues,
+        size_t rawValuesSize,
+        const uint64_t *lengths,
+        size_t lengthsSize,
+        uint64_t guard,
+        uint64_t *symbols,
+        size_t symbolsCapacity,
+        size_t *symbolsSize
+);
+
+
 #ifdef __cplusplus
 }  // extern "C"
 
@@ -44,19 +81,58 @@ int gabac_inverseTransformRleCoding(
 namespace gabac {
 
 
+// T is one of uint8_t, uint16_t, uint32_t and uint64_t, the type of the
+// lengths I is uint32_t or uint64_t
+template<typename T, typename I>
+void transformRleCoding(
+        const std::vector<T>& symbols,
+        uint64_t guard,
+        std::vector<T> *rawValues,
+        std::vector<I> *lengths
+);
+
+
+template<typename T, typename I>
+void inverseTransformRleCoding(
+        const std::vector<T>& rawValues,
+        const std::vector<I>& lengths,
+        uint64_t guard,
+        std::vector<T> *symbols
+);
+
+
+// Versions on plain arrays; rawValues and lengths must hold symbolsSize
+// elements each
+template<typename T, typename I>
 void transformRleCoding(
-        const std::vector<uint64_t>& symbols,
+        const T *symbols,
+        size_t symbolsSize,
         uint64_t guard,
-        std::vector<uint64_t> *rawValues,
-        std::vector<uint64_t> *lengths
+        T *rawValues,
+        size_t *rawValuesSize,
+        I *lengths,
+        size_t *lengthsSize
 );
 
 
+// Number of symbols which the inverse transform will produce
+template<typename I>
+size_t inverseTransformRleCodingSize(
+        const I *lengths,
+        size_t lengthsSize,
+        size_t rawValuesSize,
+        uint64_t guard
+);
+
+
+template<typename T, typename I>
 void inverseTransformRleCoding(
-        const std::vector<uint64_t>& rawValues,
-        const std::vector<uint64_t>& lengths,
+        const T *rawValues,
+        size_t rawValuesSize,
+        const I *lengths,
+        size_t lengthsSize,
         uint64_t guard,
-        std::vector<uint64_t> *symbols
+        T *symbols
 );
 
 
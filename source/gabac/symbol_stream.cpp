@@ -0,0 +1,62 @@
+#include "gabac/symbol_stream.h"
+
+#include <cassert>
+#include <vector>
+
+
+namespace gabac {
+
+
+SymbolStream::SymbolStream(
+        unsigned int wordSize
+)
+        : m_wordSize(wordSize),
+        m_symbols8(),
+        m_symbols16(),
+        m_symbols32(),
+        m_symbols64(){
+    assert((wordSize == 1) || (wordSize == 2) || (wordSize == 4) || (wordSize == 8));
+}
+
+
+SymbolStream::~SymbolStream() = default;
+
+
+unsigned int SymbolStream::getWordSize() const
+{
+    return m_wordSize;
+}
+
+
+size_t SymbolStream::size() const
+{
+    switch (m_wordSize)
+    {
+        case 1:
+            return m_symbols8.size();
+        case 2:
+            return m_symbols16.size();
+        case 4:
+            return m_symbols32.size();
+        default:
+            return m_symbols64.size();
+    }
+}
+
+
+bool SymbolStream::empty() const
+{
+    return size() == 0;
+}
+
+
+void SymbolStream::clear()
+{
+    std::vector<uint8_t>().swap(m_symbols8);
+    std::vector<uint16_t>().swap(m_symbols16);
+    std::vector<uint32_t>().swap(m_symbols32);
+    std::vector<uint64_t>().swap(m_symbols64);
+}
+
+
+}  // namespace gabac
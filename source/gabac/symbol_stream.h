@@ -0,0 +1,85 @@
+#ifndef GABAC_SYMBOL_STREAM_H_
+#define GABAC_SYMBOL_STREAM_H_
+
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+using std::size_t;
+
+namespace gabac {
+
+
+// Sequence of symbols of wordSize (1, 2, 4 or 8) bytes each. The symbols are
+// held in the unsigned type of exactly that width, so that e.g. a byte
+// stream takes one byte per symbol in memory, not eight. Code working on the
+// symbols dispatches on getWordSize() once and then runs on get<T>().
+class SymbolStream
+{
+ public:
+    explicit SymbolStream(
+            unsigned int wordSize = 8
+    );
+
+    ~SymbolStream();
+
+    unsigned int getWordSize() const;
+
+    size_t size() const;
+
+    bool empty() const;
+
+    // Removes all symbols and releases their memory
+    void clear();
+
+    // T must be the unsigned type of getWordSize() bytes
+    template<typename T>
+    std::vector<T>& get()
+    {
+        assert(sizeof(T) == m_wordSize);
+        return symbols(static_cast<T *>(nullptr));
+    }
+
+    template<typename T>
+    const std::vector<T>& get() const
+    {
+        assert(sizeof(T) == m_wordSize);
+        return symbols(static_cast<T *>(nullptr));
+    }
+
+ private:
+    std::vector<uint8_t>& symbols(uint8_t *){ return m_symbols8; }
+
+    std::vector<uint16_t>& symbols(uint16_t *){ return m_symbols16; }
+
+    std::vector<uint32_t>& symbols(uint32_t *){ return m_symbols32; }
+
+    std::vector<uint64_t>& symbols(uint64_t *){ return m_symbols64; }
+
+    const std::vector<uint8_t>& symbols(uint8_t *) const { return m_symbols8; }
+
+    const std::vector<uint16_t>& symbols(uint16_t *) const { return m_symbols16; }
+
+    const std::vector<uint32_t>& symbols(uint32_t *) const { return m_symbols32; }
+
+    const std::vector<uint64_t>& symbols(uint64_t *) const { return m_symbols64; }
+
+    unsigned int m_wordSize;
+
+    // Only the vector matching m_wordSize is used
+    std::vector<uint8_t> m_symbols8;
+
+    std::vector<uint16_t> m_symbols16;
+
+    std::vector<uint32_t> m_symbols32;
+
+    std::vector<uint64_t> m_symbols64;
+};
+
+
+}  // namespace gabac
+
+
+#endif  // GABAC_SYMBOL_STREAM_H_
@@ -24,30 +24,42 @@ static unsigned int bitLength(
 ){
     unsigned int numBits = 0;
 
-    if (value > 0x7FFF)
+    if (value > 0xFFFFFFFF)
+    {
+        value >>= 32;
+        numBits += 32;
+    }
+
+    if (value > 0xFFFF)
     {
         value >>= 16;
         numBits += 16;
     }
 
-    if (value > 0x7F)
+    if (value > 0xFF)
     {
         value >>= 8;
         numBits += 8;
     }
 
-    if (value > 0x7)
+    if (value > 0xF)
     {
         value >>= 4;
         numBits += 4;
     }
 
-    if (value > 0x1)
+    if (value > 0x3)
     {
         value >>= 2;
         numBits += 2;
     }
 
+    if (value > 0x1)
+    {
+        value >>= 1;
+        numBits += 1;
+    }
+
     if (value > 0x0)
     {
         numBits += 1;
@@ -61,8 +73,10 @@ Writer::Writer(
         std::vector<unsigned char> *const bitstream
 )
         : m_bitOutputStream(bitstream),
+        m_rawBits(0),
+        m_numRawBits(0),
         // m_contextSelector(),
-        m_binaryArithmeticEncoder(m_bitOutputStream),
+        m_binaryArithmeticEncoder(&m_bitOutputStream),
         m_contextModels(contexttables::buildContextTable()){
 }
 
@@ -80,97 +94,319 @@ void Writer::start(
 
 void Writer::reset(){
     m_binaryArithmeticEncoder.flush();
-    m_contextModels = contexttables::buildContextTable();
+    contexttables::resetContextTable(&m_contextModels);
 }
 
 
-void Writer::writeBypassValue(
-        int64_t symbol,
-        const BinarizationId& binarizationId,
-        const std::vector<unsigned int>& binarizationParameters
+void Writer::restart(){
+    m_binaryArithmeticEncoder.rewind();
+    m_rawBits = 0;
+    m_numRawBits = 0;
+    contexttables::resetContextTable(&m_contextModels);
+}
+
+
+inline void Writer::writeRawBits(
+        uint64_t bits,
+        unsigned int numBits
 ){
-    // TODO(anyone): might crash if in release mode, because asserts are disabled and wrong parameters might be provided
-#ifndef NDEBUG
-    constexpr static unsigned int params[unsigned(BinarizationId::STEG) + 1u] = { 1, 1, 0, 0, 1, 1 };
-    assert(binarizationParameters.size() >= params[static_cast<unsigned int>(binarizationId)]);
-#endif
-    switch (binarizationId)
+    assert(numBits <= 32);
+    assert((numBits == 32) || (bits >> numBits) == 0);
+
+    // At most 31 bits are pending, so the accumulator cannot overflow
+    m_rawBits = (m_rawBits << numBits) | bits;
+    m_numRawBits += numBits;
+    if (m_numRawBits >= 32)
     {
-        case BinarizationId::BI:
-            writeAsBIbypass(symbol, binarizationParameters[0]);
-            break;
-        case BinarizationId::TU:
-            writeAsTUbypass(symbol, binarizationParameters[0]);
-            break;
-        case BinarizationId::EG:
-            writeAsEGbypass(symbol);
-            break;
-        case BinarizationId::SEG:
-            writeAsSEGbypass(symbol);
-            break;
-        case BinarizationId::TEG:
-            writeAsTEGbypass(symbol, binarizationParameters[0]);
-            break;
-        case BinarizationId::STEG:
-            writeAsSTEGbypass(symbol, binarizationParameters[0]);
-            break;
+        m_numRawBits -= 32;
+        auto word = static_cast<uint32_t>(m_rawBits >> m_numRawBits);
+        m_bitOutputStream.writeByte(static_cast<unsigned char>(word >> 24u));
+        m_bitOutputStream.writeByte(static_cast<unsigned char>(word >> 16u));
+        m_bitOutputStream.writeByte(static_cast<unsigned char>(word >> 8u));
+        m_bitOutputStream.writeByte(static_cast<unsigned char>(word));
+    }
+}
+
+
+void Writer::startRaw(
+        size_t numSymbols
+){
+    assert(numSymbols <= std::numeric_limits<unsigned>::max());
+    writeRawBits(numSymbols, 32);
+}
+
+
+void Writer::finishRaw(){
+    // Write out the remaining bits, zero-padded to a full byte
+    while (m_numRawBits >= 8)
+    {
+        m_numRawBits -= 8;
+        m_bitOutputStream.writeByte(static_cast<unsigned char>(m_rawBits >> m_numRawBits));
+    }
+    if (m_numRawBits > 0)
+    {
+        m_bitOutputStream.writeByte(static_cast<unsigned char>(m_rawBits << (8 - m_numRawBits)));
+    }
+    m_rawBits = 0;
+    m_numRawBits = 0;
+    m_bitOutputStream.flush();
+}
+
+
+void Writer::startEstimation(){
+    m_binaryArithmeticEncoder.startEstimation();
+}
+
+
+uint64_t Writer::getFracBits() const
+{
+    return m_binaryArithmeticEncoder.getFracBits();
+}
+
+
+size_t Writer::getNumBytesWritten(
+        bool raw
+) const
+{
+    return raw ? m_bitOutputStream.getNumBytesWritten() : m_binaryArithmeticEncoder.getNumBytesWritten();
+}
+
+
+template<typename T, BinarizationId binarizationId, ContextSelectionId contextSelectionId>
+bool Writer::writeValuesKernel(
+        const T *const symbols,
+        size_t numSymbols,
+        unsigned int binarizationParameter,
+        size_t maxNumBytes
+){
+    // Binarization and context selection are fixed for the whole stream, so
+    // all switches below are resolved at compile time
+    unsigned int previousSymbol = 0;
+    unsigned int previousPreviousSymbol = 0;
+
+    // The budget is checked every few symbols only
+    const size_t BUDGET_CHECK_INTERVAL = 1024;
+
+    for (size_t i = 0; i < numSymbols; i++)
+    {
+        if ((i % BUDGET_CHECK_INTERVAL) == 0 &&
+            getNumBytesWritten(contextSelectionId == ContextSelectionId::raw) > maxNumBytes)
+        {
+            return false;
+        }
+
+        auto symbol = static_cast<int64_t>(symbols[i]);
+
+        if (contextSelectionId == ContextSelectionId::raw)
+        {
+            switch (binarizationId)
+            {
+                case BinarizationId::BI:
+                    writeAsBIraw(symbol, binarizationParameter);
+                    break;
+                case BinarizationId::TU:
+                    writeAsTUraw(symbol, binarizationParameter);
+                    break;
+                case BinarizationId::EG:
+                    writeAsEGraw(symbol);
+                    break;
+                case BinarizationId::SEG:
+                    writeAsSEGraw(symbol);
+                    break;
+                case BinarizationId::TEG:
+                    writeAsTEGraw(symbol, binarizationParameter);
+                    break;
+                case BinarizationId::STEG:
+                    writeAsSTEGraw(symbol, binarizationParameter);
+                    break;
+            }
+            continue;
+        }
+
+        if (contextSelectionId == ContextSelectionId::bypass)
+        {
+            switch (binarizationId)
+            {
+                case BinarizationId::BI:
+                    writeAsBIbypass(symbol, binarizationParameter);
+                    break;
+                case BinarizationId::TU:
+                    writeAsTUbypass(symbol, binarizationParameter);
+                    break;
+                case BinarizationId::EG:
+                    writeAsEGbypass(symbol);
+                    break;
+                case BinarizationId::SEG:
+                    writeAsSEGbypass(symbol);
+                    break;
+                case BinarizationId::TEG:
+                    writeAsTEGbypass(symbol, binarizationParameter);
+                    break;
+                case BinarizationId::STEG:
+                    writeAsSTEGbypass(symbol, binarizationParameter);
+                    break;
+            }
+            continue;
+        }
+
+        unsigned int offset = (previousSymbol << 2u) + previousPreviousSymbol;
+        switch (binarizationId)
+        {
+            case BinarizationId::BI:
+                writeAsBIcabac(symbol, binarizationParameter, offset);
+                break;
+            case BinarizationId::TU:
+                writeAsTUcabac(symbol, binarizationParameter, offset);
+                break;
+            case BinarizationId::EG:
+                writeAsEGcabac(symbol, offset);
+                break;
+            case BinarizationId::SEG:
+                writeAsSEGcabac(symbol, offset);
+                break;
+            case BinarizationId::TEG:
+                writeAsTEGcabac(symbol, binarizationParameter, offset);
+                break;
+            case BinarizationId::STEG:
+                writeAsSTEGcabac(symbol, binarizationParameter, offset);
+                break;
+        }
+
+        if (contextSelectionId == ContextSelectionId::adaptive_coding_order_2)
+        {
+            previousPreviousSymbol = previousSymbol;
+        }
+        if (contextSelectionId != ContextSelectionId::adaptive_coding_order_0)
+        {
+            previousSymbol = ContextSelector::getContextHistoryValue(symbol);
+        }
+    }
+
+    return true;
+}
+
+
+template<typename T, BinarizationId binarizationId>
+bool Writer::writeValuesWithBinarization(
+        const T *const symbols,
+        size_t numSymbols,
+        unsigned int binarizationParameter,
+        const ContextSelectionId& contextSelectionId,
+        size_t maxNumBytes
+){
+    switch (contextSelectionId)
+    {
+        case ContextSelectionId::bypass:
+            return writeValuesKernel<T, binarizationId, ContextSelectionId::bypass>(
+                    symbols,
+                    numSymbols,
+                    binarizationParameter,
+                    maxNumBytes
+            );
+        case ContextSelectionId::adaptive_coding_order_0:
+            return writeValuesKernel<T, binarizationId, ContextSelectionId::adaptive_coding_order_0>(
+                    symbols,
+                    numSymbols,
+                    binarizationParameter,
+                    maxNumBytes
+            );
+        case ContextSelectionId::adaptive_coding_order_1:
+            return writeValuesKernel<T, binarizationId, ContextSelectionId::adaptive_coding_order_1>(
+                    symbols,
+                    numSymbols,
+                    binarizationParameter,
+                    maxNumBytes
+            );
+        case ContextSelectionId::adaptive_coding_order_2:
+            return writeValuesKernel<T, binarizationId, ContextSelectionId::adaptive_coding_order_2>(
+                    symbols,
+                    numSymbols,
+                    binarizationParameter,
+                    maxNumBytes
+            );
+        case ContextSelectionId::raw:
+            return writeValuesKernel<T, binarizationId, ContextSelectionId::raw>(
+                    symbols,
+                    numSymbols,
+                    binarizationParameter,
+                    maxNumBytes
+            );
         default:
-            // TODO(Jan): handle default case
-            break;
+            assert(false);
+            return false;
     }
 }
 
-void Writer::writeCabacAdaptiveValue(
-        int64_t symbol,
+
+template<typename T>
+bool Writer::writeValues(
+        const T *const symbols,
+        size_t numSymbols,
         const BinarizationId& binarizationId,
         const std::vector<unsigned int>& binarizationParameters,
-        unsigned int prevValue,
-        unsigned int prevPrevValue
+        const ContextSelectionId& contextSelectionId,
+        size_t maxNumBytes
 ){
+    // TODO(anyone): might crash if in release mode, because asserts are disabled and wrong parameters might be provided
 #ifndef NDEBUG
     constexpr static unsigned int params[unsigned(BinarizationId::STEG) + 1u] = { 1, 1, 0, 0, 1, 1 };
     assert(binarizationParameters.size() >= params[static_cast<unsigned int>(binarizationId)]);
 #endif
-    unsigned int offset = (prevValue << 2u) + prevPrevValue;
+    unsigned int binarizationParameter = binarizationParameters.empty() ? 0 : binarizationParameters[0];
+
     switch (binarizationId)
     {
         case BinarizationId::BI:
-            writeAsBIcabac(
-                    symbol,
-                    binarizationParameters[0],
-                    offset);
-            break;
+            return writeValuesWithBinarization<T, BinarizationId::BI>(
+                    symbols,
+                    numSymbols,
+                    binarizationParameter,
+                    contextSelectionId,
+                    maxNumBytes
+            );
         case BinarizationId::TU:
-            writeAsTUcabac(
-                    symbol,
-                    binarizationParameters[0],
-                    offset);
-            break;
+            return writeValuesWithBinarization<T, BinarizationId::TU>(
+                    symbols,
+                    numSymbols,
+                    binarizationParameter,
+                    contextSelectionId,
+                    maxNumBytes
+            );
         case BinarizationId::EG:
-            writeAsEGcabac(
-                    symbol,
-                    offset);
-            break;
+            return writeValuesWithBinarization<T, BinarizationId::EG>(
+                    symbols,
+                    numSymbols,
+                    binarizationParameter,
+                    contextSelectionId,
+                    maxNumBytes
+            );
         case BinarizationId::SEG:
-            writeAsSEGcabac(
-                    symbol,
-                    offset);
-            break;
+            return writeValuesWithBinarization<T, BinarizationId::SEG>(
+                    symbols,
+                    numSymbols,
+                    binarizationParameter,
+                    contextSelectionId,
+                    maxNumBytes
+            );
         case BinarizationId::TEG:
-            writeAsTEGcabac(
-                    symbol,
-                    binarizationParameters[0],
-                    offset);
-            break;
+            return writeValuesWithBinarization<T, BinarizationId::TEG>(
+                    symbols,
+                    numSymbols,
+                    binarizationParameter,
+                    contextSelectionId,
+                    maxNumBytes
+            );
         case BinarizationId::STEG:
-            writeAsSTEGcabac(
-                    symbol,
-                    binarizationParameters[0],
-                    offset);
-            break;
+            return writeValuesWithBinarization<T, BinarizationId::STEG>(
+                    symbols,
+                    numSymbols,
+                    binarizationParameter,
+                    contextSelectionId,
+                    maxNumBytes
+            );
         default:
-            // TODO(Jan): handle default case
-            break;
+            assert(false);
+            return false;
     }
 }
 
@@ -201,6 +437,15 @@ void Writer::writeAsBIcabac(
 }
 
 
+void Writer::writeAsBIraw(
+        int64_t input,
+        unsigned int cLength
+){
+    assert(binarizationInformation[unsigned(BinarizationId::BI)].sbCheck(input, input, cLength));
+    writeRawBits(static_cast<uint64_t>(input), cLength);
+}
+
+
 void Writer::writeAsTUbypass(
         int64_t input,
         unsigned int cMax
@@ -241,15 +486,42 @@ void Writer::writeAsTUcabac(
 }
 
 
+void Writer::writeAsTUraw(
+        int64_t input,
+        unsigned int cMax
+){
+    assert(binarizationInformation[unsigned(BinarizationId::TU)].sbCheck(input, input, cMax));
+
+    auto numOnes = static_cast<unsigned int>(input);
+    while (numOnes > 31)
+    {
+        writeRawBits(0x7fffffffu, 31);
+        numOnes -= 31;
+    }
+    if (input != cMax)
+    {
+        writeRawBits(((1ull << numOnes) - 1) << 1u, numOnes + 1);
+    }
+    else
+    {
+        writeRawBits((1ull << numOnes) - 1, numOnes);
+    }
+}
+
+
 void Writer::writeAsEGbypass(
         int64_t input
 ){
     assert(binarizationInformation[unsigned(BinarizationId::EG)].sbCheck(input, input, 0));
 
     input++;
-    unsigned int length = ((bitLength(static_cast<uint64_t>(input)) - 1) << 1u) + 1;
     assert(input <= std::numeric_limits<unsigned>::max());
-    m_binaryArithmeticEncoder.encodeBinsEP(static_cast<unsigned >(input), length);
+
+    // Code words have up to 63 bins; the zero prefix is written separately,
+    // so that the bins never need to be shifted by 32 or more
+    unsigned int numBits = bitLength(static_cast<uint64_t>(input));
+    m_binaryArithmeticEncoder.encodeBinsEP(0, numBits - 1);
+    m_binaryArithmeticEncoder.encodeBinsEP(static_cast<unsigned >(input), numBits);
 }
 
 
@@ -286,6 +558,18 @@ void Writer::writeAsEGcabac(
 }
 
 
+void Writer::writeAsEGraw(
+        int64_t input
+){
+    assert(binarizationInformation[unsigned(BinarizationId::EG)].sbCheck(input, input, 0));
+
+    input++;
+    unsigned int numBits = bitLength(static_cast<uint64_t>(input));
+    writeRawBits(0, numBits - 1);
+    writeRawBits(static_cast<uint64_t>(input), numBits);
+}
+
+
 void Writer::writeAsSEGbypass(
         int64_t input
 ){
@@ -318,6 +602,21 @@ void Writer::writeAsSEGcabac(
 }
 
 
+void Writer::writeAsSEGraw(
+        int64_t input
+){
+    assert(binarizationInformation[unsigned(BinarizationId::SEG)].sbCheck(input, input, 0));
+    if (input <= 0)
+    {
+        writeAsEGraw(static_cast<unsigned int>(-input) << 1u);
+    }
+    else
+    {
+        writeAsEGraw(static_cast<unsigned int>(static_cast<uint64_t>(input) << 1u) - 1);
+    }
+}
+
+
 void Writer::writeAsTEGbypass(
         int64_t input,
         unsigned int cTruncExpGolParam
@@ -355,6 +654,24 @@ void Writer::writeAsTEGcabac(
 }
 
 
+void Writer::writeAsTEGraw(
+        int64_t input,
+        unsigned int cTruncExpGolParam
+){
+    assert(binarizationInformation[unsigned(BinarizationId::TEG)].sbCheck(input, input, cTruncExpGolParam));
+
+    if (input < cTruncExpGolParam)
+    {
+        writeAsTUraw(input, cTruncExpGolParam);
+    }
+    else
+    {
+        writeAsTUraw(cTruncExpGolParam, cTruncExpGolParam);
+        writeAsEGraw(input - cTruncExpGolParam);
+    }
+}
+
+
 void Writer::writeAsSTEGbypass(
         int64_t input,
         unsigned int cSignedTruncExpGolParam
@@ -402,6 +719,29 @@ void Writer::writeAsSTEGcabac(
 }
 
 
+void Writer::writeAsSTEGraw(
+        int64_t input,
+        unsigned int cSignedTruncExpGolParam
+){
+    assert(binarizationInformation[unsigned(BinarizationId::STEG)].sbCheck(input, input, cSignedTruncExpGolParam));
+
+    if (input < 0)
+    {
+        writeAsTEGraw(-1 * input, cSignedTruncExpGolParam);
+        writeAsBIraw(1, 1);
+    }
+    else if (input > 0)
+    {
+        writeAsTEGraw(input, cSignedTruncExpGolParam);
+        writeAsBIraw(0, 1);
+    }
+    else
+    {
+        writeAsTEGraw(0, cSignedTruncExpGolParam);
+    }
+}
+
+
 void Writer::writeNumSymbols(
         unsigned int numSymbols
 ){
@@ -409,4 +749,47 @@ void Writer::writeNumSymbols(
 }
 
 
+// Symbol widths used by the encoding/decoding front ends
+template bool Writer::writeValues<int64_t>(
+        const int64_t *symbols,
+        size_t numSymbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        size_t maxNumBytes
+);
+template bool Writer::writeValues<uint8_t>(
+        const uint8_t *symbols,
+        size_t numSymbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        size_t maxNumBytes
+);
+template bool Writer::writeValues<uint16_t>(
+        const uint16_t *symbols,
+        size_t numSymbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        size_t maxNumBytes
+);
+template bool Writer::writeValues<uint32_t>(
+        const uint32_t *symbols,
+        size_t numSymbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        size_t maxNumBytes
+);
+template bool Writer::writeValues<uint64_t>(
+        const uint64_t *symbols,
+        size_t numSymbols,
+        const BinarizationId& binarizationId,
+        const std::vector<unsigned int>& binarizationParameters,
+        const ContextSelectionId& contextSelectionId,
+        size_t maxNumBytes
+);
+
+
 }  // namespace gabac
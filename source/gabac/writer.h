@@ -3,6 +3,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <vector>
 
 #include "gabac/bit_output_stream.h"
@@ -22,6 +23,11 @@ class Writer
             std::vector<unsigned char> *bitstream
     );
 
+    // The arithmetic encoder refers to the bit output stream of the writer
+    Writer(const Writer&) = delete;
+
+    Writer& operator=(const Writer&) = delete;
+
     ~Writer();
 
     void start(
@@ -30,18 +36,36 @@ class Writer
 
     void reset();
 
-    void writeBypassValue(
-            int64_t symbol,
-            const BinarizationId& binarizationId,
-            const std::vector<unsigned int>& binarizationParameters
+    // Discards all output and brings the writer back to its initial state
+    // without reallocating the context table or the bitstream
+    void restart();
+
+    // Raw mode: the bins of all symbols are bit-packed directly into the
+    // bitstream; the arithmetic encoder is not used at all
+    void startRaw(
+            size_t numSymbols
     );
 
-    void writeCabacAdaptiveValue(
-            int64_t symbol,
+    void finishRaw();
+
+    // Estimation mode: instead of writing the bitstream, the costs of the
+    // bins are summed up (not applicable to the raw mode)
+    void startEstimation();
+
+    // Estimated size in units of 2^-cabactables::FRAC_BITS_PRECISION bits
+    uint64_t getFracBits() const;
+
+    // T is int64_t or one of uint8_t, uint16_t, uint32_t, uint64_t. Returns
+    // false if more than maxNumBytes bytes have been written before all
+    // symbols are written; the writer then has to be restarted.
+    template<typename T>
+    bool writeValues(
+            const T *symbols,
+            size_t numSymbols,
             const BinarizationId& binarizationId,
             const std::vector<unsigned int>& binarizationParameters,
-            unsigned int prevValue,
-            unsigned int prevPrevValue
+            const ContextSelectionId& contextSelectionId,
+            size_t maxNumBytes = std::numeric_limits<size_t>::max()
     );
 
     void writeAsBIbypass(
@@ -55,6 +79,11 @@ class Writer
             unsigned int offset
     );
 
+    void writeAsBIraw(
+            int64_t input,
+            unsigned int cLength
+    );
+
     void writeAsTUbypass(
             int64_t input,
             unsigned int cMax
@@ -66,6 +95,11 @@ class Writer
             unsigned int offset
     );
 
+    void writeAsTUraw(
+            int64_t input,
+            unsigned int cMax
+    );
+
     void writeAsEGbypass(
             int64_t input
     );
@@ -75,6 +109,10 @@ class Writer
             unsigned int offset
     );
 
+    void writeAsEGraw(
+            int64_t input
+    );
+
     void writeAsSEGbypass(
             int64_t input
     );
@@ -84,6 +122,10 @@ class Writer
             unsigned int offset
     );
 
+    void writeAsSEGraw(
+            int64_t input
+    );
+
     void writeAsTEGbypass(
             int64_t input,
             unsigned int cTruncExpGolParam
@@ -95,6 +137,11 @@ class Writer
             unsigned int offset
     );
 
+    void writeAsTEGraw(
+            int64_t input,
+            unsigned int cTruncExpGolParam
+    );
+
     void writeAsSTEGbypass(
             int64_t input,
             unsigned int cSignedTruncExpGolParam
@@ -106,13 +153,50 @@ class Writer
             unsigned int offset
     );
 
+    void writeAsSTEGraw(
+            int64_t input,
+            unsigned int cSignedTruncExpGolParam
+    );
+
     void writeNumSymbols(
             unsigned int numSymbols
     );
 
  private:
+    template<typename T, BinarizationId binarizationId>
+    bool writeValuesWithBinarization(
+            const T *symbols,
+            size_t numSymbols,
+            unsigned int binarizationParameter,
+            const ContextSelectionId& contextSelectionId,
+            size_t maxNumBytes
+    );
+
+    template<typename T, BinarizationId binarizationId, ContextSelectionId contextSelectionId>
+    bool writeValuesKernel(
+            const T *symbols,
+            size_t numSymbols,
+            unsigned int binarizationParameter,
+            size_t maxNumBytes
+    );
+
+    size_t getNumBytesWritten(
+            bool raw
+    ) const;
+
+    void writeRawBits(
+            uint64_t bits,
+            unsigned int numBits
+    );
+
+    // Shared by the raw mode and the arithmetic encoder
     BitOutputStream m_bitOutputStream;
 
+    // Bit accumulator for raw mode; whole 32-bit words are written out
+    uint64_t m_rawBits;
+
+    unsigned int m_numRawBits;
+
     // ContextSelector m_contextSelector;
 
     BinaryArithmeticEncoder m_binaryArithmeticEncoder;
@@ -6,18 +6,26 @@
 #include <cstdio>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <exception>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <utility>
 #include <string>
+#include <system_error>
+#include <thread>
 #include <vector>
 
 #include "gabac/constants.h"
 #include "gabac/encoding.h"
+#include "gabac/return_codes.h"
 
 #include "gabacify/configuration.h"
+#include "gabacify/cost_model.h"
 #include "gabacify/encode.h"
 #include "gabacify/exceptions.h"
 #include "gabacify/helpers.h"
@@ -35,11 +43,13 @@ struct CandidateConfig
     std::vector<uint32_t> candidateMatchCodingParameters;
     std::vector<uint32_t> candidateRLECodingParameters;
     std::vector<bool> candidateLUTCodingParameters;
+    std::vector<unsigned> candidateLUTOrders;
     std::vector<bool> candidateDiffParameters;
     std::vector<gabac::BinarizationId> candidateUnsignedBinarizationIds;
     std::vector<gabac::BinarizationId> candidateSignedBinarizationIds;
     std::vector<unsigned> candidateBinarizationParameters;
     std::vector<gabac::ContextSelectionId> candidateContextSelectionIds;
+    size_t numDryRunCandidates;
 };
 
 static const CandidateConfig& getCandidateConfig(){
@@ -56,7 +66,9 @@ static const CandidateConfig& getCandidateConfig(){
             },
             { // Match coding window sizes
                     32,
-                    256
+                    256,
+                    65536,
+                    16777216
             },
             { // RLE Guard
                     255
@@ -65,9 +77,14 @@ static const CandidateConfig& getCandidateConfig(){
                     false,
                     true
             },
+            { // LUT orders
+                    0,
+                    1,
+                    2
+            },
             { // Diff transform
-                    false//,
-                    //true
+                    false,
+                    true
             },
             { // Binarizations (unsigned)
                     gabac::BinarizationId::BI,
@@ -88,92 +105,110 @@ static const CandidateConfig& getCandidateConfig(){
                     gabac::ContextSelectionId::adaptive_coding_order_0,
                     gabac::ContextSelectionId::adaptive_coding_order_1,
                     gabac::ContextSelectionId::adaptive_coding_order_2
-            }
+            },
+            // Candidates per stream which are dry-run encoded, by estimated
+            // size
+            3
     };
     return config;
 }
 
 //------------------------------------------------------------------------------
 
-void getOptimumOfBinarizationParameter(const std::vector<int64_t>& diffTransformedSequence,
+// The symbols are either a diff transformed std::vector<int64_t> or, without
+// diff coding, a gabac::SymbolStream, which is coded in its own width
+
+template<typename Symbols>
+void getOptimumOfBinarizationParameter(const Symbols& diffTransformedSequence,
                                        gabac::BinarizationId binID,
                                        unsigned binParameter,
+                                       gabac::ContextSelectionId contextID,
+                                       size_t maxNumBytes,
                                        std::vector<uint8_t> *const bestByteStream,
                                        const std::vector<uint8_t>& lut,
                                        TransformedSequenceConfiguration *const bestConfig,
                                        TransformedSequenceConfiguration *const currentConfig
 ){
-
-    for (const auto& transID : getCandidateConfig().candidateContextSelectionIds)
+    GABACIFY_LOG_TRACE << "Trying Context: " << unsigned(contextID);
+    std::vector<uint8_t> currentStream;
+
+    currentConfig->binarizationId = binID;
+    currentConfig->binarizationParameters = {binParameter};
+    currentConfig->contextSelectionId = contextID;
+    if (gabac::encode(diffTransformedSequence, binID, {binParameter}, contextID, &currentStream, maxNumBytes) !=
+        GABAC_SUCCESS)
     {
-        GABACIFY_LOG_TRACE << "Trying Context: " << unsigned(transID);
-        std::vector<uint8_t> currentStream;
-
-        currentConfig->contextSelectionId = transID;
-        gabac::encode(diffTransformedSequence, binID, {binParameter}, transID, &currentStream);
+        GABACIFY_LOG_TRACE << "Compressed size exceeds " << maxNumBytes << " bytes: Skipping";
+        return;
+    }
 
-        GABACIFY_LOG_TRACE << "Compressed size with parameter: " << currentStream.size();
-
-        if ((currentStream.size() + lut.size() + 4 < bestByteStream->size()) || bestByteStream->empty())
-        {
-            GABACIFY_LOG_TRACE << "Found new best context config: " << currentConfig->toPrintableString();
-            *bestByteStream = lut;
-            appendToBytestream(currentStream, bestByteStream);
-            *bestConfig = *currentConfig;
-        }
+    GABACIFY_LOG_TRACE << "Compressed size with parameter: " << currentStream.size();
 
+    if ((currentStream.size() + lut.size() + 4 < bestByteStream->size()) || bestByteStream->empty())
+    {
+        GABACIFY_LOG_TRACE << "Found new best context config: " << currentConfig->toPrintableString();
+        *bestByteStream = lut;
+        appendToBytestream(currentStream, bestByteStream);
+        *bestConfig = *currentConfig;
     }
 }
 
 //------------------------------------------------------------------------------
 
-void getOptimumOfBinarization(const std::vector<int64_t>& diffTransformedSequence,
-                              gabac::BinarizationId binID,
-                              int64_t min, int64_t max,
-                              std::vector<uint8_t> *const bestByteStream,
-                              const std::vector<uint8_t>& lut,
-                              TransformedSequenceConfiguration *const bestConfig,
-                              TransformedSequenceConfiguration *const currentConfig
+struct EncodingCandidate
+{
+    gabac::BinarizationId binarizationId;
+    unsigned binarizationParameter;
+    gabac::ContextSelectionId contextSelectionId;
+    double estimatedSize;
+};
+
+//------------------------------------------------------------------------------
+
+// Without a cost model, the estimated sizes are 0
+void getCandidatesOfBinarization(const CostModel *const costModel,
+                                 gabac::BinarizationId binID,
+                                 int64_t min, int64_t max,
+                                 std::vector<EncodingCandidate> *const candidates
 ){
 
     const unsigned BIPARAM = (max > 0) ? unsigned(std::floor(std::log2(max))+1) : 1;
     const unsigned TUPARAM = (max > 0) ? max : 1;
-    const std::vector<std::vector<unsigned>> candidates = {{std::min(BIPARAM, 32u)},
+    const std::vector<std::vector<unsigned>> parameters = {{std::min(BIPARAM, 32u)},
                                                            {std::min(TUPARAM, 32u)},
                                                            {0},
                                                            {0},
                                                            getCandidateConfig().candidateBinarizationParameters,
                                                            getCandidateConfig().candidateBinarizationParameters};
 
-    for (const auto& transID : candidates[unsigned(binID)])
+    for (const auto& transID : parameters[unsigned(binID)])
     {
-        GABACIFY_LOG_TRACE << "Trying Parameter: " << transID;
-
         if (!gabac::binarizationInformation[unsigned(binID)].sbCheck(min, max, transID))
         {
             GABACIFY_LOG_TRACE << "NOT valid for this stream!" << transID;
             continue;
         }
 
-        currentConfig->binarizationParameters = {transID};
-
-        getOptimumOfBinarizationParameter(
-                diffTransformedSequence,
-                binID,
-                transID,
-                bestByteStream,
-                lut,
-                bestConfig,
-                currentConfig
-        );
-
+        for (const auto& contextID : getCandidateConfig().candidateContextSelectionIds)
+        {
+            double estimatedSize = costModel ? costModel->estimateSize(binID, transID, contextID) : 0.0;
+            GABACIFY_LOG_TRACE << "Estimated size of binarization " << unsigned(binID) << " with parameter "
+                               << transID << " and context " << unsigned(contextID) << ": " << estimatedSize;
+            candidates->push_back({binID, transID, contextID, estimatedSize});
+        }
     }
 }
 
 //------------------------------------------------------------------------------
 
-void getOptimumOfDiffTransformedStream(const std::vector<int64_t>& diffTransformedSequence,
+// Only the candidates with the smallest estimated sizes are dry-run encoded.
+// Candidates whose byte stream (including the LUT) is larger than
+// maxNumBytes, or not smaller than bestByteStream, are dropped as soon as
+// their encoders pass that size.
+template<typename Symbols>
+void getOptimumOfDiffTransformedStream(const Symbols& diffTransformedSequence,
                                        unsigned wordsize,
+                                       size_t maxNumBytes,
                                        std::vector<uint8_t> *const bestByteStream,
                                        const std::vector<uint8_t>& lut,
                                        TransformedSequenceConfiguration *const bestConfig,
@@ -181,39 +216,122 @@ void getOptimumOfDiffTransformedStream(const std::vector<int64_t>& diffTransform
 ){
     int64_t min, max;
     GABACIFY_LOG_TRACE << "Stream analysis: ";
+
+    // The encoded stream is preceded by the LUT and its 4-byte size
+    if (!bestByteStream->empty())
+    {
+        maxNumBytes = std::min(maxNumBytes, bestByteStream->size() - 1);
+    }
+    if (maxNumBytes < lut.size() + 4)
+    {
+        GABACIFY_LOG_TRACE << "LUT alone exceeds " << maxNumBytes << " bytes: Skipping";
+        return;
+    }
+    size_t maxNumStreamBytes = maxNumBytes - lut.size() - 4;
+
     deriveMinMaxSigned(diffTransformedSequence, wordsize, &min, &max);
 
     GABACIFY_LOG_TRACE << "Min: " << min << "; Max: " << max;
 
-    std::vector<gabac::BinarizationId>
-            candidates = (min >= 0)
-                         ? getCandidateConfig().candidateUnsignedBinarizationIds
-                         : getCandidateConfig().candidateSignedBinarizationIds; // TODO: avoid copy
+    const std::vector<gabac::BinarizationId>& binarizations =
+            (min >= 0)
+            ? getCandidateConfig().candidateUnsignedBinarizationIds
+            : getCandidateConfig().candidateSignedBinarizationIds;
 
-    for (const auto& transID : candidates)
+    // Short streams are dry-run encoded with all candidates, which is
+    // cheaper than building a cost model for them
+    const size_t MIN_ESTIMATED_STREAM_SIZE = 1024;
+    std::unique_ptr<CostModel> costModel;
+    if (diffTransformedSequence.size() >= MIN_ESTIMATED_STREAM_SIZE)
     {
-        GABACIFY_LOG_TRACE << "Trying Binarization: " << unsigned(transID);
+        costModel.reset(new CostModel(diffTransformedSequence));
+    }
 
+    std::vector<EncodingCandidate> candidates;
+    for (const auto& transID : binarizations)
+    {
+        getCandidatesOfBinarization(costModel.get(), transID, min, max, &candidates);
+    }
+
+    size_t numDryRunCandidates = candidates.size();
+    if (costModel)
+    {
+        numDryRunCandidates = std::min(numDryRunCandidates, getCandidateConfig().numDryRunCandidates);
+    }
+    std::partial_sort(
+            candidates.begin(),
+            candidates.begin() + numDryRunCandidates,
+            candidates.end(),
+            [](const EncodingCandidate& a, const EncodingCandidate& b)
+            {
+                return a.estimatedSize < b.estimatedSize;
+            }
+    );
+
+    // The estimates are accurate to a few percent, so that a stream which
+    // is estimated to be clearly larger than the best one is not encoded
+    const double ESTIMATE_TOLERANCE = 1.1;
+    if (costModel && !bestByteStream->empty() && numDryRunCandidates > 0 &&
+        (candidates[0].estimatedSize + lut.size()) > ESTIMATE_TOLERANCE * bestByteStream->size())
+    {
+        GABACIFY_LOG_TRACE << "Estimated size " << candidates[0].estimatedSize << " is too large: Skipping";
+        return;
+    }
 
-        currentConfig->binarizationId = transID;
-        getOptimumOfBinarization(
+    // The remaining candidates are dry-run encoded, each one within the size
+    // of the smallest one so far, and only the smallest one is actually
+    // encoded
+    size_t bestCandidate = 0;
+    double bestNumBits = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < numDryRunCandidates; i++)
+    {
+        double numBits = 0;
+        if (gabac::estimateBits(
                 diffTransformedSequence,
-                transID,
-                min,
-                max,
-                bestByteStream,
-                lut,
-                bestConfig,
-                currentConfig
-        );
+                candidates[i].binarizationId,
+                {candidates[i].binarizationParameter},
+                candidates[i].contextSelectionId,
+                &numBits,
+                maxNumStreamBytes
+        ) != GABAC_SUCCESS)
+        {
+            GABACIFY_LOG_TRACE << "Dry-run size of candidate with estimated size " << candidates[i].estimatedSize
+                               << " exceeds " << maxNumStreamBytes << " bytes";
+            continue;
+        }
+        GABACIFY_LOG_TRACE << "Dry-run size of candidate with estimated size " << candidates[i].estimatedSize
+                           << ": " << numBits / 8;
+        if (numBits < bestNumBits)
+        {
+            bestNumBits = numBits;
+            bestCandidate = i;
+            maxNumStreamBytes = std::min(maxNumStreamBytes, static_cast<size_t>(std::ceil(numBits / 8)));
+        }
+    }
 
+    if (bestNumBits == std::numeric_limits<double>::max())
+    {
+        return;
     }
+
+    getOptimumOfBinarizationParameter(
+            diffTransformedSequence,
+            candidates[bestCandidate].binarizationId,
+            candidates[bestCandidate].binarizationParameter,
+            candidates[bestCandidate].contextSelectionId,
+            maxNumBytes - lut.size() - 4,
+            bestByteStream,
+            lut,
+            bestConfig,
+            currentConfig
+    );
 }
 
 //------------------------------------------------------------------------------
 
-void getOptimumOfLutTransformedStream(const std::vector<uint64_t>& lutTransformedSequence,
+void getOptimumOfLutTransformedStream(const gabac::SymbolStream& lutTransformedSequence,
                                       unsigned wordsize,
+                                      size_t maxNumBytes,
                                       std::vector<uint8_t> *const bestByteStream,
                                       const std::vector<uint8_t>& lut,
                                       TransformedSequenceConfiguration *const bestConfig,
@@ -222,58 +340,154 @@ void getOptimumOfLutTransformedStream(const std::vector<uint64_t>& lutTransforme
     for (const auto& transID : getCandidateConfig().candidateDiffParameters)
     {
         GABACIFY_LOG_DEBUG << "Trying Diff transformation: " << transID;
-        std::vector<int64_t> diffStream;
-
-        doDiffTransform(transID, lutTransformedSequence, &diffStream);
-        GABACIFY_LOG_DEBUG << "Diff stream (uncompressed): " << diffStream.size() << " bytes";
         currentConfig->diffCodingEnabled = transID;
-        getOptimumOfDiffTransformedStream(diffStream, wordsize, bestByteStream, lut, bestConfig, currentConfig);
+        if (!transID)
+        {
+            getOptimumOfDiffTransformedStream(lutTransformedSequence, wordsize, maxNumBytes, bestByteStream, lut,
+                                              bestConfig, currentConfig);
+            continue;
+        }
+
+        std::vector<int64_t> diffStream;
+        doDiffTransform(lutTransformedSequence, &diffStream);
+        GABACIFY_LOG_DEBUG << "Diff stream (uncompressed): " << diffStream.size() << " symbols";
+        getOptimumOfDiffTransformedStream(diffStream, wordsize, maxNumBytes, bestByteStream, lut, bestConfig,
+                                          currentConfig);
     }
 }
 
 //------------------------------------------------------------------------------
 
-void getOptimumOfTransformedStream(const std::vector<uint64_t>& transformedSequence,
-                                   unsigned wordsize,
-                                   std::vector<unsigned char> *const bestByteStream,
-                                   TransformedSequenceConfiguration *const bestConfig
+// Runs job(0), ..., job(numJobs - 1) on up to numThreads threads (0: one per
+// hardware thread). The first exception, in the order of the jobs, is
+// rethrown after all jobs are done.
+void runJobs(size_t numJobs,
+             unsigned numThreads,
+             const std::function<void(size_t)>& job
 ){
-    for (const auto& transID : getCandidateConfig().candidateLUTCodingParameters)
+    if (numThreads == 0)
+    {
+        numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    size_t numWorkers = std::max(std::min(static_cast<size_t>(numThreads), numJobs), static_cast<size_t>(1));
+    std::atomic<size_t> nextJob(0);
+    std::vector<std::exception_ptr> exceptions(numJobs);
+
+    auto work = [&]()
+    {
+        for (size_t i = nextJob++; i < numJobs; i = nextJob++)
+        {
+            try
+            {
+                job(i);
+            }
+            catch (...)
+            {
+                exceptions[i] = std::current_exception();
+            }
+        }
+    };
+
+    // If no more threads can be started, this thread takes the remaining
+    // jobs
+    std::vector<std::thread> threads;
+    threads.reserve(numWorkers - 1);
+    for (size_t worker = 1; worker < numWorkers; worker++)
     {
-        GABACIFY_LOG_DEBUG << "Trying LUT transformation: " << transID;
+        try
+        {
+            threads.emplace_back(work);
+        }
+        catch (const std::system_error&)
+        {
+            break;
+        }
+    }
+    work();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    for (const auto& exception : exceptions)
+    {
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+    }
+}
 
-        std::vector<uint8_t> lutEnc;
-        std::vector<std::vector<uint64_t>> lutStreams;
-        TransformedSequenceConfiguration currentConfiguration;
-        currentConfiguration.lutTransformationParameter = 0;
-        currentConfiguration.lutTransformationEnabled = transID;
+//------------------------------------------------------------------------------
 
-        lutStreams.resize(2);
-        doLutTransform(transID, transformedSequence, wordsize, &lutEnc, &lutStreams);
-        if (lutStreams[0].size() != transformedSequence.size())
+// LUT transformations (enabled, order) in the order in which they are tried
+std::vector<std::pair<bool, unsigned>> getLutVariants(){
+    std::vector<std::pair<bool, unsigned>> variants;
+    for (const auto& transID : getCandidateConfig().candidateLUTCodingParameters)
+    {
+        if (!transID)
         {
-            GABACIFY_LOG_DEBUG << "Lut transformed failed. Probably the symbol space is too large. Skipping. ";
+            variants.emplace_back(false, 0);
             continue;
         }
-        GABACIFY_LOG_DEBUG << "LutTransformedSequence uncompressed size: " << lutStreams[0].size() << " bytes";
-        GABACIFY_LOG_DEBUG << "Lut table (uncompressed): " << lutStreams[1].size() << " bytes";
+        for (const auto& order : getCandidateConfig().candidateLUTOrders)
+        {
+            variants.emplace_back(true, order);
+        }
+    }
+    return variants;
+}
 
-        getOptimumOfLutTransformedStream(
-                lutStreams[0],
-                wordsize,
-                bestByteStream,
-                lutEnc,
-                bestConfig,
-                &currentConfiguration
-        );
+//------------------------------------------------------------------------------
+
+void getOptimumOfLutVariant(const gabac::SymbolStream& transformedSequence,
+                            unsigned wordsize,
+                            bool lutEnabled,
+                            unsigned lutOrder,
+                            size_t maxNumBytes,
+                            std::vector<unsigned char> *const bestByteStream,
+                            TransformedSequenceConfiguration *const bestConfig
+){
+    GABACIFY_LOG_DEBUG << "Trying LUT transformation: " << lutEnabled << " (order " << lutOrder << ")";
+
+    std::vector<uint8_t> lutEnc;
+    std::vector<gabac::SymbolStream> lutStreams;
+    TransformedSequenceConfiguration currentConfiguration;
+    currentConfiguration.lutTransformationParameter = lutOrder;
+    currentConfiguration.lutTransformationEnabled = lutEnabled;
 
+    // Runs in an analysis job, which has a thread of its own already
+    try
+    {
+        doLutTransform(lutEnabled, lutOrder, transformedSequence, wordsize, 1, &lutEnc, &lutStreams);
+    }
+    catch (const RuntimeException&)
+    {
+        GABACIFY_LOG_DEBUG << "Lut transformed failed. Probably the symbol space is too large. Skipping. ";
+        return;
+    }
+    GABACIFY_LOG_DEBUG << "LutTransformedSequence uncompressed size: " << lutStreams[0].size()
+                       << " symbols";
+    if (lutEnabled)
+    {
+        GABACIFY_LOG_DEBUG << "Lut table (uncompressed): " << lutStreams[1].size() << " symbols";
     }
+
+    getOptimumOfLutTransformedStream(
+            lutStreams[0],
+            wordsize,
+            maxNumBytes,
+            bestByteStream,
+            lutEnc,
+            bestConfig,
+            &currentConfiguration
+    );
 }
 
 //------------------------------------------------------------------------------
 
-void getOptimumOfSequenceTransform(const std::vector<uint64_t>& symbols,
+void getOptimumOfSequenceTransform(const gabac::SymbolStream& symbols,
                                    const std::vector<uint32_t>& candidateParameters,
+                                   unsigned numThreads,
                                    std::vector<unsigned char> *const bestByteStream,
                                    Configuration *const bestConfig,
                                    Configuration *const currentConfig
@@ -283,54 +497,88 @@ void getOptimumOfSequenceTransform(const std::vector<uint64_t>& symbols,
         GABACIFY_LOG_DEBUG << "Trying sequence transformation parameter: " << unsigned(p);
 
         // Execute sequence transform
-        std::vector<std::vector<uint64_t>> transformedSequences;
+        std::vector<gabac::SymbolStream> transformedSequences;
         doSequenceTransform(symbols, currentConfig->sequenceTransformationId, p, &transformedSequences);
         GABACIFY_LOG_DEBUG << "Got " << transformedSequences.size() << " transformed sequences";
         for (unsigned i = 0; i < transformedSequences.size(); ++i)
         {
-            GABACIFY_LOG_DEBUG << i << ": " << transformedSequences[i].size() << " bytes";
+            GABACIFY_LOG_DEBUG << i << ": " << transformedSequences[i].size() << " symbols";
         }
 
 
         currentConfig->sequenceTransformationParameter = p;
         currentConfig->transformedSequenceConfigurations.resize(transformedSequences.size());
+        std::vector<unsigned> wordSizes = gabac::fixWordSizes(
+                gabac::transformationInformation[unsigned(currentConfig->sequenceTransformationId)].wordsizes,
+                currentConfig->wordSize
+        );
+
+        // Each LUT variant of each transformed sequence is analyzed on its
+        // own, so that the results do not depend on the number of threads,
+        // and the best variants are picked in the order of the serial search
+        const std::vector<std::pair<bool, unsigned>> lutVariants = getLutVariants();
+
+        // A transformed sequence which alone is not smaller than the best
+        // stream so far cannot be part of a better one
+        size_t maxNumBytes = bestByteStream->empty()
+                             ? std::numeric_limits<size_t>::max()
+                             : bestByteStream->size() - 1;
+
+        size_t numJobs = transformedSequences.size() * lutVariants.size();
+        std::vector<std::vector<unsigned char>> jobByteStreams(numJobs);
+        std::vector<TransformedSequenceConfiguration> jobConfigs(numJobs);
+        runJobs(numJobs, numThreads, [&](size_t job)
+        {
+            size_t i = job / lutVariants.size();
+            const auto& variant = lutVariants[job % lutVariants.size()];
+            getOptimumOfLutVariant(
+                    transformedSequences[i],
+                    wordSizes[i],
+                    variant.first,
+                    variant.second,
+                    maxNumBytes,
+                    &jobByteStreams[job],
+                    &jobConfigs[job]
+            );
+        });
 
         // Analyze transformed sequences
         std::vector<unsigned char> completeStream;
         bool error = false;
         for (unsigned i = 0; i < transformedSequences.size(); ++i)
         {
-            unsigned currWordSize = gabac::fixWordSizes(
-                    gabac::transformationInformation[unsigned(currentConfig->sequenceTransformationId)].wordsizes,
-                    currentConfig->wordSize
-            )[i];
-            GABACIFY_LOG_DEBUG << "Analyzing sequence: "
+            GABACIFY_LOG_DEBUG << "Analyzed sequence: "
                                << gabac::transformationInformation[unsigned(currentConfig->sequenceTransformationId)].streamNames[i]
                                << "";
-            std::vector<unsigned char> bestTransformedStream;
-            getOptimumOfTransformedStream(
-                    transformedSequences[i],
-                    currWordSize,
-                    &bestTransformedStream,
-                    &(*currentConfig).transformedSequenceConfigurations[i]
-            );
+            std::vector<unsigned char> *bestTransformedStream = nullptr;
+            for (size_t job = i * lutVariants.size(); job < (i + 1) * lutVariants.size(); ++job)
+            {
+                if (jobByteStreams[job].empty())
+                {
+                    continue;
+                }
+                if (bestTransformedStream == nullptr || jobByteStreams[job].size() < bestTransformedStream->size())
+                {
+                    bestTransformedStream = &jobByteStreams[job];
+                    currentConfig->transformedSequenceConfigurations[i] = jobConfigs[job];
+                }
+            }
 
-            if (bestTransformedStream.empty())
+            if (bestTransformedStream == nullptr)
             {
                 error = true;
                 break;
             }
 
-            GABACIFY_LOG_TRACE << "Transformed and compressed sequence size: " << bestTransformedStream.size();
+            GABACIFY_LOG_TRACE << "Transformed and compressed sequence size: " << bestTransformedStream->size();
 
-            //appendToBytestream(bestTransformedStream, &completeStream);
-            completeStream.insert(completeStream.end(), bestTransformedStream.begin(), bestTransformedStream.end());
+            completeStream.insert(completeStream.end(), bestTransformedStream->begin(), bestTransformedStream->end());
 
             if ((completeStream.size() >= bestByteStream->size()) &&
                 (!bestByteStream->empty()))
             {
                 GABACIFY_LOG_TRACE << "Already bigger stream than current maximum (Sequence transform level): Skipping "
-                                   << bestTransformedStream.size();
+                                   << bestTransformedStream->size();
                 error = true;
                 break;
             }
@@ -359,7 +607,8 @@ void getOptimumOfSequenceTransform(const std::vector<uint64_t>& symbols,
 
 //------------------------------------------------------------------------------
 
-void getOptimumOfSymbolSequence(const std::vector<uint64_t>& symbols,
+void getOptimumOfSymbolSequence(const gabac::SymbolStream& symbols,
+                                unsigned numThreads,
                                 std::vector<uint8_t> *const bestByteStream,
                                 Configuration *const bestConfig,
                                 Configuration *const currentConfiguration
@@ -379,6 +628,7 @@ void getOptimumOfSymbolSequence(const std::vector<uint64_t>& symbols,
         getOptimumOfSequenceTransform(
                 symbols,
                 *(params[unsigned(transID)]),
+                numThreads,
                 bestByteStream,
                 bestConfig,
                 currentConfiguration
@@ -392,7 +642,8 @@ void getOptimumOfSymbolSequence(const std::vector<uint64_t>& symbols,
 
 void encode_analyze(const std::string& inputFilePath,
                     const std::string& configurationFilePath,
-                    const std::string& outputFilePath
+                    const std::string& outputFilePath,
+                    unsigned numThreads
 ){
     Configuration bestConfig;
     std::vector<unsigned char> bestByteStream;
@@ -419,13 +670,13 @@ void encode_analyze(const std::string& inputFilePath,
         currentConfig.wordSize = w;
 
         // Generate symbol stream from byte buffer
-        std::vector<uint64_t> symbols;
+        gabac::SymbolStream symbols;
         generateSymbolStream(buffer, w, &symbols);
         buffer.clear();
         buffer.shrink_to_fit();
 
 
-        getOptimumOfSymbolSequence(symbols, &bestByteStream, &bestConfig, &currentConfig);
+        getOptimumOfSymbolSequence(symbols, numThreads, &bestByteStream, &bestConfig, &currentConfig);
 
         if (bestByteStream.empty())
         {
@@ -9,9 +9,12 @@
 
 namespace gabacify {
 
+// The candidates are analyzed by numThreads threads (0: one per hardware
+// thread); the result does not depend on the number of threads
 void encode_analyze(const std::string& inputFilePath,
                     const std::string& configurationFilePath,
-                    const std::string& outputFilePath
+                    const std::string& outputFilePath,
+                    unsigned numThreads
 );
 }
 
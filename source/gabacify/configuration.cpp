@@ -52,6 +52,13 @@ Configuration::Configuration(
                 = static_cast<bool>(child.second.get<unsigned int>("lut_transformation_enabled"));
             transformedSequenceConfiguration.lutTransformationParameter
                 = child.second.get<unsigned int>("lut_transformation_parameter");
+            if (transformedSequenceConfiguration.lutTransformationParameter > 2)
+            {
+                GABACIFY_DIE(
+                        "Invalid LUT order: "
+                        + std::to_string(transformedSequenceConfiguration.lutTransformationParameter)
+                );
+            }
             transformedSequenceConfiguration.diffCodingEnabled
                 = child.second.get<bool>("diff_coding_enabled");
             transformedSequenceConfiguration.binarizationId
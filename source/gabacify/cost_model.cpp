@@ -0,0 +1,423 @@
+#include "gabacify/cost_model.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+#include "gabac/context_selector.h"
+#include "gabac/context_tables.h"
+
+
+namespace gabacify {
+
+
+// Context sets of the order-2 context selection
+static const unsigned int NUM_CONTEXT_SETS = 16;
+
+// Longest EG prefix
+static const unsigned int MAX_EG_PREFIX_LENGTH = 64;
+
+// Probability of the less probable bin value in the most skewed state of a
+// context model
+static const double MIN_PROBABILITY = 0.01875;
+
+// Binarizations with their own context sets, see ContextSelector
+enum BinTable
+{
+    TU_TABLE = 0,
+    EG_TABLE = 1,
+    BI_TABLE = 2,
+    NUM_TABLES = 3
+};
+
+
+static unsigned int bitLength(
+        uint64_t value
+){
+    unsigned int length = 0;
+    while (value != 0)
+    {
+        value >>= 1u;
+        length++;
+    }
+    return length;
+}
+
+
+//------------------------------------------------------------------------------
+
+template<typename T>
+void CostModel::countSymbols(
+        const T *const symbols,
+        const size_t symbolsSize
+){
+    // The table of small symbols only spans the range which occurs
+    int64_t smallMin = SMALL_SYMBOL_LIMIT - 1;
+    int64_t smallMax = -SMALL_SYMBOL_LIMIT + 1;
+    for (size_t i = 0; i < symbolsSize; i++)
+    {
+        auto symbol = static_cast<int64_t>(symbols[i]);
+        smallMin = std::min(smallMin, std::max(symbol, -SMALL_SYMBOL_LIMIT + 1));
+        smallMax = std::max(smallMax, std::min(symbol, SMALL_SYMBOL_LIMIT - 1));
+    }
+    const size_t SMALL_SYMBOLS_SIZE = (smallMin <= smallMax) ? static_cast<size_t>(smallMax - smallMin + 1) : 0;
+    const size_t MAX_BIT_LENGTH = 64;
+    std::vector<uint64_t> smallCounts(NUM_CONTEXT_SETS * SMALL_SYMBOLS_SIZE, 0);
+    std::vector<std::unordered_map<int64_t, uint64_t>> largeCounts(NUM_CONTEXT_SETS);
+    size_t numLargeSymbols = 0;
+    std::vector<uint64_t> approximateCounts(NUM_CONTEXT_SETS * 2 * (MAX_BIT_LENGTH + 1), 0);
+
+    unsigned int previousSymbol = 0;
+    unsigned int previousPreviousSymbol = 0;
+    for (size_t i = 0; i < symbolsSize; i++)
+    {
+        auto symbol = static_cast<int64_t>(symbols[i]);
+        unsigned int contextSet = (previousSymbol << 2u) + previousPreviousSymbol;
+        previousPreviousSymbol = previousSymbol;
+        previousSymbol = gabac::ContextSelector::getContextHistoryValue(symbol);
+
+        if (symbol > -SMALL_SYMBOL_LIMIT && symbol < SMALL_SYMBOL_LIMIT)
+        {
+            smallCounts[contextSet * SMALL_SYMBOLS_SIZE + static_cast<size_t>(symbol - smallMin)]++;
+            continue;
+        }
+        auto& counts = largeCounts[contextSet];
+        auto entry = counts.find(symbol);
+        if (entry != counts.end())
+        {
+            entry->second++;
+            continue;
+        }
+        if (numLargeSymbols < MAX_LARGE_SYMBOLS)
+        {
+            counts.emplace(symbol, 1);
+            numLargeSymbols++;
+            continue;
+        }
+        uint64_t magnitude = (symbol < 0) ? (0 - static_cast<uint64_t>(symbol)) : static_cast<uint64_t>(symbol);
+        size_t sign = (symbol < 0) ? 1 : 0;
+        approximateCounts[(contextSet * 2 + sign) * (MAX_BIT_LENGTH + 1) + bitLength(magnitude)]++;
+    }
+
+    for (unsigned int contextSet = 0; contextSet < NUM_CONTEXT_SETS; contextSet++)
+    {
+        for (size_t i = 0; i < SMALL_SYMBOLS_SIZE; i++)
+        {
+            uint64_t count = smallCounts[contextSet * SMALL_SYMBOLS_SIZE + i];
+            if (count != 0)
+            {
+                m_entries.push_back({contextSet, static_cast<int64_t>(i) + smallMin, false, count});
+            }
+        }
+        for (const auto& entry : largeCounts[contextSet])
+        {
+            m_entries.push_back({contextSet, entry.first, false, entry.second});
+        }
+        for (size_t sign = 0; sign < 2; sign++)
+        {
+            for (size_t length = 1; length <= MAX_BIT_LENGTH; length++)
+            {
+                uint64_t count = approximateCounts[(contextSet * 2 + sign) * (MAX_BIT_LENGTH + 1) + length];
+                if (count == 0)
+                {
+                    continue;
+                }
+                uint64_t magnitude = uint64_t(1) << (length - 1);
+                auto value = static_cast<int64_t>(sign ? (0 - magnitude) : magnitude);
+                m_entries.push_back({contextSet, value, true, count});
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+CostModel::CostModel(
+        const std::vector<int64_t>& symbols
+){
+    countSymbols(symbols.data(), symbols.size());
+}
+
+//------------------------------------------------------------------------------
+
+CostModel::CostModel(
+        const gabac::SymbolStream& symbols
+){
+    switch (symbols.getWordSize())
+    {
+        case 1:
+            countSymbols(symbols.get<uint8_t>().data(), symbols.size());
+            break;
+        case 2:
+            countSymbols(symbols.get<uint16_t>().data(), symbols.size());
+            break;
+        case 4:
+            countSymbols(symbols.get<uint32_t>().data(), symbols.size());
+            break;
+        default:
+            countSymbols(symbols.get<uint64_t>().data(), symbols.size());
+            break;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+namespace {
+
+// Bins of all symbols, by context. The contexts are laid out as in the
+// encoder, so that long TU or EG prefixes run into the contexts of the
+// following context sets as they do there.
+class BinCounter
+{
+ public:
+    // Runs are at most maxRunLength bins long
+    explicit BinCounter(
+            unsigned int maxRunLength
+    )
+            : m_zeros(NUM_CONTEXTS, 0.0),
+            m_ones(NUM_CONTEXTS, 0.0),
+            m_maxRunLength(maxRunLength),
+            m_runs(NUM_CONTEXT_SETS * NUM_TABLES * (maxRunLength + 1), 0.0),
+            m_bypassBins(0.0){
+    }
+
+    void addBin(
+            unsigned int contextSet,
+            BinTable table,
+            unsigned int bin,
+            unsigned int value,
+            double count
+    ){
+        size_t context = index(contextSet, table, bin);
+        (value ? m_ones : m_zeros)[context] += count;
+    }
+
+    // length bins of the value of the table (1 for TU, 0 for EG) from bin 0 on
+    void addRun(
+            unsigned int contextSet,
+            BinTable table,
+            unsigned int length,
+            double count
+    ){
+        length = std::min(length, m_maxRunLength);
+        m_runs[(contextSet * NUM_TABLES + table) * (m_maxRunLength + 1) + length] += count;
+    }
+
+    void addBypassBins(
+            double count
+    ){
+        m_bypassBins += count;
+    }
+
+    // Size of the bins in bits, either context-coded or bypass-coded
+    double estimateBits(
+            bool isBypass
+    ){
+        // Resolve the runs: a run covers all bins below its length
+        for (unsigned int contextSet = 0; contextSet < NUM_CONTEXT_SETS; contextSet++)
+        {
+            for (unsigned int table = 0; table < NUM_TABLES; table++)
+            {
+                std::vector<double>& runValues = (table == TU_TABLE) ? m_ones : m_zeros;
+                double longerRuns = 0.0;
+                for (unsigned int length = m_maxRunLength; length > 0; length--)
+                {
+                    longerRuns += m_runs[(contextSet * NUM_TABLES + table) * (m_maxRunLength + 1) + length];
+                    if (longerRuns != 0.0)
+                    {
+                        runValues[index(contextSet, static_cast<BinTable>(table), length - 1)] += longerRuns;
+                    }
+                }
+            }
+        }
+
+        double bits = m_bypassBins;
+        for (size_t context = 0; context < m_zeros.size(); context++)
+        {
+            double zeros = m_zeros[context];
+            double ones = m_ones[context];
+            double total = zeros + ones;
+            if (total == 0.0)
+            {
+                continue;
+            }
+            if (isBypass)
+            {
+                bits += total;
+                continue;
+            }
+            // The coder cannot go below the probability of its most
+            // skewed state
+            double probabilityOfZero = std::min(std::max(zeros / total, MIN_PROBABILITY), 1.0 - MIN_PROBABILITY);
+            bits -= zeros * std::log2(probabilityOfZero);
+            bits -= ones * std::log2(1.0 - probabilityOfZero);
+            // The probability of an adaptive context has to be learned
+            bits += 0.5 * std::log2(total + 1.0);
+        }
+        return bits;
+    }
+
+ private:
+    static size_t index(
+            unsigned int contextSet,
+            BinTable table,
+            unsigned int bin
+    ){
+        const unsigned int OFFSETS[NUM_TABLES] = {
+                gabac::contexttables::OFFSET_TRUNCATED_UNARY_0,
+                gabac::contexttables::OFFSET_EXPONENTIAL_GOLOMB_0,
+                gabac::contexttables::OFFSET_BINARY_0
+        };
+        size_t context = OFFSETS[table] + contextSet * gabac::contexttables::CONTEXT_SET_LENGTH + bin;
+        return std::min(context, NUM_CONTEXTS - 1);
+    }
+
+    static const size_t NUM_CONTEXTS = gabac::contexttables::NUM_CONTEXTS;
+
+    std::vector<double> m_zeros;
+
+    std::vector<double> m_ones;
+
+    unsigned int m_maxRunLength;
+
+    std::vector<double> m_runs;
+
+    double m_bypassBins;
+};
+
+
+void addBI(
+        uint64_t value,
+        unsigned int length,
+        bool isApproximate,
+        unsigned int contextSet,
+        double count,
+        BinCounter *const bins
+){
+    // The bits below the leading one of an approximate value are random
+    unsigned int randomBits = isApproximate ? (bitLength(value) - 1) : 0;
+    for (unsigned int i = 0; i < length; i++)
+    {
+        unsigned int position = length - i - 1;
+        if (position < randomBits)
+        {
+            bins->addBin(contextSet, BI_TABLE, i, 0, count / 2);
+            bins->addBin(contextSet, BI_TABLE, i, 1, count / 2);
+            continue;
+        }
+        unsigned int bit = (position < 64) ? static_cast<unsigned int>((value >> position) & 1u) : 0;
+        bins->addBin(contextSet, BI_TABLE, i, bit, count);
+    }
+}
+
+
+void addTU(
+        uint64_t value,
+        unsigned int cMax,
+        unsigned int contextSet,
+        double count,
+        BinCounter *const bins
+){
+    auto length = static_cast<unsigned int>(std::min(value, uint64_t(cMax)));
+    bins->addRun(contextSet, TU_TABLE, length, count);
+    if (value != cMax)
+    {
+        bins->addBin(contextSet, TU_TABLE, length, 0, count);
+    }
+}
+
+
+void addEG(
+        uint64_t value,
+        unsigned int contextSet,
+        double count,
+        BinCounter *const bins
+){
+    unsigned int length = bitLength(value + 1);
+    bins->addRun(contextSet, EG_TABLE, length - 1, count);
+    bins->addBin(contextSet, EG_TABLE, length - 1, 1, count);
+    bins->addBypassBins(count * (length - 1));
+}
+
+
+void addTEG(
+        uint64_t value,
+        unsigned int parameter,
+        unsigned int contextSet,
+        double count,
+        BinCounter *const bins
+){
+    if (value < parameter)
+    {
+        addTU(value, parameter, contextSet, count, bins);
+        return;
+    }
+    addTU(parameter, parameter, contextSet, count, bins);
+    addEG(value - parameter, contextSet, count, bins);
+}
+
+}  // namespace
+
+//------------------------------------------------------------------------------
+
+double CostModel::estimateSize(
+        const gabac::BinarizationId& binarizationId,
+        unsigned int binarizationParameter,
+        const gabac::ContextSelectionId& contextSelectionId
+) const {
+    BinCounter bins(std::max(binarizationParameter, MAX_EG_PREFIX_LENGTH));
+    for (const auto& entry : m_entries)
+    {
+        unsigned int contextSet = 0;
+        if (contextSelectionId == gabac::ContextSelectionId::adaptive_coding_order_1)
+        {
+            contextSet = entry.contextSet & ~3u;
+        }
+        else if (contextSelectionId == gabac::ContextSelectionId::adaptive_coding_order_2)
+        {
+            contextSet = entry.contextSet;
+        }
+
+        int64_t value = entry.value;
+        uint64_t magnitude = (value < 0) ? (0 - static_cast<uint64_t>(value)) : static_cast<uint64_t>(value);
+        auto count = static_cast<double>(entry.count);
+        switch (binarizationId)
+        {
+            case gabac::BinarizationId::BI:
+                addBI(static_cast<uint64_t>(value), binarizationParameter, entry.isApproximate, contextSet, count,
+                      &bins);
+                break;
+            case gabac::BinarizationId::TU:
+                addTU(static_cast<uint64_t>(value), binarizationParameter, contextSet, count, &bins);
+                break;
+            case gabac::BinarizationId::EG:
+                addEG(static_cast<uint64_t>(value), contextSet, count, &bins);
+                break;
+            case gabac::BinarizationId::SEG:
+                addEG((value <= 0) ? (magnitude << 1u) : ((magnitude << 1u) - 1), contextSet, count, &bins);
+                break;
+            case gabac::BinarizationId::TEG:
+                addTEG(static_cast<uint64_t>(value), binarizationParameter, contextSet, count, &bins);
+                break;
+            case gabac::BinarizationId::STEG:
+                addTEG(magnitude, binarizationParameter, contextSet, count, &bins);
+                if (value != 0)
+                {
+                    bins.addBin(contextSet, BI_TABLE, 0, (value < 0) ? 1 : 0, count);
+                }
+                break;
+        }
+    }
+
+    bool isBypass = (contextSelectionId == gabac::ContextSelectionId::bypass ||
+                     contextSelectionId == gabac::ContextSelectionId::raw);
+
+    // 32-bit symbol count and the flush of the arithmetic coder
+    const double OVERHEAD = 4 + 2;
+    return bins.estimateBits(isBypass) / 8 + OVERHEAD;
+}
+
+
+}  // namespace gabacify
@@ -0,0 +1,71 @@
+#ifndef GABACIFY_COST_MODEL_H_
+#define GABACIFY_COST_MODEL_H_
+
+
+#include <cstdint>
+#include <vector>
+
+#include "gabac/constants.h"
+#include "gabac/symbol_stream.h"
+
+
+namespace gabacify {
+
+
+// Estimates the size of gabac::encode() output for any binarization and
+// adaptive context selection from the statistics of a stream, without
+// encoding it. The symbols are counted once per context set of the order-2
+// context selection, from which the coarser context selections follow.
+// Each context-coded bin is then charged with the empirical entropy of its
+// context, plus a small learning cost per context, and each bypass bin with
+// one bit.
+class CostModel
+{
+ public:
+    explicit CostModel(
+            const std::vector<int64_t>& symbols
+    );
+
+    explicit CostModel(
+            const gabac::SymbolStream& symbols
+    );
+
+    // Estimated bitstream size in bytes
+    double estimateSize(
+            const gabac::BinarizationId& binarizationId,
+            unsigned int binarizationParameter,
+            const gabac::ContextSelectionId& contextSelectionId
+    ) const;
+
+ private:
+    template<typename T>
+    void countSymbols(
+            const T *symbols,
+            size_t symbolsSize
+    );
+
+    // Symbols of a smaller magnitude are counted in a table, the others in
+    // a hash table of up to MAX_LARGE_SYMBOLS entries, and beyond that only
+    // by sign and bit length
+    static const int64_t SMALL_SYMBOL_LIMIT = 4096;
+
+    static const size_t MAX_LARGE_SYMBOLS = 1u << 16u;
+
+    struct Entry
+    {
+        unsigned int contextSet;
+        int64_t value;
+        // Only the bit length of value is known, its lower bits are taken
+        // as random
+        bool isApproximate;
+        uint64_t count;
+    };
+
+    std::vector<Entry> m_entries;
+};
+
+
+}  // namespace gabacify
+
+
+#endif  // GABACIFY_COST_MODEL_H_
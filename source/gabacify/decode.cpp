@@ -1,11 +1,13 @@
 #include "gabacify/decode.h"
 
 #include <cassert>
+#include <utility>
 #include <vector>
 
 #include "gabac/constants.h"
 #include "gabac/diff_coding.h"
 #include "gabac/decoding.h"
+#include "gabac/lut_transform.h"
 
 #include "gabacify/configuration.h"
 #include "gabacify/exceptions.h"
@@ -20,17 +22,22 @@ namespace gabacify {
 
 //------------------------------------------------------------------------------
 
+// Locates the next chunk in the bytestream; the chunk is not copied but
+// referenced in place via *chunk/*chunkSize
 static size_t extractFromBytestream(
         const std::vector<unsigned char>& bytestream,
         size_t bytestreamPosition,
-        std::vector<unsigned char> *const bytes
+        const unsigned char **const chunk,
+        size_t *const chunkSize
 ){
-    assert(bytes != nullptr);
-
-    // Set up our output 'bytes'
-    bytes->clear();
+    assert(chunk != nullptr);
+    assert(chunkSize != nullptr);
 
     // Get the size of the next chunk
+    if (bytestreamPosition + sizeof(uint32_t) > bytestream.size())
+    {
+        GABACIFY_DIE("Bytestream is truncated");
+    }
     std::vector<unsigned char> sizeBuffer;
     sizeBuffer.insert(
             sizeBuffer.end(),
@@ -40,75 +47,147 @@ static size_t extractFromBytestream(
     bytestreamPosition += sizeof(uint32_t);
     std::vector<uint64_t> chunkSizeVector;
     generateSymbolStream({sizeBuffer}, 4, &chunkSizeVector);
-    uint64_t chunkSize = chunkSizeVector.front();
+    *chunkSize = chunkSizeVector.front();
 
-    // Get the next 'chunkSize' bytes from the bytestream
-    for (size_t i = 0; i < chunkSize; i++)
+    // The next 'chunkSize' bytes from the bytestream form the chunk
+    if (*chunkSize > bytestream.size() - bytestreamPosition)
     {
-        bytes->push_back(bytestream.at(bytestreamPosition++));
+        GABACIFY_DIE("Bytestream is truncated");
     }
+    *chunk = bytestream.data() + bytestreamPosition;
 
-    return bytestreamPosition;
+    return bytestreamPosition + *chunkSize;
 }
 
 //------------------------------------------------------------------------------
 
 static void decodeInverseLUT(const std::vector<unsigned char>& bytestream,
                              unsigned wordSize,
+                             unsigned order,
                              size_t *const bytestreamPosition,
-                             std::vector<uint64_t> *const inverseLut
+                             gabac::SymbolStream *const inverseLut,
+                             gabac::SymbolStream *const inverseLutHigherOrder,
+                             gabac::SymbolStream *const escapedSymbols
 ){
     // Decode the inverse LUT
-    std::vector<unsigned char> inverseLutBitstream;
-    *bytestreamPosition = extractFromBytestream(bytestream, *bytestreamPosition, &inverseLutBitstream);
-    GABACIFY_LOG_TRACE << "Read LUT bitstream with size: " << inverseLutBitstream.size();
-    std::vector<int64_t> inverseLutTmp;
+    const unsigned char *inverseLutBitstream = nullptr;
+    size_t inverseLutBitstreamSize = 0;
+    *bytestreamPosition = extractFromBytestream(
+            bytestream,
+            *bytestreamPosition,
+            &inverseLutBitstream,
+            &inverseLutBitstreamSize
+    );
+    GABACIFY_LOG_TRACE << "Read LUT bitstream with size: " << inverseLutBitstreamSize;
+    std::vector<uint64_t> inverseLutGaps;
     gabac::decode(
             inverseLutBitstream,
-            gabac::BinarizationId::BI,
-            {wordSize * 8},
-            gabac::ContextSelectionId::bypass,
-            &inverseLutTmp
+            inverseLutBitstreamSize,
+            gabac::BinarizationId::EG,
+            {},
+            gabac::ContextSelectionId::adaptive_coding_order_0,
+            &inverseLutGaps
     );
 
-    inverseLut->reserve(inverseLutTmp.size());
+    std::vector<uint64_t> inverseLutPermutation;
+    size_t lutSize = inverseLutSize(inverseLutGaps);
+    if (lutSize > 1)
+    {
+        *bytestreamPosition = extractFromBytestream(
+                bytestream,
+                *bytestreamPosition,
+                &inverseLutBitstream,
+                &inverseLutBitstreamSize
+        );
+        GABACIFY_LOG_TRACE << "Read LUT permutation bitstream with size: " << inverseLutBitstreamSize;
+        gabac::decode(
+                inverseLutBitstream,
+                inverseLutBitstreamSize,
+                gabac::BinarizationId::BI,
+                {inverseLutPermutationBits(lutSize)},
+                gabac::ContextSelectionId::adaptive_coding_order_0,
+                &inverseLutPermutation
+        );
+    }
+    *inverseLut = gabac::SymbolStream(wordSize);
+    mergeInverseLut(inverseLutGaps, inverseLutPermutation, inverseLut);
+
+    if (order > 0)
+    {
+        *bytestreamPosition = extractFromBytestream(
+                bytestream,
+                *bytestreamPosition,
+                &inverseLutBitstream,
+                &inverseLutBitstreamSize
+        );
+        GABACIFY_LOG_TRACE << "Read higher-order LUT bitstream with size: " << inverseLutBitstreamSize;
+        *inverseLutHigherOrder = gabac::SymbolStream(4);
+        gabac::decode(
+                inverseLutBitstream,
+                inverseLutBitstreamSize,
+                gabac::BinarizationId::EG,
+                {},
+                gabac::ContextSelectionId::adaptive_coding_order_0,
+                inverseLutHigherOrder
+        );
+    }
 
-    for (const auto& inverseLutTmpEntry : inverseLutTmp)
+    if (inverseLut->size() == gabac::PARTIAL_LUT_SIZE)
     {
-        assert(inverseLutTmpEntry >= 0);
-        inverseLut->push_back(static_cast<uint64_t>(inverseLutTmpEntry));
+        *bytestreamPosition = extractFromBytestream(
+                bytestream,
+                *bytestreamPosition,
+                &inverseLutBitstream,
+                &inverseLutBitstreamSize
+        );
+        GABACIFY_LOG_TRACE << "Read escaped symbols bitstream with size: " << inverseLutBitstreamSize;
+        std::vector<uint64_t> escapedSymbolDigits;
+        gabac::decode(
+                inverseLutBitstream,
+                inverseLutBitstreamSize,
+                gabac::BinarizationId::BI,
+                {escapedSymbolDigitBits(wordSize)},
+                gabac::ContextSelectionId::raw,
+                &escapedSymbolDigits
+        );
+        *escapedSymbols = gabac::SymbolStream(wordSize);
+        mergeEscapedSymbols(escapedSymbolDigits, escapedSymbols);
     }
 }
 
 //------------------------------------------------------------------------------
 
 static void doDiffCoding(const std::vector<int64_t>& diffAndLutTransformedSequence,
-                         bool enabled,
-                         std::vector<uint64_t> *const lutTransformedSequence
+                         gabac::SymbolStream *const lutTransformedSequence
 ){
-    // Diff coding
-    if (enabled)
-    {
-        GABACIFY_LOG_TRACE << "Diff coding *en*abled";
-        gabac::inverseTransformDiffCoding(diffAndLutTransformedSequence, lutTransformedSequence);
-        return;
-    }
-
-
-    GABACIFY_LOG_TRACE << "Diff coding *dis*abled";
-    lutTransformedSequence->reserve(diffAndLutTransformedSequence.size());
-    for (const auto& diffAndLutTransformedSymbol : diffAndLutTransformedSequence)
+    GABACIFY_LOG_TRACE << "Diff coding *en*abled";
+    switch (lutTransformedSequence->getWordSize())
     {
-        assert(diffAndLutTransformedSymbol >= 0);
-        lutTransformedSequence->push_back(static_cast<uint64_t>(diffAndLutTransformedSymbol));
+        case 1:
+            gabac::inverseTransformDiffCoding(diffAndLutTransformedSequence,
+                                              &lutTransformedSequence->get<uint8_t>());
+            break;
+        case 2:
+            gabac::inverseTransformDiffCoding(diffAndLutTransformedSequence,
+                                              &lutTransformedSequence->get<uint16_t>());
+            break;
+        case 4:
+            gabac::inverseTransformDiffCoding(diffAndLutTransformedSequence,
+                                              &lutTransformedSequence->get<uint32_t>());
+            break;
+        default:
+            gabac::inverseTransformDiffCoding(diffAndLutTransformedSequence,
+                                              &lutTransformedSequence->get<uint64_t>());
+            break;
     }
 }
 
 //------------------------------------------------------------------------------
 
-static void doLUTCoding(const std::vector<std::vector<uint64_t>>& lutSequences,
+static void doLUTCoding(std::vector<gabac::SymbolStream> *const lutSequences,
                         bool enabled,
-                        std::vector<uint64_t> *const transformedSequence
+                        unsigned order,
+                        gabac::SymbolStream *const transformedSequence
 ){
     if (enabled)
     {
@@ -116,12 +195,12 @@ static void doLUTCoding(const std::vector<std::vector<uint64_t>>& lutSequences,
 
         // Do the inverse LUT transform
         const unsigned LUT_INDEX = 4;
-        gabac::transformationInformation[LUT_INDEX].inverseTransform(lutSequences, 0, transformedSequence);
+        gabac::transformationInformation[LUT_INDEX].inverseTransform(*lutSequences, order, transformedSequence);
         return;
     }
 
     GABACIFY_LOG_TRACE << "LUT transform *dis*abled";
-    *transformedSequence = lutSequences[0]; // TODO: std::move() (currently not possible because of const)
+    *transformedSequence = std::move((*lutSequences)[0]);
 }
 
 //------------------------------------------------------------------------------
@@ -129,22 +208,41 @@ static void doLUTCoding(const std::vector<std::vector<uint64_t>>& lutSequences,
 static void doEntropyCoding(const std::vector<unsigned char>& bytestream,
                             const TransformedSequenceConfiguration& transformedSequenceConfiguration,
                             size_t *const bytestreamPosition,
-                            std::vector<int64_t> *const diffAndLutTransformedSequence
+                            gabac::SymbolStream *const lutTransformedSequence
 ){
     // Extract encoded diff-and-LUT-transformed sequence (i.e. a
     // bitstream) from the bytestream
-    std::vector<unsigned char> bitstream;
-    *bytestreamPosition = extractFromBytestream(bytestream, *bytestreamPosition, &bitstream);
-    GABACIFY_LOG_TRACE << "Bitstream size: " << bitstream.size();
+    const unsigned char *bitstream = nullptr;
+    size_t bitstreamSize = 0;
+    *bytestreamPosition = extractFromBytestream(bytestream, *bytestreamPosition, &bitstream, &bitstreamSize);
+    GABACIFY_LOG_TRACE << "Bitstream size: " << bitstreamSize;
+
+    // Decoding; without diff coding the symbols are decoded to their own
+    // width right away
+    if (!transformedSequenceConfiguration.diffCodingEnabled)
+    {
+        GABACIFY_LOG_TRACE << "Diff coding *dis*abled";
+        gabac::decode(
+                bitstream,
+                bitstreamSize,
+                transformedSequenceConfiguration.binarizationId,
+                transformedSequenceConfiguration.binarizationParameters,
+                transformedSequenceConfiguration.contextSelectionId,
+                lutTransformedSequence
+        );
+        return;
+    }
 
-    // Decoding
+    std::vector<int64_t> diffAndLutTransformedSequence;
     gabac::decode(
             bitstream,
+            bitstreamSize,
             transformedSequenceConfiguration.binarizationId,
             transformedSequenceConfiguration.binarizationParameters,
             transformedSequenceConfiguration.contextSelectionId,
-            diffAndLutTransformedSequence
+            &diffAndLutTransformedSequence
     );
+    doDiffCoding(diffAndLutTransformedSequence, lutTransformedSequence);
 }
 
 //------------------------------------------------------------------------------
@@ -152,18 +250,18 @@ static void doEntropyCoding(const std::vector<unsigned char>& bytestream,
 static void decodeWithConfiguration(
         std::vector<unsigned char>* bytestream,
         const Configuration& configuration,
-        std::vector<uint64_t> *const sequence
+        gabac::SymbolStream *const sequence
 ){
     assert(sequence != nullptr);
 
-    sequence->clear();
+    *sequence = gabac::SymbolStream(configuration.wordSize);
 
     // Set up for the inverse sequence transformation
     size_t numTransformedSequences =
             gabac::transformationInformation[unsigned(configuration.sequenceTransformationId)].wordsizes.size();
 
     // Loop through the transformed sequences
-    std::vector<std::vector<uint64_t>> transformedSequences;
+    std::vector<gabac::SymbolStream> transformedSequences;
     size_t bytestreamPosition = 0;
     for (size_t i = 0; i < numTransformedSequences; i++)
     {
@@ -176,36 +274,29 @@ static void decodeWithConfiguration(
                         configuration.wordSize
                 )[i];
 
-        std::vector<uint64_t> inverseLut;
+        std::vector<gabac::SymbolStream> lutTransformedSequences(2, gabac::SymbolStream(wordSize));
+        lutTransformedSequences.emplace_back(4);
+        lutTransformedSequences.emplace_back(wordSize);
         if (transformedSequenceConfiguration.lutTransformationEnabled)
         {
-            decodeInverseLUT(*bytestream, wordSize, &bytestreamPosition, &inverseLut);
+            decodeInverseLUT(*bytestream, wordSize, transformedSequenceConfiguration.lutTransformationParameter,
+                             &bytestreamPosition, &lutTransformedSequences[1], &lutTransformedSequences[2],
+                             &lutTransformedSequences[3]);
         }
 
-        std::vector<int64_t> diffAndLutTransformedSequence;
         doEntropyCoding(
                 *bytestream,
                 configuration.transformedSequenceConfigurations[i],
                 &bytestreamPosition,
-                &diffAndLutTransformedSequence
+                &lutTransformedSequences[0]
         );
 
-        std::vector<std::vector<uint64_t>> lutTransformedSequences(2);
-        doDiffCoding(
-                diffAndLutTransformedSequence,
-                configuration.transformedSequenceConfigurations[i].diffCodingEnabled,
-                &(lutTransformedSequences[0])
-        );
-        diffAndLutTransformedSequence.clear();
-        diffAndLutTransformedSequence.shrink_to_fit();
-
-        lutTransformedSequences[1] = std::move(inverseLut);
-
         // LUT transform
-        std::vector<uint64_t> transformedSequence;
+        gabac::SymbolStream transformedSequence(wordSize);
         doLUTCoding(
-                lutTransformedSequences,
+                &lutTransformedSequences,
                 configuration.transformedSequenceConfigurations[i].lutTransformationEnabled,
+                configuration.transformedSequenceConfigurations[i].lutTransformationParameter,
                 &transformedSequence
         );
 
@@ -252,14 +343,13 @@ void decode(
     Configuration configuration(jsonInput);
 
     // Decode with the given configuration
-    std::vector<uint64_t> symbols;
+    gabac::SymbolStream symbols;
     decodeWithConfiguration(&bytestream, configuration, &symbols);
 
     // Generate byte buffer from symbol stream
     std::vector<unsigned char> buffer;
-    generateByteBuffer(symbols, configuration.wordSize, &buffer);
+    generateByteBuffer(symbols, &buffer);
     symbols.clear();
-    symbols.shrink_to_fit();
 
     // Write the bytestream
     OutputFile outputFile(outputFilePath);
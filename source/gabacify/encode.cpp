@@ -11,6 +11,7 @@
 #include "gabac/constants.h"
 #include "gabac/encoding.h"
 #include "gabac/diff_coding.h"
+#include "gabac/lut_transform.h"
 
 #include "gabacify/analysis.h"
 #include "gabacify/configuration.h"
@@ -43,111 +44,218 @@ void appendToBytestream(
 
 //------------------------------------------------------------------------------
 
-void doSequenceTransform(const std::vector<uint64_t>& sequence,
+void doSequenceTransform(const gabac::SymbolStream& sequence,
                          const gabac::SequenceTransformationId& transID,
                          uint64_t param,
-                         std::vector<std::vector<uint64_t>> *const transformedSequences
+                         std::vector<gabac::SymbolStream> *const transformedSequences
 ){
     GABACIFY_LOG_TRACE << "Encoding sequence of length: " << sequence.size();
 
     auto id = unsigned(transID);
     GABACIFY_LOG_DEBUG << "Performing sequence transformation " << gabac::transformationInformation[id].name;
 
-    transformedSequences->resize(gabac::transformationInformation[id].streamNames.size());
     gabac::transformationInformation[id].transform(sequence, param, transformedSequences);
 
     GABACIFY_LOG_TRACE << "Got " << transformedSequences->size() << " sequences";
     for (unsigned i = 0; i < transformedSequences->size(); ++i)
     {
-        GABACIFY_LOG_TRACE << i << ": " << (*transformedSequences)[i].size() << " bytes";
+        GABACIFY_LOG_TRACE << i << ": " << (*transformedSequences)[i].size() << " symbols of "
+                           << (*transformedSequences)[i].getWordSize() << " bytes";
     }
 }
 
 //------------------------------------------------------------------------------
 
+template<typename T>
+static void lutTransform(unsigned int order,
+                         const std::vector<T>& sequence,
+                         unsigned int numThreads,
+                         std::vector<gabac::SymbolStream> *const lutSequences
+){
+    gabac::transformLutTransform(
+            order,
+            sequence,
+            numThreads,
+            &(*lutSequences)[0].get<T>(),
+            &(*lutSequences)[1].get<T>(),
+            &(*lutSequences)[2].get<uint32_t>(),
+            &(*lutSequences)[3].get<T>()
+    );
+}
+
+//------------------------------------------------------------------------------
+
 void doLutTransform(bool enabled,
-                    const std::vector<uint64_t>& transformedSequence,
+                    unsigned int order,
+                    const gabac::SymbolStream& transformedSequence,
                     unsigned int wordSize,
+                    unsigned int numThreads,
                     std::vector<unsigned char> *const bytestream,
-                    std::vector<std::vector<uint64_t >> *const lutSequences
+                    std::vector<gabac::SymbolStream> *const lutSequences
 ){
     if (!enabled)
     {
         GABACIFY_LOG_TRACE << "LUT transform *dis*abled";
-        (*lutSequences)[0] = transformedSequence;
+        lutSequences->assign(1, transformedSequence);
         //    appendToBytestream({}, bytestream);
-        GABACIFY_LOG_DEBUG << "Got uncompressed stream after LUT: " << (*lutSequences)[0].size() << " bytes";
-        GABACIFY_LOG_DEBUG << "Got table after LUT: " << (*lutSequences)[1].size() << " bytes";
+        GABACIFY_LOG_DEBUG << "Got uncompressed stream after LUT: " << (*lutSequences)[0].size() << " symbols";
         return;
     }
 
     GABACIFY_LOG_TRACE << "LUT transform *en*abled";
+    // Called directly, as transformationInformation takes no thread count
     const unsigned LUT_INDEX = 4;
-    lutSequences->resize(gabac::transformationInformation[LUT_INDEX].streamNames.size());
-    gabac::transformationInformation[LUT_INDEX].transform(transformedSequence, 0, lutSequences);
+    lutSequences->clear();
+    for (const auto& lutWordSize : gabac::fixWordSizes(
+            gabac::transformationInformation[LUT_INDEX].wordsizes,
+            transformedSequence.getWordSize()
+    ))
+    {
+        lutSequences->emplace_back(lutWordSize);
+    }
+    switch (transformedSequence.getWordSize())
+    {
+        case 1:
+            lutTransform(order, transformedSequence.get<uint8_t>(), numThreads, lutSequences);
+            break;
+        case 2:
+            lutTransform(order, transformedSequence.get<uint16_t>(), numThreads, lutSequences);
+            break;
+        case 4:
+            lutTransform(order, transformedSequence.get<uint32_t>(), numThreads, lutSequences);
+            break;
+        default:
+            lutTransform(order, transformedSequence.get<uint64_t>(), numThreads, lutSequences);
+            break;
+    }
+
+    // No LUT is built for too many different symbols or contexts
+    if ((*lutSequences)[0].size() != transformedSequence.size())
+    {
+        GABACIFY_DIE("LUT transform failed");
+    }
+
+    GABACIFY_LOG_DEBUG << "Got uncompressed stream after LUT: " << (*lutSequences)[0].size() << " symbols";
+    GABACIFY_LOG_DEBUG << "Got table after LUT: " << (*lutSequences)[1].size() << " symbols";
 
-    GABACIFY_LOG_DEBUG << "Got uncompressed stream after LUT: " << (*lutSequences)[0].size() << " bytes";
-    GABACIFY_LOG_DEBUG << "Got table after LUT: " << (*lutSequences)[1].size() << " bytes";
+    // The inverse LUT as sorted values and a permutation
+    std::vector<uint64_t> inverseLutGaps;
+    std::vector<uint64_t> inverseLutPermutation;
+    splitInverseLut((*lutSequences)[1], &inverseLutGaps, &inverseLutPermutation);
 
-    // GABACIFY_LOG_DEBUG<<"lut size before coding: "<<inverseLutTmp
-    auto *data = (int64_t *) (lutSequences->at(1).data());
     std::vector<unsigned char> inverseLutBitstream;
     gabac::encode(
-            std::vector<int64_t>(data, data + (*lutSequences)[1].size()),
-            gabac::BinarizationId::BI,
-            {wordSize * 8},
-            gabac::ContextSelectionId::bypass,
+            inverseLutGaps,
+            gabac::BinarizationId::EG,
+            {},
+            gabac::ContextSelectionId::adaptive_coding_order_0,
             &inverseLutBitstream
     );
-
-
     appendToBytestream(inverseLutBitstream, bytestream);
     GABACIFY_LOG_TRACE << "Wrote LUT bitstream with size: " << inverseLutBitstream.size();
-}
 
-//------------------------------------------------------------------------------
+    if (!inverseLutPermutation.empty())
+    {
+        gabac::encode(
+                inverseLutPermutation,
+                gabac::BinarizationId::BI,
+                {inverseLutPermutationBits(inverseLutPermutation.size())},
+                gabac::ContextSelectionId::adaptive_coding_order_0,
+                &inverseLutBitstream
+        );
+        appendToBytestream(inverseLutBitstream, bytestream);
+        GABACIFY_LOG_TRACE << "Wrote LUT permutation bitstream with size: " << inverseLutBitstream.size();
+    }
 
-void doDiffTransform(bool enabled,
-                     const std::vector<uint64_t>& lutTransformedSequence,
-                     std::vector<int64_t> *const diffAndLutTransformedSequence
-){
-    // Diff coding
-    if (enabled)
+    if (order > 0)
     {
-        GABACIFY_LOG_TRACE << "Diff coding *en*abled";
-        gabac::transformDiffCoding(lutTransformedSequence, diffAndLutTransformedSequence);
-        GABACIFY_LOG_DEBUG << "Got uncompressed stream after diff: "
-                           << diffAndLutTransformedSequence->size()
-                           << " bytes";
-        return;
+        GABACIFY_LOG_DEBUG << "Got higher-order table after LUT: " << (*lutSequences)[2].size() << " symbols";
+        gabac::encode(
+                (*lutSequences)[2],
+                gabac::BinarizationId::EG,
+                {},
+                gabac::ContextSelectionId::adaptive_coding_order_0,
+                &inverseLutBitstream
+        );
+        appendToBytestream(inverseLutBitstream, bytestream);
+        GABACIFY_LOG_TRACE << "Wrote higher-order LUT bitstream with size: " << inverseLutBitstream.size();
     }
 
-    diffAndLutTransformedSequence->reserve(lutTransformedSequence.size());
+    // Only a partial LUT has escaped symbols
+    if ((*lutSequences)[1].size() == gabac::PARTIAL_LUT_SIZE)
+    {
+        GABACIFY_LOG_DEBUG << "Got escaped symbols after LUT: " << (*lutSequences)[3].size() << " symbols";
+        std::vector<uint64_t> escapedSymbolDigits;
+        splitEscapedSymbols((*lutSequences)[3], &escapedSymbolDigits);
+        gabac::encode(
+                escapedSymbolDigits,
+                gabac::BinarizationId::BI,
+                {escapedSymbolDigitBits(wordSize)},
+                gabac::ContextSelectionId::raw,
+                &inverseLutBitstream
+        );
+        appendToBytestream(inverseLutBitstream, bytestream);
+        GABACIFY_LOG_TRACE << "Wrote escaped symbols bitstream with size: " << inverseLutBitstream.size();
+    }
+}
+
+//------------------------------------------------------------------------------
 
-    GABACIFY_LOG_TRACE << "Diff coding *dis*abled";
-    for (const auto& lutTransformedSymbol : lutTransformedSequence)
+void doDiffTransform(const gabac::SymbolStream& lutTransformedSequence,
+                     std::vector<int64_t> *const diffAndLutTransformedSequence
+){
+    GABACIFY_LOG_TRACE << "Diff coding *en*abled";
+    switch (lutTransformedSequence.getWordSize())
     {
-        assert(lutTransformedSymbol <= std::numeric_limits<int64_t>::max());
-        diffAndLutTransformedSequence->push_back(static_cast<int64_t>(lutTransformedSymbol));
+        case 1:
+            gabac::transformDiffCoding(lutTransformedSequence.get<uint8_t>(), diffAndLutTransformedSequence);
+            break;
+        case 2:
+            gabac::transformDiffCoding(lutTransformedSequence.get<uint16_t>(), diffAndLutTransformedSequence);
+            break;
+        case 4:
+            gabac::transformDiffCoding(lutTransformedSequence.get<uint32_t>(), diffAndLutTransformedSequence);
+            break;
+        default:
+            gabac::transformDiffCoding(lutTransformedSequence.get<uint64_t>(), diffAndLutTransformedSequence);
+            break;
     }
-    GABACIFY_LOG_DEBUG << "Got uncompressed stream after diff: " << diffAndLutTransformedSequence->size() << " bytes";
+    GABACIFY_LOG_DEBUG << "Got uncompressed stream after diff: "
+                       << diffAndLutTransformedSequence->size()
+                       << " symbols";
 }
 
 //------------------------------------------------------------------------------
 
 static void encodeStream(const TransformedSequenceConfiguration& conf,
-                         const std::vector<int64_t>& diffAndLutTransformedSequence,
+                         const gabac::SymbolStream& lutTransformedSequence,
                          std::vector<uint8_t> *const bytestream
 ){
-    // Encoding
+    // Encoding; without diff coding the symbols are coded in their own width
     std::vector<unsigned char> bitstream;
-    gabac::encode(
-            diffAndLutTransformedSequence,
-            conf.binarizationId,
-            conf.binarizationParameters,
-            conf.contextSelectionId,
-            &bitstream
-    );
+    if (conf.diffCodingEnabled)
+    {
+        std::vector<int64_t> diffAndLutTransformedSequence;
+        doDiffTransform(lutTransformedSequence, &diffAndLutTransformedSequence);
+        gabac::encode(
+                diffAndLutTransformedSequence,
+                conf.binarizationId,
+                conf.binarizationParameters,
+                conf.contextSelectionId,
+                &bitstream
+        );
+    }
+    else
+    {
+        GABACIFY_LOG_TRACE << "Diff coding *dis*abled";
+        gabac::encode(
+                lutTransformedSequence,
+                conf.binarizationId,
+                conf.binarizationParameters,
+                conf.contextSelectionId,
+                &bitstream
+        );
+    }
     GABACIFY_LOG_TRACE << "Bitstream size: " << bitstream.size();
     appendToBytestream(bitstream, bytestream);
 }
@@ -156,45 +264,34 @@ static void encodeStream(const TransformedSequenceConfiguration& conf,
 
 static void encodeSingleSequence(const unsigned wordsize,
                                  const TransformedSequenceConfiguration& configuration,
-                                 std::vector<uint64_t> *const seq,
+                                 gabac::SymbolStream *const seq,
                                  std::vector<unsigned char> *const bytestream
 ){
-    std::vector<std::vector<uint64_t>> lutTransformedSequences;
-    lutTransformedSequences.resize(2);
+    std::vector<gabac::SymbolStream> lutTransformedSequences;
     doLutTransform(
             configuration.lutTransformationEnabled,
+            configuration.lutTransformationParameter,
             *seq,
             wordsize,
+            0,
             bytestream,
             &lutTransformedSequences
     );
     seq->clear();
-    seq->shrink_to_fit();
-
-    std::vector<int64_t> diffAndLutTransformedSequence;
-    doDiffTransform(
-            configuration.diffCodingEnabled,
-            lutTransformedSequences[0],
-            &diffAndLutTransformedSequence
-    );
-    lutTransformedSequences[0].clear();
-    lutTransformedSequences[0].shrink_to_fit();
 
-    encodeStream(configuration, diffAndLutTransformedSequence, bytestream);
-    diffAndLutTransformedSequence.clear();
-    diffAndLutTransformedSequence.shrink_to_fit();
+    encodeStream(configuration, lutTransformedSequences[0], bytestream);
 }
 
 //------------------------------------------------------------------------------
 
 static void encodeWithConfiguration(
         const Configuration& configuration,
-        std::vector<uint64_t> *const sequence,
+        gabac::SymbolStream *const sequence,
         std::vector<unsigned char> *const bytestream
 ){
 
 
-    std::vector<std::vector<uint64_t>> transformedSequences;
+    std::vector<gabac::SymbolStream> transformedSequences;
     doSequenceTransform(
             *sequence,
             configuration.sequenceTransformationId,
@@ -202,7 +299,6 @@ static void encodeWithConfiguration(
             &transformedSequences
     );
     sequence->clear();
-    sequence->shrink_to_fit();
     std::vector<unsigned> wordsizes = gabac::fixWordSizes(
             gabac::transformationInformation[unsigned(configuration.sequenceTransformationId)].wordsizes,
             configuration.wordSize
@@ -218,7 +314,6 @@ static void encodeWithConfiguration(
                 bytestream
         );
         transformedSequences[i].clear();
-        transformedSequences[i].shrink_to_fit();
     }
 }
 
@@ -240,14 +335,13 @@ void encode_plain(const std::string& inputFilePath,
     Configuration configuration(jsonInput);
 
     // Generate symbol stream from byte buffer
-    std::vector<uint64_t> symbols;
+    gabac::SymbolStream symbols;
     generateSymbolStream(buffer, configuration.wordSize, &symbols);
     buffer.clear();
     buffer.shrink_to_fit();
 
     encodeWithConfiguration(configuration, &symbols, &buffer);
     symbols.clear();
-    symbols.shrink_to_fit();
 
     // Write the bytestream
     OutputFile outputFile(outputFilePath);
@@ -263,7 +357,8 @@ void encode(
         const std::string& inputFilePath,
         bool analyze,
         const std::string& configurationFilePath,
-        const std::string& outputFilePath
+        const std::string& outputFilePath,
+        unsigned numThreads
 ){
     assert(!inputFilePath.empty());
     assert(!configurationFilePath.empty());
@@ -271,7 +366,7 @@ void encode(
 
     if (analyze)
     {
-        encode_analyze(inputFilePath, configurationFilePath, outputFilePath);
+        encode_analyze(inputFilePath, configurationFilePath, outputFilePath, numThreads);
         return;
     }
     encode_plain(inputFilePath, configurationFilePath, outputFilePath);
@@ -13,7 +13,8 @@ void encode(
         const std::string& inputFilePath,
         bool analyze,
         const std::string& configurationFilePath,
-        const std::string& outputFilePath
+        const std::string& outputFilePath,
+        unsigned numThreads
 );
 
 void appendToBytestream(
@@ -21,22 +22,25 @@ void appendToBytestream(
         std::vector<unsigned char> *bytestream
 );
 
-void doDiffTransform(bool enabled,
-                            const std::vector<uint64_t>& lutTransformedSequence,
-                            std::vector<int64_t> *diffAndLutTransformedSequence
+void doDiffTransform(const gabac::SymbolStream& lutTransformedSequence,
+                     std::vector<int64_t> *diffAndLutTransformedSequence
 );
 
+// order is the LUT order (0, 1 or 2); the symbols are counted by numThreads
+// threads (0: one per hardware thread)
 void doLutTransform(bool enabled,
-                           const std::vector<uint64_t>& transformedSequence,
-                           unsigned int wordSize,
-                           std::vector<unsigned char> *bytestream,
-                           std::vector<std::vector<uint64_t >> *lutSequences
+                    unsigned int order,
+                    const gabac::SymbolStream& transformedSequence,
+                    unsigned int wordSize,
+                    unsigned int numThreads,
+                    std::vector<unsigned char> *bytestream,
+                    std::vector<gabac::SymbolStream> *lutSequences
 );
 
-void doSequenceTransform(const std::vector<uint64_t>& sequence,
-                                const gabac::SequenceTransformationId& transID,
-                                uint64_t param,
-                                std::vector<std::vector<uint64_t>> *transformedSequences
+void doSequenceTransform(const gabac::SymbolStream& sequence,
+                         const gabac::SequenceTransformationId& transID,
+                         uint64_t param,
+                         std::vector<gabac::SymbolStream> *transformedSequences
 );
 
 
@@ -7,6 +7,10 @@
 #include <fstream>
 #include <limits>
 #include <map>
+#include <numeric>
+#include <utility>
+
+#include "gabacify/exceptions.h"
 
 
 namespace gabacify {
@@ -84,6 +88,49 @@ void deriveMinMaxSigned(
 }
 
 
+template<typename T>
+static void deriveMinMaxUnsignedExact(
+        const std::vector<T>& symbols,
+        int64_t *const min,
+        int64_t *const max
+){
+    if (symbols.empty())
+    {
+        *min = 0;
+        *max = 0;
+        return;
+    }
+
+    auto minMax = std::minmax_element(symbols.begin(), symbols.end());
+    *min = static_cast<int64_t>(*minMax.first);
+    *max = static_cast<int64_t>(*minMax.second);
+}
+
+
+void deriveMinMaxSigned(
+        const gabac::SymbolStream& symbols,
+        unsigned int,
+        int64_t *const min,
+        int64_t *const max
+){
+    switch (symbols.getWordSize())
+    {
+        case 1:
+            deriveMinMaxUnsignedExact(symbols.get<uint8_t>(), min, max);
+            break;
+        case 2:
+            deriveMinMaxUnsignedExact(symbols.get<uint16_t>(), min, max);
+            break;
+        case 4:
+            deriveMinMaxUnsignedExact(symbols.get<uint32_t>(), min, max);
+            break;
+        default:
+            deriveMinMaxUnsignedExact(symbols.get<uint64_t>(), min, max);
+            break;
+    }
+}
+
+
 void deriveMinMaxUnsigned(
         const std::vector<uint64_t>& symbols,
         unsigned int word_size,
@@ -245,6 +292,378 @@ void generateSymbolStream(
 }
 
 
+template<typename T>
+static void packSymbols(
+        const std::vector<T>& symbols,
+        std::vector<unsigned char> *const buffer
+){
+    buffer->resize(symbols.size() * sizeof(T));
+    unsigned char *bytes = buffer->data();
+    for (const auto& symbol : symbols)
+    {
+        for (unsigned int b = 0; b < sizeof(T); b++)
+        {
+            *bytes++ = static_cast<unsigned char>(symbol >> (8u * b));
+        }
+    }
+}
+
+
+void generateByteBuffer(
+        const gabac::SymbolStream& symbols,
+        std::vector<unsigned char> *const buffer
+){
+    assert(buffer != nullptr);
+
+    switch (symbols.getWordSize())
+    {
+        case 1:
+            packSymbols(symbols.get<uint8_t>(), buffer);
+            break;
+        case 2:
+            packSymbols(symbols.get<uint16_t>(), buffer);
+            break;
+        case 4:
+            packSymbols(symbols.get<uint32_t>(), buffer);
+            break;
+        default:
+            packSymbols(symbols.get<uint64_t>(), buffer);
+            break;
+    }
+}
+
+
+template<typename T>
+static void unpackSymbols(
+        const std::vector<unsigned char>& buffer,
+        std::vector<T> *const symbols
+){
+    symbols->resize(buffer.size() / sizeof(T));
+    const unsigned char *bytes = buffer.data();
+    for (auto& symbol : *symbols)
+    {
+        T value = 0;
+        for (unsigned int b = 0; b < sizeof(T); b++)
+        {
+            value |= static_cast<T>(static_cast<T>(*bytes++) << (8u * b));
+        }
+        symbol = value;
+    }
+}
+
+
+void generateSymbolStream(
+        const std::vector<unsigned char>& buffer,
+        unsigned int wordSize,
+        gabac::SymbolStream *const symbols
+){
+    assert((wordSize == 1) || (wordSize == 2) || (wordSize == 4) || (wordSize == 8));
+    assert((buffer.size() % wordSize) == 0);
+    assert(symbols != nullptr);
+
+    *symbols = gabac::SymbolStream(wordSize);
+    switch (wordSize)
+    {
+        case 1:
+            unpackSymbols(buffer, &symbols->get<uint8_t>());
+            break;
+        case 2:
+            unpackSymbols(buffer, &symbols->get<uint16_t>());
+            break;
+        case 4:
+            unpackSymbols(buffer, &symbols->get<uint32_t>());
+            break;
+        default:
+            unpackSymbols(buffer, &symbols->get<uint64_t>());
+            break;
+    }
+}
+
+
+template<typename T>
+static void splitInverseLut(
+        const std::vector<T>& inverseLut,
+        std::vector<uint64_t> *const gaps,
+        std::vector<uint64_t> *const permutation
+){
+    std::vector<size_t> order(inverseLut.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&inverseLut](size_t a, size_t b)
+    {
+        return inverseLut[a] < inverseLut[b];
+    });
+
+    gaps->clear();
+    uint64_t previous = 0;
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        uint64_t value = inverseLut[order[i]];
+        uint64_t gap = (i == 0) ? value : value - previous - 1;
+        previous = value;
+        if (gap < INVERSE_LUT_GAP_ESCAPE)
+        {
+            gaps->push_back(gap);
+            continue;
+        }
+        gaps->push_back(INVERSE_LUT_GAP_ESCAPE);
+        for (unsigned int digit = 0; digit < 4; digit++)
+        {
+            gaps->push_back((gap >> (48u - 16u * digit)) & 0xffffu);
+        }
+    }
+
+    permutation->clear();
+    if (order.size() > 1)
+    {
+        permutation->resize(order.size());
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            (*permutation)[order[i]] = i;
+        }
+    }
+}
+
+
+void splitInverseLut(
+        const gabac::SymbolStream& inverseLut,
+        std::vector<uint64_t> *const gaps,
+        std::vector<uint64_t> *const permutation
+){
+    assert(gaps != nullptr);
+    assert(permutation != nullptr);
+
+    switch (inverseLut.getWordSize())
+    {
+        case 1:
+            splitInverseLut(inverseLut.get<uint8_t>(), gaps, permutation);
+            break;
+        case 2:
+            splitInverseLut(inverseLut.get<uint16_t>(), gaps, permutation);
+            break;
+        case 4:
+            splitInverseLut(inverseLut.get<uint32_t>(), gaps, permutation);
+            break;
+        default:
+            splitInverseLut(inverseLut.get<uint64_t>(), gaps, permutation);
+            break;
+    }
+}
+
+
+template<typename T>
+static void mergeInverseLut(
+        const std::vector<uint64_t>& gaps,
+        const std::vector<uint64_t>& permutation,
+        std::vector<T> *const inverseLut
+){
+    std::vector<T> sortedValues;
+    uint64_t previous = 0;
+    for (size_t i = 0; i < gaps.size(); i++)
+    {
+        uint64_t gap = gaps[i];
+        if (gap == INVERSE_LUT_GAP_ESCAPE)
+        {
+            if (gaps.size() - i <= 4)
+            {
+                GABACIFY_DIE("Inverse LUT is truncated");
+            }
+            gap = 0;
+            for (unsigned int digit = 0; digit < 4; digit++)
+            {
+                gap = (gap << 16u) | (gaps[++i] & 0xffffu);
+            }
+        }
+        uint64_t value = gap;
+        if (!sortedValues.empty())
+        {
+            value = previous + 1 + gap;
+            if (value <= previous)
+            {
+                GABACIFY_DIE("Inverse LUT is corrupted");
+            }
+        }
+        if (value > std::numeric_limits<T>::max())
+        {
+            GABACIFY_DIE("Inverse LUT is corrupted");
+        }
+        sortedValues.push_back(static_cast<T>(value));
+        previous = value;
+    }
+
+    if (sortedValues.size() <= 1)
+    {
+        *inverseLut = std::move(sortedValues);
+        return;
+    }
+    if (permutation.size() != sortedValues.size())
+    {
+        GABACIFY_DIE("Inverse LUT permutation has the wrong size");
+    }
+    std::vector<bool> isUsed(sortedValues.size(), false);
+    inverseLut->resize(sortedValues.size());
+    for (size_t i = 0; i < permutation.size(); i++)
+    {
+        if (permutation[i] >= sortedValues.size() || isUsed[permutation[i]])
+        {
+            GABACIFY_DIE("Inverse LUT permutation is corrupted");
+        }
+        isUsed[permutation[i]] = true;
+        (*inverseLut)[i] = sortedValues[permutation[i]];
+    }
+}
+
+
+void mergeInverseLut(
+        const std::vector<uint64_t>& gaps,
+        const std::vector<uint64_t>& permutation,
+        gabac::SymbolStream *const inverseLut
+){
+    assert(inverseLut != nullptr);
+
+    switch (inverseLut->getWordSize())
+    {
+        case 1:
+            mergeInverseLut(gaps, permutation, &inverseLut->get<uint8_t>());
+            break;
+        case 2:
+            mergeInverseLut(gaps, permutation, &inverseLut->get<uint16_t>());
+            break;
+        case 4:
+            mergeInverseLut(gaps, permutation, &inverseLut->get<uint32_t>());
+            break;
+        default:
+            mergeInverseLut(gaps, permutation, &inverseLut->get<uint64_t>());
+            break;
+    }
+}
+
+
+size_t inverseLutSize(
+        const std::vector<uint64_t>& gaps
+){
+    size_t size = 0;
+    for (size_t i = 0; i < gaps.size(); i++)
+    {
+        if (gaps[i] == INVERSE_LUT_GAP_ESCAPE)
+        {
+            i += 4;
+        }
+        size++;
+    }
+    return size;
+}
+
+
+unsigned int inverseLutPermutationBits(
+        size_t lutSize
+){
+    unsigned int bits = 1;
+    while (bits < 32 && (uint64_t(1) << bits) < lutSize)
+    {
+        bits++;
+    }
+    return bits;
+}
+
+
+unsigned int escapedSymbolDigitBits(
+        unsigned int wordSize
+){
+    return std::min(wordSize * 8, 32u);
+}
+
+
+void splitEscapedSymbols(
+        const gabac::SymbolStream& escapedSymbols,
+        std::vector<uint64_t> *const digits
+){
+    assert(digits != nullptr);
+
+    digits->clear();
+    switch (escapedSymbols.getWordSize())
+    {
+        case 1:
+            digits->assign(escapedSymbols.get<uint8_t>().begin(), escapedSymbols.get<uint8_t>().end());
+            break;
+        case 2:
+            digits->assign(escapedSymbols.get<uint16_t>().begin(), escapedSymbols.get<uint16_t>().end());
+            break;
+        case 4:
+            digits->assign(escapedSymbols.get<uint32_t>().begin(), escapedSymbols.get<uint32_t>().end());
+            break;
+        default:
+            digits->reserve(2 * escapedSymbols.size());
+            for (const auto& symbol : escapedSymbols.get<uint64_t>())
+            {
+                digits->push_back(symbol >> 32u);
+                digits->push_back(symbol & 0xffffffffu);
+            }
+            break;
+    }
+}
+
+
+template<typename T>
+static void mergeEscapedSymbols(
+        const std::vector<uint64_t>& digits,
+        std::vector<T> *const escapedSymbols
+){
+    escapedSymbols->resize(digits.size());
+    for (size_t i = 0; i < digits.size(); i++)
+    {
+        if (digits[i] > std::numeric_limits<T>::max())
+        {
+            GABACIFY_DIE("Escaped symbols are corrupted");
+        }
+        (*escapedSymbols)[i] = static_cast<T>(digits[i]);
+    }
+}
+
+
+static void mergeEscapedSymbolPairs(
+        const std::vector<uint64_t>& digits,
+        std::vector<uint64_t> *const escapedSymbols
+){
+    if ((digits.size() % 2) != 0)
+    {
+        GABACIFY_DIE("Escaped symbols are truncated");
+    }
+    escapedSymbols->resize(digits.size() / 2);
+    for (size_t i = 0; i < escapedSymbols->size(); i++)
+    {
+        if (digits[2 * i] > 0xffffffffu || digits[2 * i + 1] > 0xffffffffu)
+        {
+            GABACIFY_DIE("Escaped symbols are corrupted");
+        }
+        (*escapedSymbols)[i] = (digits[2 * i] << 32u) | digits[2 * i + 1];
+    }
+}
+
+
+void mergeEscapedSymbols(
+        const std::vector<uint64_t>& digits,
+        gabac::SymbolStream *const escapedSymbols
+){
+    assert(escapedSymbols != nullptr);
+
+    switch (escapedSymbols->getWordSize())
+    {
+        case 1:
+            mergeEscapedSymbols(digits, &escapedSymbols->get<uint8_t>());
+            break;
+        case 2:
+            mergeEscapedSymbols(digits, &escapedSymbols->get<uint16_t>());
+            break;
+        case 4:
+            mergeEscapedSymbols(digits, &escapedSymbols->get<uint32_t>());
+            break;
+        default:
+            mergeEscapedSymbolPairs(digits, &escapedSymbols->get<uint64_t>());
+            break;
+    }
+}
+
+
 double shannonEntropy(
         const std::vector<uint64_t>& data
 ){
@@ -6,6 +6,8 @@
 #include <string>
 #include <vector>
 
+#include "gabac/symbol_stream.h"
+
 
 namespace gabacify {
 
@@ -18,6 +20,16 @@ void deriveMinMaxSigned(
 );
 
 
+// Same as above for unsigned symbols of any width; the range is derived
+// exactly, without the early exit
+void deriveMinMaxSigned(
+        const gabac::SymbolStream& symbols,
+        unsigned int word_size,
+        int64_t *min,
+        int64_t *max
+);
+
+
 void deriveMinMaxUnsigned(
         const std::vector<uint64_t>& symbols,
         unsigned int word_size,
@@ -45,6 +57,77 @@ void generateSymbolStream(
 );
 
 
+// Variants which keep every symbol in wordSize bytes (see gabac::SymbolStream)
+void generateByteBuffer(
+        const gabac::SymbolStream& symbols,
+        std::vector<unsigned char> *buffer
+);
+
+
+void generateSymbolStream(
+        const std::vector<unsigned char>& buffer,
+        unsigned int wordSize,
+        gabac::SymbolStream *symbols
+);
+
+
+// Compact form of an inverse LUT: its values in ascending order, coded as
+// the gaps between them, and the permutation which maps each rank to the
+// position of its value in that order. A gap too large for EG coding is
+// written as INVERSE_LUT_GAP_ESCAPE followed by its four 16-bit digits,
+// most significant first. The permutation is empty for a LUT of at most one
+// entry.
+const uint64_t INVERSE_LUT_GAP_ESCAPE = (1ull << 31u) - 1;
+
+
+void splitInverseLut(
+        const gabac::SymbolStream& inverseLut,
+        std::vector<uint64_t> *gaps,
+        std::vector<uint64_t> *permutation
+);
+
+
+// Inverse of splitInverseLut(); inverseLut keeps its word size
+void mergeInverseLut(
+        const std::vector<uint64_t>& gaps,
+        const std::vector<uint64_t>& permutation,
+        gabac::SymbolStream *inverseLut
+);
+
+
+// Number of gaps coded in gaps, i.e. the size of the inverse LUT
+size_t inverseLutSize(
+        const std::vector<uint64_t>& gaps
+);
+
+
+// Bits per symbol of the permutation of an inverse LUT of lutSize entries
+unsigned int inverseLutPermutationBits(
+        size_t lutSize
+);
+
+
+// Escaped symbols of a partial LUT as digits of escapedSymbolDigitBits()
+// bits each, for BI coding. Symbols of 8 bytes are split into two 32-bit
+// digits, most significant first; narrower symbols are a digit each.
+unsigned int escapedSymbolDigitBits(
+        unsigned int wordSize
+);
+
+
+void splitEscapedSymbols(
+        const gabac::SymbolStream& escapedSymbols,
+        std::vector<uint64_t> *digits
+);
+
+
+// Inverse of splitEscapedSymbols(); escapedSymbols keeps its word size
+void mergeEscapedSymbols(
+        const std::vector<uint64_t>& digits,
+        gabac::SymbolStream *escapedSymbols
+);
+
+
 // based on https://stackoverflow.com/questions/20965960/shannon-entropy
 double shannonEntropy(
         const std::vector<uint64_t>& data
@@ -2,9 +2,32 @@
 
 #include <time.h>
 
+#include <mutex>
+
 #include "gabacify/exceptions.h"
 
 
+static std::mutex& logMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+
+GabacifyLogTmpStdout::~GabacifyLogTmpStdout()
+{
+    std::lock_guard<std::mutex> lock(logMutex());
+    std::cout << m_stream.str() << std::endl;
+}
+
+
+GabacifyLogTmpStderr::~GabacifyLogTmpStderr()
+{
+    std::lock_guard<std::mutex> lock(logMutex());
+    std::cerr << m_stream.str() << std::endl;
+}
+
+
 namespace gabacify {
 
 
@@ -3,30 +3,38 @@
 
 
 #include <iostream>
+#include <sstream>
 #include <string>
 
 
+// Each line is formatted on its own and written as a whole when the
+// temporary goes out of scope, so that lines logged by several threads do
+// not interleave
 struct GabacifyLogTmpStdout {
-    ~GabacifyLogTmpStdout() { std::cout << std::endl; }
+    ~GabacifyLogTmpStdout();
+    std::ostream& stream() { return m_stream; }
+    std::ostringstream m_stream;
 };
 
 
 struct GabacifyLogTmpStderr {
-    ~GabacifyLogTmpStderr() { std::cout << std::endl; }
+    ~GabacifyLogTmpStderr();
+    std::ostream& stream() { return m_stream; }
+    std::ostringstream m_stream;
 };
 
 
-#define GABACIFY_LOG_TRACE (GabacifyLogTmpStdout(), std::cout << "[" << gabacify::currentDateAndTime() << "] [trace] ")
+#define GABACIFY_LOG_TRACE (GabacifyLogTmpStdout().stream() << "[" << gabacify::currentDateAndTime() << "] [trace] ")
 
-#define GABACIFY_LOG_DEBUG (GabacifyLogTmpStdout(), std::cout << "[" << gabacify::currentDateAndTime() << "] [debug] ")
+#define GABACIFY_LOG_DEBUG (GabacifyLogTmpStdout().stream() << "[" << gabacify::currentDateAndTime() << "] [debug] ")
 
-#define GABACIFY_LOG_INFO (GabacifyLogTmpStdout(), std::cout << "[" << gabacify::currentDateAndTime() << "] [info] ")
+#define GABACIFY_LOG_INFO (GabacifyLogTmpStdout().stream() << "[" << gabacify::currentDateAndTime() << "] [info] ")
 
-#define GABACIFY_LOG_WARNING (GabacifyLogTmpStderr(), std::cerr << "[" << gabacify::currentDateAndTime() << "] [warning] ")
+#define GABACIFY_LOG_WARNING (GabacifyLogTmpStderr().stream() << "[" << gabacify::currentDateAndTime() << "] [warning] ")
 
-#define GABACIFY_LOG_ERROR (GabacifyLogTmpStderr(), std::cerr << "[" << gabacify::currentDateAndTime() << "] [error] ")
+#define GABACIFY_LOG_ERROR (GabacifyLogTmpStderr().stream() << "[" << gabacify::currentDateAndTime() << "] [error] ")
 
-#define GABACIFY_LOG_FATAL (GabacifyLogTmpStderr(), std::cerr << "[" << gabacify::currentDateAndTime() << "] [fatal] ")
+#define GABACIFY_LOG_FATAL (GabacifyLogTmpStderr().stream() << "[" << gabacify::currentDateAndTime() << "] [fatal] ")
 
 
 namespace gabacify {
@@ -44,7 +44,8 @@ static int gabacify_main(
                     programOptions.inputFilePath,
                     programOptions.analyze,
                     programOptions.configurationFilePath,
-                    programOptions.outputFilePath
+                    programOptions.outputFilePath,
+                    programOptions.numThreads
             );
         }
         else if (programOptions.task == "decode")
@@ -22,6 +22,7 @@ ProgramOptions::ProgramOptions(
         : analyze(false),
         configurationFilePath(),
         logLevel(),
+        numThreads(0),
         inputFilePath(),
         outputFilePath(),
         task()
@@ -58,6 +59,11 @@ void ProgramOptions::processCommandLine(
                 po::value<std::string>(&(this->logLevel))->default_value("info"),
                 "Log level: 'trace', 'info' (default), 'debug', 'warning', 'error', or 'fatal'"
             )
+            (
+                "threads",
+                po::value<unsigned int>(&(this->numThreads))->default_value(0),
+                "Number of analysis threads (default: 0, i.e. one per hardware thread)"
+            )
             (
                 "input_file_path,i",
                 po::value<std::string>(&(this->inputFilePath))->required(),
@@ -25,6 +25,7 @@ class ProgramOptions
     bool analyze;
     std::string configurationFilePath;
     std::string logLevel;
+    unsigned int numThreads;
     std::string inputFilePath;
     std::string outputFilePath;
     std::string task;
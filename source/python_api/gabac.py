@@ -43,6 +43,7 @@ class ContextSelectionId:
     adaptive_coding_order_0 = 1
     adaptive_coding_order_1 = 2
     adaptive_coding_order_2 = 3
+    raw = 4
 
 
 # encode
@@ -23,3 +23,12 @@ TEST_F(BitInputStreamTest, readByte){
     gabac::BitInputStream bitInputStream(bitstream);
     EXPECT_EQ(bitstream[0], bitInputStream.readByte());
 }
+
+
+TEST_F(BitInputStreamTest, readByteFromBorrowedBuffer){
+    const unsigned char bitstream[] = {0x12, 0x34};
+    gabac::BitInputStream bitInputStream(bitstream, sizeof(bitstream));
+    EXPECT_EQ(0x12, bitInputStream.readByte());
+    EXPECT_EQ(0x34, bitInputStream.readByte());
+    EXPECT_ANY_THROW(bitInputStream.readByte());
+}
@@ -33,3 +33,17 @@ TEST_F(BitOutputStreamTest, writeAlignZero){
     EXPECT_NO_THROW(bitOutputStream.writeAlignZero());
     EXPECT_NO_THROW(bitOutputStream.writeAlignZero());
 }
+
+TEST_F(BitOutputStreamTest, writeByteAndFlush){
+    std::vector<unsigned char> bitstream = {};
+    gabac::BitOutputStream bitOutputStream(&bitstream);
+    for (unsigned int i = 0; i < 10000; i++)
+    {
+        bitOutputStream.writeByte(static_cast<unsigned char>(i));
+    }
+    bitOutputStream.write(0x3, 2);
+    bitOutputStream.flush();
+    ASSERT_EQ(10001u, bitstream.size());
+    EXPECT_EQ(0x0F, bitstream[15]);
+    EXPECT_EQ(0xC0, bitstream[10000]);
+}
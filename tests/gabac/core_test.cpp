@@ -9,6 +9,9 @@
 #include "gabac/constants.h"
 #include "gabac/decoding.h"
 #include "gabac/encoding.h"
+#include "gabac/reader.h"
+#include "gabac/release.h"
+#include "gabac/return_codes.h"
 
 #include "./test_common.h"
 
@@ -85,13 +88,14 @@ TEST_F(coreTest, roundTrip){
     std::vector<std::string> ctxNames = {"bypass",
                                          "order0",
                                          "order1",
-                                         "order2"};
+                                         "order2",
+                                         "raw"};
 
     std::vector<unsigned char> bitstream = {};
     std::vector<int64_t> decodedSymbols = {};
 
     // Roundtrips
-    for (int c = 0; c < 4; ++c)
+    for (int c = 0; c < 5; ++c)
     {
         for (int b = 0; b < 6; ++b)
         {
@@ -119,3 +123,581 @@ TEST_F(coreTest, roundTrip){
         }
     }
 }
+
+
+TEST_F(coreTest, roundTripBypassLongCodes){
+    // Exp-Golomb code words of 2^16 and above have more than 32 bins
+    std::vector<int64_t> sym = {0, 65534, 65535, 65536, 1000000, 2147483646, 300, 0};
+    std::vector<unsigned char> bitstream = {};
+    std::vector<int64_t> decodedSymbols = {};
+
+    for (const auto& binarizationId : {gabac::BinarizationId::EG, gabac::BinarizationId::TEG})
+    {
+        EXPECT_EQ(GABAC_SUCCESS, gabac::encode(sym, binarizationId, {1}, gabac::ContextSelectionId::bypass,
+                                               &bitstream));
+        EXPECT_EQ(GABAC_SUCCESS, gabac::decode(bitstream, binarizationId, {1}, gabac::ContextSelectionId::bypass,
+                                               &decodedSymbols));
+        EXPECT_EQ(sym, decodedSymbols);
+    }
+}
+
+
+TEST_F(coreTest, roundTripLargestEgSymbol){
+    // The code word of 2^31 - 1 has a prefix of 31 zeros and 63 bins in total
+    std::vector<int64_t> sym = {std::numeric_limits<int32_t>::max(), 5, std::numeric_limits<int32_t>::max()};
+    std::vector<unsigned char> bitstream = {};
+    std::vector<int64_t> decodedSymbols = {};
+
+    for (unsigned int c = 0; c < unsigned(gabac::ContextSelectionId::raw) + 1u; ++c)
+    {
+        EXPECT_EQ(GABAC_SUCCESS, gabac::encode(sym, gabac::BinarizationId::EG, {}, gabac::ContextSelectionId(c),
+                                               &bitstream));
+        EXPECT_EQ(GABAC_SUCCESS, gabac::decode(bitstream, gabac::BinarizationId::EG, {},
+                                               gabac::ContextSelectionId(c), &decodedSymbols));
+        EXPECT_EQ(sym, decodedSymbols);
+    }
+}
+
+
+TEST_F(coreTest, roundTripRawLongCodes){
+    // Codes longer than the raw bit accumulator: long unary prefixes and
+    // large Exp-Golomb suffixes
+    std::vector<int64_t> sym = {0, 1, 254, 255, 256, 1000000, 2147483646, 300, 0, 77};
+    std::vector<unsigned char> bitstream = {};
+    std::vector<int64_t> decodedSymbols = {};
+
+    EXPECT_EQ(GABAC_SUCCESS, gabac::encode(sym, gabac::BinarizationId::TEG, {255}, gabac::ContextSelectionId::raw,
+                                           &bitstream));
+    EXPECT_EQ(GABAC_SUCCESS, gabac::decode(bitstream, gabac::BinarizationId::TEG, {255},
+                                           gabac::ContextSelectionId::raw, &decodedSymbols));
+    EXPECT_EQ(sym, decodedSymbols);
+
+    // A truncated stream must not be decoded silently
+    bitstream.resize(bitstream.size() - 2);
+    EXPECT_ANY_THROW(gabac::decode(bitstream, gabac::BinarizationId::TEG, {255}, gabac::ContextSelectionId::raw,
+                                   &decodedSymbols));
+}
+
+
+TEST_F(coreTest, callerBufferApi){
+    std::vector<std::vector<unsigned int>> binarizationParameters = {{16}, {16}, {}, {}, {8}, {8}};
+    std::vector<std::vector<int64_t>> intervals = {{0,     65535},
+                                                   {0,     16},
+                                                   {0,     std::numeric_limits<int32_t>::max()},
+                                                   {std::numeric_limits<int32_t>::min() / 2,
+                                                    std::numeric_limits<int32_t>::max() / 2},
+                                                   {0,     40},
+                                                   {-40,   40}};
+
+    for (int c = 0; c < 5; ++c)
+    {
+        for (int b = 0; b < 6; ++b)
+        {
+            std::vector<int64_t> sym(500);
+            fillVectorRandomUniform(intervals[b][0], intervals[b][1], &sym);
+            std::vector<unsigned int> parameters = binarizationParameters[b];
+            parameters.push_back(0);  // Never pass an empty array
+
+            size_t bound = 0;
+            ASSERT_EQ(GABAC_SUCCESS, gabac_encode_bound(sym.size(), b, parameters.data(), parameters.size(), c, &bound));
+
+            std::vector<unsigned char> reference;
+            ASSERT_EQ(GABAC_SUCCESS, gabac::encode(sym, gabac::BinarizationId(b), binarizationParameters[b],
+                                                   gabac::ContextSelectionId(c), &reference));
+            EXPECT_LE(reference.size(), bound);
+
+            // Too small a buffer reports the required size
+            std::vector<unsigned char> bitstream(bound);
+            size_t bitstreamSize = 0;
+            EXPECT_EQ(GABAC_FAILURE, gabac_encode_into(sym.data(), sym.size(), b, parameters.data(), parameters.size(), c,
+                                                       bitstream.data(), 1, &bitstreamSize));
+            EXPECT_EQ(reference.size(), bitstreamSize);
+            ASSERT_EQ(GABAC_SUCCESS, gabac_encode_into(sym.data(), sym.size(), b, parameters.data(), parameters.size(), c,
+                                                       bitstream.data(), bitstream.size(), &bitstreamSize));
+            bitstream.resize(bitstreamSize);
+            EXPECT_EQ(reference, bitstream);
+
+            size_t symbolsSize = 0;
+            ASSERT_EQ(GABAC_SUCCESS, gabac_decode_size(bitstream.data(), bitstream.size(), c, &symbolsSize));
+            EXPECT_EQ(sym.size(), symbolsSize);
+
+            std::vector<int64_t> decodedSymbols(symbolsSize);
+            EXPECT_EQ(GABAC_FAILURE, gabac_decode_into(bitstream.data(), bitstream.size(), b, parameters.data(),
+                                                       parameters.size(), c, decodedSymbols.data(), symbolsSize - 1,
+                                                       &symbolsSize));
+            ASSERT_EQ(GABAC_SUCCESS, gabac_decode_into(bitstream.data(), bitstream.size(), b, parameters.data(),
+                                                       parameters.size(), c, decodedSymbols.data(),
+                                                       decodedSymbols.size(), &symbolsSize));
+            EXPECT_EQ(sym, decodedSymbols);
+
+            // Binarizations without parameters accept an empty array
+            if (binarizationParameters[b].empty())
+            {
+                ASSERT_EQ(GABAC_SUCCESS, gabac_encode_into(sym.data(), sym.size(), b, nullptr, 0, c,
+                                                           bitstream.data(), bitstream.size(), &bitstreamSize));
+                EXPECT_EQ(reference.size(), bitstreamSize);
+                ASSERT_EQ(GABAC_SUCCESS, gabac_decode_into(bitstream.data(), bitstream.size(), b, nullptr, 0, c,
+                                                           decodedSymbols.data(), decodedSymbols.size(),
+                                                           &symbolsSize));
+                EXPECT_EQ(sym, decodedSymbols);
+
+                // Also for the block APIs
+                unsigned char *blocks = nullptr;
+                size_t blocksSize = 0;
+                ASSERT_EQ(GABAC_SUCCESS, gabac_encode_blocks(sym.data(), sym.size(), b, nullptr, 0, c, 100, 2,
+                                                             &blocks, &blocksSize));
+                int64_t *blockSymbols = nullptr;
+                size_t blockSymbolsSize = 0;
+                ASSERT_EQ(GABAC_SUCCESS, gabac_decode_blocks(blocks, blocksSize, b, nullptr, 0, c, 2,
+                                                             &blockSymbols, &blockSymbolsSize));
+                EXPECT_EQ(sym, std::vector<int64_t>(blockSymbols, blockSymbols + blockSymbolsSize));
+                gabac_release(blockSymbols);
+                ASSERT_EQ(GABAC_SUCCESS, gabac_decode_range(blocks, blocksSize, 150, 200, b, nullptr, 0, c,
+                                                            &blockSymbols, &blockSymbolsSize));
+                EXPECT_EQ(std::vector<int64_t>(sym.begin() + 150, sym.begin() + 350),
+                          std::vector<int64_t>(blockSymbols, blockSymbols + blockSymbolsSize));
+                gabac_release(blockSymbols);
+                gabac_release(blocks);
+            }
+        }
+    }
+}
+
+
+TEST_F(coreTest, sessions){
+    std::vector<std::vector<unsigned int>> binarizationParameters = {{16}, {16}, {}, {}, {8}, {8}};
+    std::vector<std::vector<int64_t>> intervals = {{0,     65535},
+                                                   {0,     16},
+                                                   {0,     1000},
+                                                   {-500,  500},
+                                                   {0,     40},
+                                                   {-40,   40}};
+
+    gabac::EncoderSession encoderSession;
+    gabac::DecoderSession decoderSession;
+    std::vector<unsigned char> bitstream = {};
+
+    // One session pair for all streams, in all configurations; the output
+    // must match that of the one-shot functions
+    for (int c = 0; c < 5; ++c)
+    {
+        for (int b = 0; b < 6; ++b)
+        {
+            for (size_t length : {0, 1, 37, 1000})
+            {
+                std::vector<int64_t> sym(length);
+                fillVectorRandomUniform(intervals[b][0], intervals[b][1], &sym);
+
+                ASSERT_EQ(GABAC_SUCCESS, gabac::encode(sym, gabac::BinarizationId(b), binarizationParameters[b],
+                                                       gabac::ContextSelectionId(c), &bitstream));
+                ASSERT_EQ(GABAC_SUCCESS, encoderSession.encode(sym.data(), sym.size(), gabac::BinarizationId(b),
+                                                               binarizationParameters[b],
+                                                               gabac::ContextSelectionId(c)));
+                EXPECT_EQ(bitstream, encoderSession.getBitstream());
+
+                ASSERT_EQ(GABAC_SUCCESS, decoderSession.decode(encoderSession.getBitstream().data(),
+                                                               encoderSession.getBitstream().size(),
+                                                               gabac::BinarizationId(b), binarizationParameters[b],
+                                                               gabac::ContextSelectionId(c)));
+                EXPECT_EQ(sym, decoderSession.getSymbols());
+            }
+        }
+    }
+
+    // Once warmed up, the buffers are reused
+    std::vector<int64_t> sym(100, 7);
+    const unsigned char *bitstreamData = encoderSession.getBitstream().data();
+    const int64_t *symbolsData = decoderSession.getSymbols().data();
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_EQ(GABAC_SUCCESS, encoderSession.encode(sym.data(), sym.size(), gabac::BinarizationId::EG, {},
+                                                       gabac::ContextSelectionId::adaptive_coding_order_2));
+        ASSERT_EQ(GABAC_SUCCESS, decoderSession.decode(encoderSession.getBitstream().data(),
+                                                       encoderSession.getBitstream().size(),
+                                                       gabac::BinarizationId::EG, {},
+                                                       gabac::ContextSelectionId::adaptive_coding_order_2));
+        EXPECT_EQ(sym, decoderSession.getSymbols());
+    }
+    EXPECT_EQ(bitstreamData, encoderSession.getBitstream().data());
+    EXPECT_EQ(symbolsData, decoderSession.getSymbols().data());
+}
+
+
+TEST_F(coreTest, streamEncoder){
+    std::vector<int64_t> sym(2500);
+    fillVectorRandomUniform<int64_t>(-40, 40, &sym);
+
+    for (int c = 0; c < 5; ++c)
+    {
+        std::vector<unsigned char> reference = {};
+        for (size_t pushSize : {2500, 1, 7, 100, 1000})
+        {
+            std::vector<unsigned char> bitstream = {};
+            gabac::StreamEncoder encoder(256);
+            ASSERT_EQ(GABAC_SUCCESS, encoder.begin(
+                    gabac::BinarizationId::STEG,
+                    {8},
+                    gabac::ContextSelectionId(c),
+                    [&bitstream](const unsigned char *bytes, size_t numBytes)
+                    {
+                        bitstream.insert(bitstream.end(), bytes, bytes + numBytes);
+                    }
+            ));
+            for (size_t i = 0; i < sym.size(); i += pushSize)
+            {
+                ASSERT_EQ(GABAC_SUCCESS, encoder.push(sym.data() + i, std::min(pushSize, sym.size() - i)));
+            }
+            ASSERT_EQ(GABAC_SUCCESS, encoder.finish());
+
+            // The chunking does not depend on how the symbols were pushed
+            if (reference.empty())
+            {
+                reference = bitstream;
+            }
+            EXPECT_EQ(reference, bitstream);
+        }
+
+        // Walk the chunks and decode each of them
+        std::vector<int64_t> decodedSymbols = {};
+        size_t pos = 0;
+        while (true)
+        {
+            ASSERT_LE(pos + 8, reference.size());
+            size_t numSymbols = reference[pos] | (reference[pos + 1] << 8u) | (reference[pos + 2] << 16u);
+            size_t payloadSize = reference[pos + 4] | (reference[pos + 5] << 8u) | (reference[pos + 6] << 16u);
+            pos += 8;
+            if (numSymbols == 0)
+            {
+                break;
+            }
+            EXPECT_LE(numSymbols, 256u);
+            ASSERT_LE(pos + payloadSize, reference.size());
+
+            std::vector<int64_t> chunkSymbols(numSymbols);
+            gabac::Reader reader(reference.data() + pos, payloadSize);
+            reader.readValues(chunkSymbols.data(), numSymbols, gabac::BinarizationId::STEG, {8},
+                              gabac::ContextSelectionId(c));
+            decodedSymbols.insert(decodedSymbols.end(), chunkSymbols.begin(), chunkSymbols.end());
+            pos += payloadSize;
+        }
+        EXPECT_EQ(reference.size(), pos);
+        EXPECT_EQ(sym, decodedSymbols);
+    }
+
+    // push() and finish() need begin()
+    gabac::StreamEncoder encoder;
+    EXPECT_EQ(GABAC_FAILURE, encoder.push(sym.data(), 1));
+    EXPECT_EQ(GABAC_FAILURE, encoder.finish());
+}
+
+
+TEST_F(coreTest, streamDecoder){
+    std::vector<int64_t> sym(3000);
+    fillVectorRandomUniform<int64_t>(0, 1000, &sym);
+
+    for (int c = 0; c < 5; ++c)
+    {
+        std::vector<unsigned char> bitstream = {};
+        gabac::StreamEncoder encoder(300);
+        ASSERT_EQ(GABAC_SUCCESS, encoder.begin(
+                gabac::BinarizationId::EG,
+                {},
+                gabac::ContextSelectionId(c),
+                [&bitstream](const unsigned char *bytes, size_t numBytes)
+                {
+                    bitstream.insert(bitstream.end(), bytes, bytes + numBytes);
+                }
+        ));
+        ASSERT_EQ(GABAC_SUCCESS, encoder.push(sym.data(), sym.size()));
+        ASSERT_EQ(GABAC_SUCCESS, encoder.finish());
+
+        // Pull batches smaller than, equal to and larger than a chunk, from a
+        // source which delivers at most 100 bytes at a time
+        for (size_t batchSize : {1, 37, 300, 1000, 5000})
+        {
+            size_t pos = 0;
+            gabac::StreamDecoder decoder;
+            ASSERT_EQ(GABAC_SUCCESS, decoder.begin(
+                    gabac::BinarizationId::EG,
+                    {},
+                    gabac::ContextSelectionId(c),
+                    [&bitstream, &pos](unsigned char *bytes, size_t maxBytes)
+                    {
+                        size_t numBytes = std::min({maxBytes, bitstream.size() - pos, static_cast<size_t>(100)});
+                        std::copy(bitstream.begin() + pos, bitstream.begin() + pos + numBytes, bytes);
+                        pos += numBytes;
+                        return numBytes;
+                    }
+            ));
+
+            std::vector<int64_t> decodedSymbols = {};
+            std::vector<int64_t> batch(batchSize);
+            size_t numSymbols = 0;
+            do
+            {
+                ASSERT_EQ(GABAC_SUCCESS, decoder.next(batch.data(), batch.size(), &numSymbols));
+                decodedSymbols.insert(decodedSymbols.end(), batch.begin(), batch.begin() + numSymbols);
+            } while (numSymbols > 0);
+            EXPECT_EQ(sym, decodedSymbols);
+            EXPECT_EQ(bitstream.size(), pos);
+        }
+
+        // Truncated input
+        size_t pos = 0;
+        size_t truncatedSize = bitstream.size() / 2;
+        gabac::StreamDecoder decoder;
+        ASSERT_EQ(GABAC_SUCCESS, decoder.begin(
+                gabac::BinarizationId::EG,
+                {},
+                gabac::ContextSelectionId(c),
+                [&bitstream, &pos, truncatedSize](unsigned char *bytes, size_t maxBytes)
+                {
+                    size_t numBytes = std::min(maxBytes, truncatedSize - pos);
+                    std::copy(bitstream.begin() + pos, bitstream.begin() + pos + numBytes, bytes);
+                    pos += numBytes;
+                    return numBytes;
+                }
+        ));
+        std::vector<int64_t> batch(sym.size());
+        size_t numSymbols = 0;
+        EXPECT_EQ(GABAC_FAILURE, decoder.next(batch.data(), batch.size(), &numSymbols));
+
+        // Corrupt chunk headers: a payload larger than the input, and more
+        // symbols than the payload can hold
+        for (const auto& header : std::vector<std::vector<unsigned char>>{{0x10, 0, 0, 0, 0xff, 0xff, 0xff, 0xff},
+                                                                          {0xff, 0xff, 0xff, 0xff, 0x04, 0, 0, 0}})
+        {
+            std::vector<unsigned char> corrupt = header;
+            corrupt.insert(corrupt.end(), bitstream.begin() + header.size(), bitstream.end());
+            pos = 0;
+            ASSERT_EQ(GABAC_SUCCESS, decoder.begin(
+                    gabac::BinarizationId::EG,
+                    {},
+                    gabac::ContextSelectionId(c),
+                    [&corrupt, &pos](unsigned char *bytes, size_t maxBytes)
+                    {
+                        size_t numBytes = std::min(maxBytes, corrupt.size() - pos);
+                        std::copy(corrupt.begin() + pos, corrupt.begin() + pos + numBytes, bytes);
+                        pos += numBytes;
+                        return numBytes;
+                    }
+            ));
+            EXPECT_EQ(GABAC_FAILURE, decoder.next(batch.data(), 1, &numSymbols));
+        }
+    }
+}
+
+
+TEST_F(coreTest, roundTripBlocks){
+    std::vector<std::vector<unsigned int>> binarizationParameters = {{16}, {16}, {}, {}, {8}, {8}};
+    std::vector<std::vector<int64_t>> intervals = {{0,     65535},
+                                                   {0,     16},
+                                                   {0,     1000},
+                                                   {-500,  500},
+                                                   {0,     40},
+                                                   {-40,   40}};
+
+    std::vector<unsigned char> bitstream = {};
+    std::vector<int64_t> decodedSymbols = {};
+
+    for (int c = 0; c < 5; ++c)
+    {
+        for (int b = 0; b < 6; ++b)
+        {
+            std::vector<int64_t> sym(600);
+            fillVectorRandomUniform(intervals[b][0], intervals[b][1], &sym);
+
+            for (size_t blockSize : {13, 256, 5000})
+            {
+                ASSERT_EQ(GABAC_SUCCESS, gabac::encodeBlocks(
+                        sym,
+                        gabac::BinarizationId(b),
+                        binarizationParameters[b],
+                        gabac::ContextSelectionId(c),
+                        blockSize,
+                        1,
+                        &bitstream
+                ));
+                ASSERT_EQ(GABAC_SUCCESS, gabac::decodeBlocks(
+                        bitstream,
+                        gabac::BinarizationId(b),
+                        binarizationParameters[b],
+                        gabac::ContextSelectionId(c),
+                        1,
+                        &decodedSymbols
+                ));
+                EXPECT_EQ(sym, decodedSymbols);
+
+                // Slices within one block, across block borders and at the end
+                for (const auto& range : std::vector<std::pair<size_t, size_t>>{{0, 1}, {5, 3}, {95, 10},
+                                                                                {333, 200}, {599, 1}, {600, 0}})
+                {
+                    ASSERT_EQ(GABAC_SUCCESS, gabac::decodeRange(
+                            bitstream,
+                            range.first,
+                            range.second,
+                            gabac::BinarizationId(b),
+                            binarizationParameters[b],
+                            gabac::ContextSelectionId(c),
+                            &decodedSymbols
+                    ));
+                    EXPECT_EQ(std::vector<int64_t>(sym.begin() + range.first,
+                                                   sym.begin() + range.first + range.second), decodedSymbols);
+                }
+            }
+        }
+    }
+}
+
+
+TEST_F(coreTest, blocksMultiThreaded){
+    std::vector<int64_t> sym(5000);
+    fillVectorRandomUniform<int64_t>(0, 1000, &sym);
+
+    std::vector<unsigned char> reference = {};
+    std::vector<unsigned char> bitstream = {};
+    std::vector<int64_t> decodedSymbols = {};
+
+    for (int c = 0; c < 5; ++c)
+    {
+        ASSERT_EQ(GABAC_SUCCESS, gabac::encodeBlocks(sym, gabac::BinarizationId::EG, {},
+                                                     gabac::ContextSelectionId(c), 300, 1, &reference));
+
+        // The bitstream must not depend on the number of threads
+        for (unsigned int numThreads : {0u, 2u, 3u, 4u, 64u})
+        {
+            ASSERT_EQ(GABAC_SUCCESS, gabac::encodeBlocks(sym, gabac::BinarizationId::EG, {},
+                                                         gabac::ContextSelectionId(c), 300, numThreads, &bitstream));
+            EXPECT_EQ(reference, bitstream);
+
+            ASSERT_EQ(GABAC_SUCCESS, gabac::decodeBlocks(reference, gabac::BinarizationId::EG, {},
+                                                         gabac::ContextSelectionId(c), numThreads, &decodedSymbols));
+            EXPECT_EQ(sym, decodedSymbols);
+        }
+    }
+}
+
+
+TEST_F(coreTest, decodeRangeErrors){
+    std::vector<int64_t> sym = {1, 2, 3, 4, 5};
+    std::vector<unsigned char> bitstream = {};
+    std::vector<int64_t> decodedSymbols = {};
+
+    EXPECT_EQ(GABAC_FAILURE, gabac::encodeBlocks(sym, gabac::BinarizationId::BI, {8},
+                                                 gabac::ContextSelectionId::bypass, 0, 1, &bitstream));
+    ASSERT_EQ(GABAC_SUCCESS, gabac::encodeBlocks(sym, gabac::BinarizationId::BI, {8},
+                                                 gabac::ContextSelectionId::bypass, 2, 1, &bitstream));
+
+    // Range beyond the end of the stream
+    EXPECT_EQ(GABAC_FAILURE, gabac::decodeRange(bitstream, 4, 2, gabac::BinarizationId::BI, {8},
+                                                gabac::ContextSelectionId::bypass, &decodedSymbols));
+
+    // Truncated block index
+    std::vector<unsigned char> truncated(bitstream.begin(), bitstream.begin() + 12);
+    EXPECT_EQ(GABAC_FAILURE, gabac::decodeRange(truncated, 0, 1, gabac::BinarizationId::BI, {8},
+                                                gabac::ContextSelectionId::bypass, &decodedSymbols));
+}
+
+
+TEST_F(coreTest, narrowSymbolWidths){
+    std::vector<uint64_t> sym64(5000);
+    fillVectorRandomUniform<uint64_t>(0, 200, &sym64);
+    std::vector<int64_t> sym(sym64.begin(), sym64.end());
+    std::vector<uint8_t> sym8(sym64.begin(), sym64.end());
+    std::vector<uint16_t> sym16(sym64.begin(), sym64.end());
+    std::vector<uint32_t> sym32(sym64.begin(), sym64.end());
+    std::vector<unsigned char> reference = {};
+    std::vector<unsigned char> bitstream = {};
+
+    for (int c = 0; c < 4; ++c)
+    {
+        gabac::ContextSelectionId contextSelectionId = gabac::ContextSelectionId(c);
+        ASSERT_EQ(GABAC_SUCCESS, gabac::encode(sym, gabac::BinarizationId::EG, {}, contextSelectionId, &reference));
+
+        // The bitstream must not depend on the symbol width
+        ASSERT_EQ(GABAC_SUCCESS, gabac::encode(sym8, gabac::BinarizationId::EG, {}, contextSelectionId, &bitstream));
+        EXPECT_EQ(reference, bitstream);
+        ASSERT_EQ(GABAC_SUCCESS, gabac::encode(sym16, gabac::BinarizationId::EG, {}, contextSelectionId, &bitstream));
+        EXPECT_EQ(reference, bitstream);
+        ASSERT_EQ(GABAC_SUCCESS, gabac::encode(sym32, gabac::BinarizationId::EG, {}, contextSelectionId, &bitstream));
+        EXPECT_EQ(reference, bitstream);
+
+        gabac::SymbolStream stream(2);
+        stream.get<uint16_t>() = sym16;
+        ASSERT_EQ(GABAC_SUCCESS, gabac::encode(stream, gabac::BinarizationId::EG, {}, contextSelectionId, &bitstream));
+        EXPECT_EQ(reference, bitstream);
+
+        std::vector<uint8_t> decoded8 = {};
+        ASSERT_EQ(GABAC_SUCCESS, gabac::decode(reference, gabac::BinarizationId::EG, {}, contextSelectionId,
+                                               &decoded8));
+        EXPECT_EQ(sym8, decoded8);
+        std::vector<uint32_t> decoded32 = {};
+        ASSERT_EQ(GABAC_SUCCESS, gabac::decode(reference, gabac::BinarizationId::EG, {}, contextSelectionId,
+                                               &decoded32));
+        EXPECT_EQ(sym32, decoded32);
+
+        gabac::SymbolStream decodedStream(1);
+        ASSERT_EQ(GABAC_SUCCESS, gabac::decode(reference.data(), reference.size(), gabac::BinarizationId::EG, {},
+                                               contextSelectionId, &decodedStream));
+        EXPECT_EQ(sym8, decodedStream.get<uint8_t>());
+    }
+}
+
+
+TEST_F(coreTest, estimateBits){
+    std::vector<uint64_t> symbols(20000);
+    fillVectorRandomGeometric<uint64_t>(&symbols);
+    std::vector<unsigned char> bitstream = {};
+    double numBits = 0;
+
+    for (int c = 0; c <= int(gabac::ContextSelectionId::raw); ++c)
+    {
+        gabac::ContextSelectionId contextSelectionId = gabac::ContextSelectionId(c);
+        ASSERT_EQ(GABAC_SUCCESS, gabac::encode(symbols, gabac::BinarizationId::EG, {}, contextSelectionId,
+                                               &bitstream));
+        ASSERT_EQ(GABAC_SUCCESS, gabac::estimateBits(symbols, gabac::BinarizationId::EG, {}, contextSelectionId,
+                                                     &numBits));
+        if (contextSelectionId == gabac::ContextSelectionId::raw)
+        {
+            EXPECT_EQ(8.0 * bitstream.size(), numBits);
+        }
+        else
+        {
+            EXPECT_NEAR(8.0 * bitstream.size(), numBits, 0.01 * 8.0 * bitstream.size());
+        }
+    }
+
+    EXPECT_NE(GABAC_SUCCESS, gabac::estimateBits(symbols, gabac::BinarizationId(42), {},
+                                                 gabac::ContextSelectionId::bypass, &numBits));
+}
+
+
+TEST_F(coreTest, byteBudget){
+    std::vector<uint64_t> symbols(20000);
+    fillVectorRandomGeometric<uint64_t>(&symbols);
+    std::vector<unsigned char> reference = {};
+    std::vector<unsigned char> bitstream = {};
+    double numBits = 0;
+
+    for (int c = 0; c <= int(gabac::ContextSelectionId::raw); ++c)
+    {
+        gabac::ContextSelectionId contextSelectionId = gabac::ContextSelectionId(c);
+        ASSERT_EQ(GABAC_SUCCESS, gabac::encode(symbols, gabac::BinarizationId::EG, {}, contextSelectionId,
+                                               &reference));
+
+        // A budget of exactly the output size is enough
+        ASSERT_EQ(GABAC_SUCCESS, gabac::encode(symbols, gabac::BinarizationId::EG, {}, contextSelectionId,
+                                               &bitstream, reference.size()));
+        EXPECT_EQ(reference, bitstream);
+
+        EXPECT_EQ(GABAC_BUDGET_EXCEEDED, gabac::encode(symbols, gabac::BinarizationId::EG, {}, contextSelectionId,
+                                                       &bitstream, reference.size() - 1));
+        EXPECT_TRUE(bitstream.empty());
+        EXPECT_EQ(GABAC_BUDGET_EXCEEDED, gabac::encode(symbols, gabac::BinarizationId::EG, {}, contextSelectionId,
+                                                       &bitstream, reference.size() / 10));
+        EXPECT_TRUE(bitstream.empty());
+
+        EXPECT_EQ(GABAC_BUDGET_EXCEEDED, gabac::estimateBits(symbols, gabac::BinarizationId::EG, {},
+                                                             contextSelectionId, &numBits, reference.size() / 10));
+    }
+}
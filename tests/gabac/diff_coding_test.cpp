@@ -7,6 +7,7 @@
 
 
 #include "gabac/diff_coding.h"
+#include "gabac/return_codes.h"
 #include "./test_common.h"
 
 #include "gtest/gtest.h"
@@ -170,3 +171,42 @@ TEST_F(DiffCodingTest, roundTripCoding){
     symbols.clear();
 }
 
+TEST_F(DiffCodingTest, callerBufferApi){
+    std::vector<uint64_t> symbols(1000);
+    fillVectorRandomUniform<uint64_t>(0, 1000, &symbols);
+    std::vector<int64_t> expected;
+    gabac::transformDiffCoding(symbols, &expected);
+
+    std::vector<int64_t> transformedSymbols(symbols.size());
+    EXPECT_EQ(GABAC_FAILURE, gabac_transformDiffCodingInto(symbols.data(), symbols.size(), transformedSymbols.data(),
+                                                           symbols.size() - 1));
+    ASSERT_EQ(GABAC_SUCCESS, gabac_transformDiffCodingInto(symbols.data(), symbols.size(), transformedSymbols.data(),
+                                                           transformedSymbols.size()));
+    EXPECT_EQ(expected, transformedSymbols);
+
+    std::vector<uint64_t> decodedSymbols(symbols.size());
+    ASSERT_EQ(GABAC_SUCCESS, gabac_inverseTransformDiffCodingInto(transformedSymbols.data(), transformedSymbols.size(),
+                                                                  decodedSymbols.data(), decodedSymbols.size()));
+    EXPECT_EQ(symbols, decodedSymbols);
+}
+
+TEST_F(DiffCodingTest, roundTripCodingNarrow){
+    // Large enough to be decoded in chunks; the narrow symbols wrap around
+    std::vector<uint64_t> values(3 * 1024 * 1024 + 17);
+    fillVectorRandomUniform<uint64_t>(0, 255, &values);
+    std::vector<uint8_t> symbols(values.begin(), values.end());
+    std::vector<int64_t> transformedSymbols;
+    std::vector<uint8_t> decodedSymbols;
+    gabac::transformDiffCoding(symbols, &transformedSymbols);
+    for (unsigned int numThreads : {0u, 1u, 3u})
+    {
+        gabac::inverseTransformDiffCoding(transformedSymbols, &decodedSymbols, numThreads);
+        EXPECT_EQ(symbols, decodedSymbols);
+    }
+
+    std::vector<uint32_t> wideSymbols(values.begin(), values.end());
+    std::vector<uint32_t> decodedWideSymbols;
+    gabac::transformDiffCoding(wideSymbols, &transformedSymbols);
+    gabac::inverseTransformDiffCoding(transformedSymbols, &decodedWideSymbols);
+    EXPECT_EQ(wideSymbols, decodedWideSymbols);
+}
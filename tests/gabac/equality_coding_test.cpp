@@ -1,6 +1,8 @@
+#include <stdexcept>
 #include <vector>
 
 #include "gabac/equality_coding.h"
+#include "gabac/return_codes.h"
 #include "iostream"
 #include "./test_common.h"
 
@@ -128,6 +130,22 @@ TEST_F(equalityCodingTest, inverseTransformEqualityCoding){
         EXPECT_EQ(symbols.size(), expectedSymbols.size());
         EXPECT_EQ(symbols, expectedSymbols);
     }
+    {
+        // Repeats of the initial 0 before the first value
+        std::vector<uint64_t> symbols = {};
+        std::vector<uint64_t> flags = {1, 1, 0, 1};
+        std::vector<uint64_t> rawSymbols = {4};
+        std::vector<uint64_t> expectedSymbols = {0, 0, 5, 5};
+        EXPECT_NO_THROW(gabac::inverseTransformEqualityCoding(flags, rawSymbols, &symbols));
+        EXPECT_EQ(symbols, expectedSymbols);
+    }
+    {
+        // Too few values
+        std::vector<uint64_t> symbols = {};
+        std::vector<uint64_t> flags = {0, 1, 0};
+        std::vector<uint64_t> rawSymbols = {4};
+        EXPECT_THROW(gabac::inverseTransformEqualityCoding(flags, rawSymbols, &symbols), std::out_of_range);
+    }
 }
 
 TEST_F(equalityCodingTest, roundTripCoding){
@@ -148,3 +166,53 @@ TEST_F(equalityCodingTest, roundTripCoding){
     EXPECT_EQ(decodedSymbols, symbols);
     symbols.clear();
 }
+
+TEST_F(equalityCodingTest, callerBufferApi){
+    std::vector<uint64_t> symbols(1000);
+    fillVectorRandomUniform<uint64_t>(0, 3, &symbols);
+    std::vector<uint64_t> expectedFlags;
+    std::vector<uint64_t> expectedValues;
+    gabac::transformEqualityCoding(symbols, &expectedFlags, &expectedValues);
+
+    std::vector<uint64_t> equalityFlags(symbols.size());
+    std::vector<uint64_t> values(symbols.size());
+    size_t valuesSize = 0;
+    EXPECT_EQ(GABAC_FAILURE, gabac_transformEqualityCodingInto(symbols.data(), symbols.size(), equalityFlags.data(),
+                                                               equalityFlags.size(), values.data(), 10, &valuesSize));
+    ASSERT_EQ(GABAC_SUCCESS, gabac_transformEqualityCodingInto(symbols.data(), symbols.size(), equalityFlags.data(),
+                                                               equalityFlags.size(), values.data(), values.size(),
+                                                               &valuesSize));
+    values.resize(valuesSize);
+    EXPECT_EQ(expectedFlags, equalityFlags);
+    EXPECT_EQ(expectedValues, values);
+
+    std::vector<uint64_t> decodedSymbols(symbols.size());
+    ASSERT_EQ(GABAC_SUCCESS, gabac_inverseTransformEqualityCodingInto(equalityFlags.data(), equalityFlags.size(),
+                                                                      values.data(), values.size(),
+                                                                      decodedSymbols.data(), decodedSymbols.size()));
+    EXPECT_EQ(symbols, decodedSymbols);
+
+    // Too few values for the flags
+    EXPECT_EQ(GABAC_FAILURE, gabac_inverseTransformEqualityCodingInto(equalityFlags.data(), equalityFlags.size(),
+                                                                      values.data(), values.size() / 2,
+                                                                      decodedSymbols.data(), decodedSymbols.size()));
+}
+
+TEST_F(equalityCodingTest, narrowWidths){
+    std::vector<uint64_t> symbols(10000);
+    fillVectorRandomUniform<uint64_t>(0, 3, &symbols);
+    std::vector<uint64_t> expectedFlags;
+    std::vector<uint64_t> expectedValues;
+    gabac::transformEqualityCoding(symbols, &expectedFlags, &expectedValues);
+
+    std::vector<uint8_t> symbols8(symbols.begin(), symbols.end());
+    std::vector<uint8_t> flags;
+    std::vector<uint8_t> values;
+    gabac::transformEqualityCoding(symbols8, &flags, &values);
+    EXPECT_EQ(std::vector<uint8_t>(expectedFlags.begin(), expectedFlags.end()), flags);
+    EXPECT_EQ(std::vector<uint8_t>(expectedValues.begin(), expectedValues.end()), values);
+
+    std::vector<uint8_t> decodedSymbols;
+    gabac::inverseTransformEqualityCoding(flags, values, &decodedSymbols);
+    EXPECT_EQ(symbols8, decodedSymbols);
+}
@@ -1,6 +1,9 @@
+#include <algorithm>
+#include <stdexcept>
 #include <vector>
 
 #include "gabac/lut_transform.h"
+#include "gabac/return_codes.h"
 #include "iostream"
 #include "./test_common.h"
 
@@ -33,3 +36,214 @@ TEST_F(lutTransformTest, roundTripCoding0){
     EXPECT_EQ(decodedSymbols.size(), symbols.size());
     EXPECT_EQ(decodedSymbols, symbols);
 }
+
+TEST_F(lutTransformTest, callerBufferApi0){
+    std::vector<uint64_t> symbols(1000);
+    fillVectorRandomUniform<uint64_t>(0, 64, &symbols);
+    std::vector<uint64_t> expectedTransformedSymbols;
+    std::vector<uint64_t> expectedInverseLut;
+    gabac::transformLutTransform0(symbols, &expectedTransformedSymbols, &expectedInverseLut);
+
+    std::vector<uint64_t> transformedSymbols(symbols.size());
+    std::vector<uint64_t> inverseLut(symbols.size());
+    size_t inverseLutSize = 0;
+    ASSERT_EQ(GABAC_SUCCESS, gabac_transformLutTransform0Into(symbols.data(), symbols.size(),
+                                                              transformedSymbols.data(), transformedSymbols.size(),
+                                                              inverseLut.data(), inverseLut.size(), &inverseLutSize));
+    inverseLut.resize(inverseLutSize);
+    EXPECT_EQ(expectedTransformedSymbols, transformedSymbols);
+    EXPECT_EQ(expectedInverseLut, inverseLut);
+
+    std::vector<uint64_t> decodedSymbols(symbols.size());
+    EXPECT_EQ(GABAC_FAILURE, gabac_inverseTransformLutTransform0Into(transformedSymbols.data(),
+                                                                     transformedSymbols.size(), inverseLut.data(),
+                                                                     inverseLut.size(), decodedSymbols.data(), 0));
+    ASSERT_EQ(GABAC_SUCCESS, gabac_inverseTransformLutTransform0Into(transformedSymbols.data(),
+                                                                     transformedSymbols.size(), inverseLut.data(),
+                                                                     inverseLut.size(), decodedSymbols.data(),
+                                                                     decodedSymbols.size()));
+    EXPECT_EQ(symbols, decodedSymbols);
+}
+
+TEST_F(lutTransformTest, tableKinds0){
+    // Directly indexed tables for 1 and 2 bytes, hash tables for 4 and 8
+    // bytes must build the same LUT
+    std::vector<uint64_t> symbols(1024 * 1024);
+    fillVectorRandomGeometric<uint8_t>(&symbols);
+    std::vector<uint64_t> expectedTransformedSymbols;
+    std::vector<uint64_t> expectedInverseLut;
+    gabac::transformLutTransform0(symbols, &expectedTransformedSymbols, &expectedInverseLut);
+    ASSERT_FALSE(expectedInverseLut.empty());
+    EXPECT_EQ(expectedInverseLut.front(), 0);
+
+    std::vector<uint16_t> symbols16(symbols.begin(), symbols.end());
+    std::vector<uint16_t> transformedSymbols16;
+    std::vector<uint16_t> inverseLut16;
+    gabac::transformLutTransform0(symbols16, &transformedSymbols16, &inverseLut16);
+    EXPECT_EQ(std::vector<uint16_t>(expectedInverseLut.begin(), expectedInverseLut.end()), inverseLut16);
+    EXPECT_EQ(std::vector<uint16_t>(expectedTransformedSymbols.begin(), expectedTransformedSymbols.end()),
+              transformedSymbols16);
+
+    std::vector<uint32_t> symbols32(symbols.begin(), symbols.end());
+    std::vector<uint32_t> transformedSymbols32;
+    std::vector<uint32_t> inverseLut32;
+    gabac::transformLutTransform0(symbols32, &transformedSymbols32, &inverseLut32);
+    EXPECT_EQ(std::vector<uint32_t>(expectedInverseLut.begin(), expectedInverseLut.end()), inverseLut32);
+    EXPECT_EQ(std::vector<uint32_t>(expectedTransformedSymbols.begin(), expectedTransformedSymbols.end()),
+              transformedSymbols32);
+
+    // Too many different symbols for a LUT
+    std::vector<uint64_t> distinctSymbols(1u << 20u);
+    for (size_t i = 0; i < distinctSymbols.size(); i++)
+    {
+        distinctSymbols[i] = i * 0x100000001ull;
+    }
+    gabac::transformLutTransform0(distinctSymbols, &expectedTransformedSymbols, &expectedInverseLut);
+    EXPECT_TRUE(expectedInverseLut.empty());
+}
+
+TEST_F(lutTransformTest, roundTripCodingHigherOrder){
+    // Each symbol mostly determines its successor
+    std::vector<uint64_t> noise(100000);
+    fillVectorRandomUniform<uint64_t>(0, 99, &noise);
+    std::vector<uint8_t> symbols(noise.size());
+    uint8_t previous = 0;
+    for (size_t i = 0; i < symbols.size(); i++)
+    {
+        symbols[i] = (noise[i] < 90) ? static_cast<uint8_t>((previous * 7 + 3) % 61) : static_cast<uint8_t>(noise[i]);
+        previous = symbols[i];
+    }
+
+    for (unsigned int order = 0; order <= 2; order++)
+    {
+        std::vector<uint8_t> transformedSymbols;
+        std::vector<uint8_t> inverseLut;
+        std::vector<uint32_t> inverseLutHigherOrder;
+        std::vector<uint8_t> escapedSymbols;
+        std::vector<uint8_t> decodedSymbols;
+        gabac::transformLutTransform(order, symbols, 0, &transformedSymbols, &inverseLut, &inverseLutHigherOrder,
+                                     &escapedSymbols);
+        EXPECT_EQ(order > 0, !inverseLutHigherOrder.empty());
+        EXPECT_TRUE(escapedSymbols.empty());
+        gabac::inverseTransformLutTransform(order, transformedSymbols, inverseLut, inverseLutHigherOrder,
+                                            escapedSymbols, &decodedSymbols);
+        EXPECT_EQ(symbols, decodedSymbols);
+
+        // The predictable successors become rank 0
+        if (order > 0)
+        {
+            size_t numZeros = std::count(transformedSymbols.begin(), transformedSymbols.end(), 0);
+            EXPECT_GT(numZeros, symbols.size() * 8 / 10);
+        }
+    }
+
+    // Orders above 2 are not supported
+    std::vector<uint8_t> transformedSymbols;
+    std::vector<uint8_t> inverseLut;
+    std::vector<uint32_t> inverseLutHigherOrder;
+    std::vector<uint8_t> escapedSymbols;
+    std::vector<uint8_t> decodedSymbols;
+    EXPECT_THROW(gabac::transformLutTransform(3, symbols, 0, &transformedSymbols, &inverseLut, &inverseLutHigherOrder,
+                                              &escapedSymbols), std::out_of_range);
+    EXPECT_THROW(gabac::inverseTransformLutTransform(3, transformedSymbols, inverseLut, inverseLutHigherOrder,
+                                                     escapedSymbols, &decodedSymbols), std::out_of_range);
+}
+
+TEST_F(lutTransformTest, partialLut){
+    // More distinct symbols than fit in a LUT, one of them (7) frequent
+    const size_t numDistinctSymbols = gabac::PARTIAL_LUT_SIZE + 1000 + 1;
+    std::vector<uint32_t> symbols;
+    for (uint32_t i = 0; i + 1 < numDistinctSymbols; i++)
+    {
+        symbols.push_back(i * 3);
+        if (i % 1000 == 0)
+        {
+            symbols.push_back(7);
+            symbols.push_back(7);
+        }
+    }
+
+    {
+        std::vector<uint32_t> transformedSymbols;
+        std::vector<uint32_t> inverseLut;
+        std::vector<uint32_t> inverseLutHigherOrder;
+        std::vector<uint32_t> escapedSymbols;
+        std::vector<uint32_t> decodedSymbols;
+        gabac::transformLutTransform(0, symbols, 0, &transformedSymbols, &inverseLut, &inverseLutHigherOrder,
+                                     &escapedSymbols);
+        EXPECT_EQ(gabac::PARTIAL_LUT_SIZE, inverseLut.size());
+        EXPECT_EQ(7u, inverseLut[0]);
+        EXPECT_EQ(numDistinctSymbols - gabac::PARTIAL_LUT_SIZE, escapedSymbols.size());
+        EXPECT_TRUE(inverseLutHigherOrder.empty());
+        gabac::inverseTransformLutTransform(0, transformedSymbols, inverseLut, inverseLutHigherOrder,
+                                            escapedSymbols, &decodedSymbols);
+        EXPECT_EQ(symbols, decodedSymbols);
+
+        // Counting the symbols on a single thread gives the same LUT
+        std::vector<uint32_t> serialTransformedSymbols;
+        std::vector<uint32_t> serialInverseLut;
+        gabac::transformLutTransform(0, symbols, 1, &serialTransformedSymbols, &serialInverseLut,
+                                     &inverseLutHigherOrder, &escapedSymbols);
+        EXPECT_EQ(inverseLut, serialInverseLut);
+        EXPECT_EQ(transformedSymbols, serialTransformedSymbols);
+    }
+
+    // Each of the PARTIAL_LUT_SIZE ranks and the escape occurs in some
+    // context, so a higher-order LUT on top of a partial one would have at
+    // least 2^20 entries and is refused
+    for (unsigned int order = 1; order <= 2; order++)
+    {
+        std::vector<uint32_t> transformedSymbols;
+        std::vector<uint32_t> inverseLut;
+        std::vector<uint32_t> inverseLutHigherOrder;
+        std::vector<uint32_t> escapedSymbols;
+        gabac::transformLutTransform(order, symbols, 0, &transformedSymbols, &inverseLut, &inverseLutHigherOrder,
+                                     &escapedSymbols);
+        EXPECT_TRUE(transformedSymbols.empty());
+        EXPECT_TRUE(inverseLut.empty());
+        EXPECT_TRUE(inverseLutHigherOrder.empty());
+        EXPECT_TRUE(escapedSymbols.empty());
+    }
+
+    // The order-0 API still refuses to build a partial LUT
+    std::vector<uint32_t> transformedSymbols;
+    std::vector<uint32_t> inverseLut;
+    gabac::transformLutTransform0(symbols, &transformedSymbols, &inverseLut);
+    EXPECT_TRUE(inverseLut.empty());
+}
+
+
+TEST_F(lutTransformTest, partialLutTooManySymbolsToCount){
+    // More distinct symbols than the histogram for a partial LUT holds, two
+    // of them (7 and 5) frequent
+    const size_t numDistinctSymbols = 2 * (gabac::PARTIAL_LUT_SIZE + 1) + 100000 + 2;
+    std::vector<uint32_t> symbols;
+    for (uint32_t i = 0; i + 2 < numDistinctSymbols; i++)
+    {
+        symbols.push_back(i * 3);
+        if (i % 1000 == 0)
+        {
+            symbols.push_back(7);
+            symbols.push_back(7);
+        }
+        if (i % 10000 == 0)
+        {
+            symbols.push_back(5);
+        }
+    }
+
+    std::vector<uint32_t> transformedSymbols;
+    std::vector<uint32_t> inverseLut;
+    std::vector<uint32_t> inverseLutHigherOrder;
+    std::vector<uint32_t> escapedSymbols;
+    std::vector<uint32_t> decodedSymbols;
+    gabac::transformLutTransform(0, symbols, 0, &transformedSymbols, &inverseLut, &inverseLutHigherOrder,
+                                 &escapedSymbols);
+    ASSERT_EQ(gabac::PARTIAL_LUT_SIZE, inverseLut.size());
+    EXPECT_EQ(7u, inverseLut[0]);
+    EXPECT_EQ(5u, inverseLut[1]);
+    EXPECT_EQ(numDistinctSymbols - gabac::PARTIAL_LUT_SIZE, escapedSymbols.size());
+    gabac::inverseTransformLutTransform(0, transformedSymbols, inverseLut, inverseLutHigherOrder, escapedSymbols,
+                                        &decodedSymbols);
+    EXPECT_EQ(symbols, decodedSymbols);
+}
@@ -7,6 +7,7 @@
 #include <random>
 
 #include "gabac/match_coding.h"
+#include "gabac/return_codes.h"
 #include "./test_common.h"
 
 #include "gtest/gtest.h"
@@ -215,6 +216,14 @@ TEST_F(matchCodingTest, inverseTransformMatchCoding){
     EXPECT_NO_THROW(gabac::inverseTransformMatchCoding(pointers, lengths, rawValues, &symbols));
     EXPECT_EQ(symbols.size(), expectedSymbols.size());
     EXPECT_EQ(symbols, expectedSymbols);
+
+    // Matches overlapping their own output
+    expectedSymbols = {1, 2, 3, 1, 2, 3, 1, 2, 3, 1, 2, 3, 1, 2, 3, 1, 7, 7, 7, 7, 7};
+    pointers = {3, 1};
+    lengths = {0, 0, 0, 13, 0, 4};
+    rawValues = {1, 2, 3, 7};
+    EXPECT_NO_THROW(gabac::inverseTransformMatchCoding(pointers, lengths, rawValues, &symbols));
+    EXPECT_EQ(symbols, expectedSymbols);
 }
 
 
@@ -271,3 +280,121 @@ TEST_F(matchCodingTest, roundTripCoding){
     }
     symbols.clear();
 }
+
+TEST_F(matchCodingTest, callerBufferApi){
+    uint32_t windowSize = 32;
+    std::vector<uint64_t> symbols(1000);
+    fillVectorRandomUniform<uint64_t>(0, 3, &symbols);
+    std::vector<uint64_t> expectedPointers;
+    std::vector<uint64_t> expectedLengths;
+    std::vector<uint64_t> expectedRawValues;
+    gabac::transformMatchCoding(symbols, windowSize, &expectedPointers, &expectedLengths, &expectedRawValues);
+
+    std::vector<uint64_t> pointers(symbols.size());
+    std::vector<uint64_t> lengths(symbols.size());
+    std::vector<uint64_t> rawValues(symbols.size());
+    size_t pointersSize = 0;
+    size_t lengthsSize = 0;
+    size_t rawValuesSize = 0;
+    ASSERT_EQ(GABAC_SUCCESS, gabac_transformMatchCodingInto(symbols.data(), symbols.size(), windowSize,
+                                                            pointers.data(), pointers.size(), &pointersSize,
+                                                            lengths.data(), lengths.size(), &lengthsSize,
+                                                            rawValues.data(), rawValues.size(), &rawValuesSize));
+    pointers.resize(pointersSize);
+    lengths.resize(lengthsSize);
+    rawValues.resize(rawValuesSize);
+    EXPECT_EQ(expectedPointers, pointers);
+    EXPECT_EQ(expectedLengths, lengths);
+    EXPECT_EQ(expectedRawValues, rawValues);
+
+    size_t symbolsSize = 0;
+    ASSERT_EQ(GABAC_SUCCESS, gabac_inverseTransformMatchCodingSize(lengths.data(), lengths.size(), &symbolsSize));
+    EXPECT_EQ(symbols.size(), symbolsSize);
+
+    std::vector<uint64_t> decodedSymbols(symbolsSize);
+    EXPECT_EQ(GABAC_FAILURE, gabac_inverseTransformMatchCodingInto(pointers.data(), pointers.size(), lengths.data(),
+                                                                   lengths.size(), rawValues.data(), rawValues.size(),
+                                                                   decodedSymbols.data(), symbolsSize - 1,
+                                                                   &symbolsSize));
+    ASSERT_EQ(GABAC_SUCCESS, gabac_inverseTransformMatchCodingInto(pointers.data(), pointers.size(), lengths.data(),
+                                                                   lengths.size(), rawValues.data(), rawValues.size(),
+                                                                   decodedSymbols.data(), decodedSymbols.size(),
+                                                                   &symbolsSize));
+    EXPECT_EQ(symbols, decodedSymbols);
+
+    // A pointer reaching before the start of the output
+    std::vector<uint64_t> badPointers = {5};
+    std::vector<uint64_t> badLengths = {0, 3};
+    EXPECT_EQ(GABAC_FAILURE, gabac_inverseTransformMatchCodingInto(badPointers.data(), badPointers.size(),
+                                                                   badLengths.data(), badLengths.size(),
+                                                                   rawValues.data(), 1, decodedSymbols.data(),
+                                                                   decodedSymbols.size(), &symbolsSize));
+}
+
+TEST_F(matchCodingTest, narrowWidths){
+    std::vector<uint64_t> symbols(10000);
+    fillVectorRandomUniform<uint64_t>(0, 3, &symbols);
+    std::vector<uint64_t> expectedPointers;
+    std::vector<uint64_t> expectedLengths;
+    std::vector<uint64_t> expectedValues;
+    gabac::transformMatchCoding(symbols, 32, &expectedPointers, &expectedLengths, &expectedValues);
+
+    std::vector<uint8_t> symbols8(symbols.begin(), symbols.end());
+    std::vector<uint32_t> pointers;
+    std::vector<uint32_t> lengths;
+    std::vector<uint8_t> values;
+    gabac::transformMatchCoding(symbols8, 32, &pointers, &lengths, &values);
+    EXPECT_EQ(std::vector<uint32_t>(expectedPointers.begin(), expectedPointers.end()), pointers);
+    EXPECT_EQ(std::vector<uint32_t>(expectedLengths.begin(), expectedLengths.end()), lengths);
+    EXPECT_EQ(std::vector<uint8_t>(expectedValues.begin(), expectedValues.end()), values);
+
+    std::vector<uint8_t> decodedSymbols;
+    gabac::inverseTransformMatchCoding(pointers, lengths, values, &decodedSymbols);
+    EXPECT_EQ(symbols8, decodedSymbols);
+}
+
+TEST_F(matchCodingTest, largeWindow){
+    std::vector<uint64_t> symbols(5000);
+    fillVectorRandomUniform<uint64_t>(0, 3, &symbols);
+    std::vector<uint64_t> repeat = symbols;
+    symbols.push_back(9);
+    symbols.insert(symbols.end(), repeat.begin(), repeat.end());
+
+    std::vector<uint64_t> pointers;
+    std::vector<uint64_t> lengths;
+    std::vector<uint64_t> rawValues;
+    std::vector<uint64_t> decodedSymbols;
+
+    // The repeat is out of reach of a small window ...
+    gabac::transformMatchCoding(symbols, 256, &pointers, &lengths, &rawValues);
+    EXPECT_LT(lengths.back(), 5000);
+
+    // ... but found as a single match in a large one
+    gabac::transformMatchCoding(symbols, 1 << 24, &pointers, &lengths, &rawValues);
+    EXPECT_EQ(pointers.back(), 5001);
+    EXPECT_EQ(lengths.back(), 5000);
+    EXPECT_EQ(rawValues.back(), 9);
+    gabac::inverseTransformMatchCoding(pointers, lengths, rawValues, &decodedSymbols);
+    EXPECT_EQ(symbols, decodedSymbols);
+}
+
+TEST_F(matchCodingTest, repeatBeyondChainRing){
+    // More symbols than the chain ring of the match finder holds
+    std::vector<uint64_t> symbols((1u << 22u) + 1000);
+    fillVectorRandomUniform<uint64_t>(0, std::numeric_limits<uint32_t>::max(), &symbols);
+    std::vector<uint64_t> repeat(symbols.begin(), symbols.begin() + 1000);
+    const uint64_t distance = symbols.size();
+    symbols.insert(symbols.end(), repeat.begin(), repeat.end());
+
+    std::vector<uint64_t> pointers;
+    std::vector<uint64_t> lengths;
+    std::vector<uint64_t> rawValues;
+    std::vector<uint64_t> decodedSymbols;
+
+    gabac::transformMatchCoding(symbols, 1 << 24, &pointers, &lengths, &rawValues);
+    ASSERT_FALSE(pointers.empty());
+    EXPECT_EQ(pointers.back(), distance);
+    EXPECT_GT(lengths.back(), 900);
+    gabac::inverseTransformMatchCoding(pointers, lengths, rawValues, &decodedSymbols);
+    EXPECT_EQ(symbols, decodedSymbols);
+}
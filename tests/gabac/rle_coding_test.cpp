@@ -1,6 +1,7 @@
 #include <vector>
 
 #include "gabac/rle_coding.h"
+#include "gabac/return_codes.h"
 #include "iostream"
 
 #include "gtest/gtest.h"
@@ -185,3 +186,82 @@ TEST_F(rleCodingTest, roundTripCoding){
     EXPECT_EQ(decodedSymbols, symbols);
     symbols.clear();
 }
+
+TEST_F(rleCodingTest, callerBufferApi){
+    uint64_t guard = 5;
+    std::vector<uint64_t> symbols(1000);
+    fillVectorRandomUniform<uint64_t>(0, 1, &symbols);
+    std::fill(symbols.begin() + 100, symbols.begin() + 200, 7);
+    std::vector<uint64_t> expectedRawValues;
+    std::vector<uint64_t> expectedLengths;
+    gabac::transformRleCoding(symbols, guard, &expectedRawValues, &expectedLengths);
+
+    std::vector<uint64_t> rawValues(symbols.size());
+    std::vector<uint64_t> lengths(symbols.size());
+    size_t rawValuesSize = 0;
+    size_t lengthsSize = 0;
+    ASSERT_EQ(GABAC_SUCCESS, gabac_transformRleCodingInto(symbols.data(), symbols.size(), guard, rawValues.data(),
+                                                          rawValues.size(), &rawValuesSize, lengths.data(),
+                                                          lengths.size(), &lengthsSize));
+    rawValues.resize(rawValuesSize);
+    lengths.resize(lengthsSize);
+    EXPECT_EQ(expectedRawValues, rawValues);
+    EXPECT_EQ(expectedLengths, lengths);
+
+    size_t symbolsSize = 0;
+    ASSERT_EQ(GABAC_SUCCESS, gabac_inverseTransformRleCodingSize(lengths.data(), lengths.size(), rawValues.size(),
+                                                                 guard, &symbolsSize));
+    EXPECT_EQ(symbols.size(), symbolsSize);
+
+    std::vector<uint64_t> decodedSymbols(symbolsSize);
+    EXPECT_EQ(GABAC_FAILURE, gabac_inverseTransformRleCodingInto(rawValues.data(), rawValues.size(), lengths.data(),
+                                                                 lengths.size(), guard, decodedSymbols.data(),
+                                                                 symbolsSize - 1, &symbolsSize));
+    EXPECT_EQ(symbols.size(), symbolsSize);
+    ASSERT_EQ(GABAC_SUCCESS, gabac_inverseTransformRleCodingInto(rawValues.data(), rawValues.size(), lengths.data(),
+                                                                 lengths.size(), guard, decodedSymbols.data(),
+                                                                 decodedSymbols.size(), &symbolsSize));
+    EXPECT_EQ(symbols, decodedSymbols);
+}
+
+TEST_F(rleCodingTest, narrowWidths){
+    std::vector<uint64_t> symbols(10000);
+    fillVectorRandomUniform<uint64_t>(0, 2, &symbols);
+    uint64_t guard = 3;
+    std::vector<uint64_t> expectedValues;
+    std::vector<uint64_t> expectedLengths;
+    gabac::transformRleCoding(symbols, guard, &expectedValues, &expectedLengths);
+
+    std::vector<uint16_t> symbols16(symbols.begin(), symbols.end());
+    std::vector<uint16_t> values;
+    std::vector<uint32_t> lengths;
+    gabac::transformRleCoding(symbols16, guard, &values, &lengths);
+    EXPECT_EQ(std::vector<uint16_t>(expectedValues.begin(), expectedValues.end()), values);
+    EXPECT_EQ(std::vector<uint32_t>(expectedLengths.begin(), expectedLengths.end()), lengths);
+
+    std::vector<uint16_t> decodedSymbols;
+    gabac::inverseTransformRleCoding(values, lengths, guard, &decodedSymbols);
+    EXPECT_EQ(symbols16, decodedSymbols);
+}
+
+TEST_F(rleCodingTest, longRuns){
+    // Runs around the block size of the run detection
+    std::vector<uint8_t> symbols;
+    std::vector<uint8_t> expectedRawValues;
+    for (size_t runLength : {1, 2, 63, 64, 65, 66, 127, 128, 129, 1000, 100000})
+    {
+        uint8_t value = static_cast<uint8_t>(expectedRawValues.size() % 2);
+        symbols.insert(symbols.end(), runLength, value);
+        expectedRawValues.push_back(value);
+    }
+    uint64_t guard = 100;
+    std::vector<uint8_t> rawValues;
+    std::vector<uint32_t> lengths;
+    std::vector<uint8_t> decodedSymbols;
+    gabac::transformRleCoding(symbols, guard, &rawValues, &lengths);
+    EXPECT_EQ(expectedRawValues, rawValues);
+    EXPECT_EQ(lengths.size(), 1022);
+    EXPECT_EQ(lengths.back(), 99);
+    gabac::inverseTransformRleCoding(rawValues, lengths, guard, &decodedSymbols);
+    EXPECT_EQ(symbols, decodedSymbols);
+}
@@ -0,0 +1,149 @@
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "gabac/constants.h"
+#include "gabac/encoding.h"
+#include "gabac/return_codes.h"
+#include "gabacify/cost_model.h"
+
+#include "gtest/gtest.h"
+
+
+class costModelTest : public ::testing::Test
+{
+ protected:
+    costModelTest() = default;
+
+    ~costModelTest() override = default;
+
+    void SetUp() override{
+    }
+
+    void TearDown() override{
+    }
+};
+
+
+// 32-bit symbol count and the flush of the arithmetic coder, in bytes
+static const double OVERHEAD = 4 + 2;
+
+
+static unsigned int bitLength(
+        uint64_t value
+){
+    unsigned int length = 0;
+    while (value != 0)
+    {
+        value >>= 1u;
+        length++;
+    }
+    return length;
+}
+
+
+TEST_F(costModelTest, bypassEstimatesAreBinCounts){
+    std::mt19937_64 engine(1);
+    std::uniform_int_distribution<int64_t> dist(0, 200);
+    std::vector<int64_t> symbols(5000);
+    for (auto& symbol : symbols)
+    {
+        symbol = dist(engine);
+    }
+
+    double egBins = 0;
+    double tuBins = 0;
+    for (const auto& symbol : symbols)
+    {
+        egBins += 2 * bitLength(static_cast<uint64_t>(symbol) + 1) - 1;
+        tuBins += std::min(symbol + 1, int64_t(200));
+    }
+
+    gabacify::CostModel costModel(symbols);
+    for (const auto& contextSelectionId : {gabac::ContextSelectionId::bypass, gabac::ContextSelectionId::raw})
+    {
+        EXPECT_DOUBLE_EQ(symbols.size() * 8 / 8.0 + OVERHEAD,
+                         costModel.estimateSize(gabac::BinarizationId::BI, 8, contextSelectionId));
+        EXPECT_DOUBLE_EQ(symbols.size() * 20 / 8.0 + OVERHEAD,
+                         costModel.estimateSize(gabac::BinarizationId::BI, 20, contextSelectionId));
+        EXPECT_DOUBLE_EQ(tuBins / 8 + OVERHEAD,
+                         costModel.estimateSize(gabac::BinarizationId::TU, 200, contextSelectionId));
+        EXPECT_DOUBLE_EQ(egBins / 8 + OVERHEAD,
+                         costModel.estimateSize(gabac::BinarizationId::EG, 0, contextSelectionId));
+    }
+}
+
+
+TEST_F(costModelTest, higherOrderOnOrder2Source){
+    // Each symbol follows from the previous two, with some noise
+    std::mt19937_64 engine(2);
+    std::uniform_int_distribution<int64_t> noise(0, 15);
+    std::vector<int64_t> symbols = {0, 1};
+    while (symbols.size() < 20000)
+    {
+        size_t n = symbols.size();
+        int64_t symbol = (symbols[n - 1] + 2 * symbols[n - 2] + 1) % 4;
+        symbols.push_back((noise(engine) == 0) ? noise(engine) % 4 : symbol);
+    }
+
+    gabacify::CostModel costModel(symbols);
+    for (const auto& binarization : {std::make_pair(gabac::BinarizationId::BI, 2u),
+                                     std::make_pair(gabac::BinarizationId::TU, 3u),
+                                     std::make_pair(gabac::BinarizationId::EG, 0u)})
+    {
+        double order0 = costModel.estimateSize(binarization.first, binarization.second,
+                                               gabac::ContextSelectionId::adaptive_coding_order_0);
+        double order2 = costModel.estimateSize(binarization.first, binarization.second,
+                                               gabac::ContextSelectionId::adaptive_coding_order_2);
+        EXPECT_LE(order2, order0);
+        EXPECT_LT(order2, 0.75 * order0);
+    }
+}
+
+
+TEST_F(costModelTest, bestEstimateMatchesEncodedSize){
+    // Geometrically distributed symbols with a dependency on the previous one
+    std::mt19937_64 engine(3);
+    std::geometric_distribution<int64_t> dist(0.2);
+    std::vector<int64_t> symbols(20000);
+    int64_t previous = 0;
+    for (auto& symbol : symbols)
+    {
+        symbol = std::min(dist(engine) + ((previous > 4) ? 3 : 0), int64_t(255));
+        previous = symbol;
+    }
+
+    gabacify::CostModel costModel(symbols);
+    const std::vector<std::pair<gabac::BinarizationId, unsigned int>> binarizations = {
+            {gabac::BinarizationId::BI, 8},
+            {gabac::BinarizationId::TU, 255},
+            {gabac::BinarizationId::EG, 0},
+            {gabac::BinarizationId::TEG, 2}
+    };
+    double bestEstimate = std::numeric_limits<double>::max();
+    std::pair<gabac::BinarizationId, unsigned int> bestBinarization = binarizations[0];
+    gabac::ContextSelectionId bestContextSelectionId = gabac::ContextSelectionId::bypass;
+    for (const auto& binarization : binarizations)
+    {
+        for (unsigned int c = 0; c < unsigned(gabac::ContextSelectionId::adaptive_coding_order_2) + 1u; ++c)
+        {
+            double estimate = costModel.estimateSize(binarization.first, binarization.second,
+                                                     gabac::ContextSelectionId(c));
+            if (estimate < bestEstimate)
+            {
+                bestEstimate = estimate;
+                bestBinarization = binarization;
+                bestContextSelectionId = gabac::ContextSelectionId(c);
+            }
+        }
+    }
+
+    std::vector<unsigned char> bitstream;
+    ASSERT_EQ(GABAC_SUCCESS, gabac::encode(symbols, bestBinarization.first, {bestBinarization.second},
+                                           bestContextSelectionId, &bitstream));
+    EXPECT_NE(gabac::ContextSelectionId::bypass, bestContextSelectionId);
+    // The estimate takes the adaptive contexts as ideal and is a bit too low
+    EXPECT_NEAR(static_cast<double>(bitstream.size()), bestEstimate, 0.1 * bitstream.size());
+}
@@ -0,0 +1,180 @@
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "gabac/decoding.h"
+#include "gabac/encoding.h"
+#include "gabac/return_codes.h"
+#include "gabac/symbol_stream.h"
+#include "gabacify/exceptions.h"
+#include "gabacify/helpers.h"
+
+#include "gtest/gtest.h"
+
+
+class helpersTest : public ::testing::Test
+{
+ protected:
+    helpersTest() = default;
+
+    ~helpersTest() override = default;
+
+    void SetUp() override{
+    }
+
+    void TearDown() override{
+    }
+};
+
+
+template<typename T>
+static void roundTripInverseLut(
+        const std::vector<T>& values
+){
+    gabac::SymbolStream inverseLut(sizeof(T));
+    inverseLut.get<T>() = values;
+    std::vector<uint64_t> gaps;
+    std::vector<uint64_t> permutation;
+    gabacify::splitInverseLut(inverseLut, &gaps, &permutation);
+    EXPECT_EQ(values.size(), gabacify::inverseLutSize(gaps));
+    EXPECT_EQ(values.size() > 1, !permutation.empty());
+
+    gabac::SymbolStream mergedInverseLut(sizeof(T));
+    gabacify::mergeInverseLut(gaps, permutation, &mergedInverseLut);
+    EXPECT_EQ(values, mergedInverseLut.get<T>());
+}
+
+
+TEST_F(helpersTest, roundTripInverseLut){
+    roundTripInverseLut<uint8_t>({});
+    roundTripInverseLut<uint8_t>({7});
+    roundTripInverseLut<uint8_t>({255, 0});
+    roundTripInverseLut<uint16_t>({3, 65535, 0, 1, 1000});
+    roundTripInverseLut<uint32_t>({});
+    roundTripInverseLut<uint32_t>({std::numeric_limits<uint32_t>::max()});
+    roundTripInverseLut<uint32_t>({0, std::numeric_limits<uint32_t>::max()});
+    roundTripInverseLut<uint64_t>({42, 17});
+}
+
+
+TEST_F(helpersTest, roundTripInverseLutEscapedGaps){
+    // Gaps of 2^31 - 1 and above, also for the first value, are escaped
+    const uint64_t escape = gabacify::INVERSE_LUT_GAP_ESCAPE;
+    std::vector<uint64_t> values = {
+            escape,
+            escape + 1 + escape,
+            escape + 1 + escape + 1 + (escape - 1),
+            1ull << 40u,
+            std::numeric_limits<uint64_t>::max(),
+            std::numeric_limits<uint64_t>::max() - 1
+    };
+    gabac::SymbolStream inverseLut(8);
+    inverseLut.get<uint64_t>() = values;
+    std::vector<uint64_t> gaps;
+    std::vector<uint64_t> permutation;
+    gabacify::splitInverseLut(inverseLut, &gaps, &permutation);
+    EXPECT_EQ(escape, gaps[0]);
+    EXPECT_EQ(escape, gaps[5]);
+    EXPECT_EQ(escape - 1, gaps[10]);
+    EXPECT_EQ(values.size(), gabacify::inverseLutSize(gaps));
+
+    roundTripInverseLut<uint64_t>(values);
+    roundTripInverseLut<uint64_t>({std::numeric_limits<uint64_t>::max()});
+    roundTripInverseLut<uint32_t>({escape, 0, std::numeric_limits<uint32_t>::max()});
+}
+
+
+TEST_F(helpersTest, mergeCorruptedInverseLut){
+    const uint64_t escape = gabacify::INVERSE_LUT_GAP_ESCAPE;
+    gabac::SymbolStream inverseLut(8);
+    gabac::SymbolStream narrowInverseLut(1);
+
+    // Truncated escaped gap
+    EXPECT_THROW(gabacify::mergeInverseLut({escape, 0, 0, 0}, {}, &inverseLut), gabacify::RuntimeException);
+
+    // Value beyond 2^64 - 1
+    EXPECT_THROW(gabacify::mergeInverseLut({1, escape, 0xffff, 0xffff, 0xffff, 0xffff}, {0, 1}, &inverseLut),
+                 gabacify::RuntimeException);
+
+    // Value too large for the word size
+    EXPECT_THROW(gabacify::mergeInverseLut({256}, {}, &narrowInverseLut), gabacify::RuntimeException);
+    EXPECT_THROW(gabacify::mergeInverseLut({200, 55}, {0, 1}, &narrowInverseLut), gabacify::RuntimeException);
+
+    // Permutation of the wrong size, with a rank out of range and with a
+    // repeated rank
+    EXPECT_THROW(gabacify::mergeInverseLut({1, 2}, {}, &inverseLut), gabacify::RuntimeException);
+    EXPECT_THROW(gabacify::mergeInverseLut({1, 2}, {0}, &inverseLut), gabacify::RuntimeException);
+    EXPECT_THROW(gabacify::mergeInverseLut({1, 2}, {0, 1, 2}, &inverseLut), gabacify::RuntimeException);
+    EXPECT_THROW(gabacify::mergeInverseLut({1, 2}, {0, 2}, &inverseLut), gabacify::RuntimeException);
+    EXPECT_THROW(gabacify::mergeInverseLut({1, 2}, {1, 1}, &inverseLut), gabacify::RuntimeException);
+
+    EXPECT_NO_THROW(gabacify::mergeInverseLut({1, 2}, {1, 0}, &inverseLut));
+    EXPECT_EQ(std::vector<uint64_t>({4, 1}), inverseLut.get<uint64_t>());
+}
+
+
+// Codes the escaped symbols as gabacify does and decodes them again
+template<typename T>
+static void roundTripEscapedSymbols(
+        const std::vector<T>& values
+){
+    gabac::SymbolStream escapedSymbols(sizeof(T));
+    escapedSymbols.get<T>() = values;
+    std::vector<uint64_t> digits;
+    gabacify::splitEscapedSymbols(escapedSymbols, &digits);
+    EXPECT_EQ(values.size() * ((sizeof(T) == 8) ? 2 : 1), digits.size());
+
+    const unsigned int digitBits = gabacify::escapedSymbolDigitBits(sizeof(T));
+    EXPECT_LE(digitBits, 32);
+    std::vector<unsigned char> bitstream;
+    ASSERT_EQ(
+            GABAC_SUCCESS,
+            gabac::encode(digits, gabac::BinarizationId::BI, {digitBits}, gabac::ContextSelectionId::raw, &bitstream)
+    );
+    std::vector<uint64_t> decodedDigits;
+    ASSERT_EQ(
+            GABAC_SUCCESS,
+            gabac::decode(
+                    bitstream,
+                    gabac::BinarizationId::BI,
+                    {digitBits},
+                    gabac::ContextSelectionId::raw,
+                    &decodedDigits
+            )
+    );
+    EXPECT_EQ(digits, decodedDigits);
+
+    gabac::SymbolStream mergedEscapedSymbols(sizeof(T));
+    gabacify::mergeEscapedSymbols(decodedDigits, &mergedEscapedSymbols);
+    EXPECT_EQ(values, mergedEscapedSymbols.get<T>());
+}
+
+
+TEST_F(helpersTest, roundTripEscapedSymbols){
+    roundTripEscapedSymbols<uint8_t>({});
+    roundTripEscapedSymbols<uint8_t>({0, 255, 7});
+    roundTripEscapedSymbols<uint16_t>({65535, 3});
+    roundTripEscapedSymbols<uint32_t>({std::numeric_limits<uint32_t>::max(), 0});
+    roundTripEscapedSymbols<uint64_t>({});
+    roundTripEscapedSymbols<uint64_t>({
+            0,
+            1,
+            std::numeric_limits<uint32_t>::max(),
+            1ull << 32u,
+            0x0123456789abcdefull,
+            std::numeric_limits<uint64_t>::max()
+    });
+}
+
+
+TEST_F(helpersTest, mergeCorruptedEscapedSymbols){
+    gabac::SymbolStream escapedSymbols(8);
+    gabac::SymbolStream narrowEscapedSymbols(2);
+
+    // Odd number of 32-bit digits
+    EXPECT_THROW(gabacify::mergeEscapedSymbols({1, 2, 3}, &escapedSymbols), gabacify::RuntimeException);
+
+    // Digit too large for its width
+    EXPECT_THROW(gabacify::mergeEscapedSymbols({1ull << 32u, 0}, &escapedSymbols), gabacify::RuntimeException);
+    EXPECT_THROW(gabacify::mergeEscapedSymbols({65536}, &narrowEscapedSymbols), gabacify::RuntimeException);
+}